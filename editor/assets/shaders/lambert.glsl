@@ -6,18 +6,20 @@ layout(location = 1) in vec3 Normal;
 layout(location = 0) out vec3 fragPosition;
 layout(location = 1) out vec3 fragNormal;
 
-layout(push_constant) uniform PushConstants {
-	mat4 ModelMatrix;
-} constants;
-
 layout(set = 0, binding = 0) uniform CameraData {
 	uniform mat4 u_ViewProjectionMatrix;
 } cameraData;
 
+// Model matrices for every instance drawn this frame, firstInstance offsets into it per batch
+layout(std430, set = 0, binding = 2) readonly buffer InstanceData {
+	mat4 u_ModelMatrices[];
+} instanceData;
+
 void main() {
-	gl_Position = cameraData.u_ViewProjectionMatrix * constants.ModelMatrix * vec4(Position, 1);
-	fragPosition = vec3(constants.ModelMatrix * vec4(Position, 1.0));
-    fragNormal = mat3(transpose(inverse(constants.ModelMatrix))) * Normal;
+	mat4 modelMatrix = instanceData.u_ModelMatrices[gl_InstanceIndex];
+	gl_Position = cameraData.u_ViewProjectionMatrix * modelMatrix * vec4(Position, 1);
+	fragPosition = vec3(modelMatrix * vec4(Position, 1.0));
+    fragNormal = mat3(transpose(inverse(modelMatrix))) * Normal;
 }
 
 #type fragment
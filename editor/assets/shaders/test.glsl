@@ -5,16 +5,17 @@ layout(location = 0) in vec3 Position;
 
 layout(location = 0) out vec3 fragColor;
 
-layout(push_constant) uniform PushConstants {
-	mat4 ModelMatrix;
-} constants;
-
 layout(set = 0, binding = 0) uniform CameraData {
 	uniform mat4 u_ViewProjectionMatrix;
 } cameraData;
 
+layout(std430, set = 0, binding = 2) readonly buffer InstanceData {
+	mat4 u_ModelMatrices[];
+} instanceData;
+
 void main() {
-	gl_Position = cameraData.u_ViewProjectionMatrix * constants.ModelMatrix * vec4(Position, 1);
+	mat4 modelMatrix = instanceData.u_ModelMatrices[gl_InstanceIndex];
+	gl_Position = cameraData.u_ViewProjectionMatrix * modelMatrix * vec4(Position, 1);
 	fragColor = Position * 0.5 + 0.5;
 }
 
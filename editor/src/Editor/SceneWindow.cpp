@@ -28,8 +28,8 @@ namespace mistEditor {
 		sm->LoadEmptyScene();
 
 		sceneCameraEntity = sm->CreateEntity();
-		mist::Transform& sceneCameraT = sm->AddComponent<mist::Transform>(sceneCameraEntity, glm::vec3(0, 0, -5));
-		mist::Camera& sceneCamera = sm->AddComponent<mist::SceneCamera>(sceneCameraEntity, sceneCameraT);
+		sm->AddComponent<mist::Transform>(sceneCameraEntity, glm::vec3(0, 0, -5));
+		mist::Camera& sceneCamera = sm->AddComponent<mist::SceneCamera>(sceneCameraEntity);
 		sceneCamera.SetPerspectiveCamera(1280, 720);
 
 		// GAME
@@ -39,8 +39,8 @@ namespace mistEditor {
 		testMeshes = mist::Importer::ImportMeshes("assets/LightCycle.obj", true);
 		{
 			const entt::entity triEntity = sm->CreateEntity();
-			mist::Transform& testT = sm->AddComponent<mist::Transform>(triEntity, glm::vec3(-2, 0, 0), glm::quat_identity<float, glm::defaultp>(), glm::vec3(1.0f));
-			sm->AddComponent<mist::MeshRenderer>(triEntity, testT, testShader->GetName(), testMeshes[0]);
+			sm->AddComponent<mist::Transform>(triEntity, glm::vec3(-2, 0, 0), glm::quat_identity<float, glm::defaultp>(), glm::vec3(1.0f));
+			sm->AddComponent<mist::MeshRenderer>(triEntity, testShader->GetName(), testMeshes[0]);
 		}
 
 		std::vector<mist::Vertex> verts = {
@@ -59,18 +59,18 @@ namespace mistEditor {
 		testMesh->GenerateNormals();
 		{
 			const entt::entity triEntity = sm->CreateEntity();
-			mist::Transform& testT = sm->AddComponent<mist::Transform>(triEntity, glm::vec3(2, 0, 0));
-			sm->AddComponent<mist::MeshRenderer>(triEntity, testT, testShader->GetName(), testMesh);
+			sm->AddComponent<mist::Transform>(triEntity, glm::vec3(2, 0, 0));
+			sm->AddComponent<mist::MeshRenderer>(triEntity, testShader->GetName(), testMesh);
 		}
 
 		const entt::entity gameCameraEntity = sm->CreateEntity();
-		mist::Transform& gameCameraT = sm->AddComponent<mist::Transform>(gameCameraEntity, glm::vec3(0, 0, -5));
-		mist::Camera& gameCamera = sm->AddComponent<mist::Camera>(gameCameraEntity, sceneCameraT);
+		sm->AddComponent<mist::Transform>(gameCameraEntity, glm::vec3(0, 0, -5));
+		mist::Camera& gameCamera = sm->AddComponent<mist::Camera>(gameCameraEntity);
 		sceneCamera.SetPerspectiveCamera(1280, 720);
 
 		const entt::entity directionalLightEntity = sm->CreateEntity();
-		mist::Transform& directionalLightT = sm->AddComponent<mist::Transform>(directionalLightEntity, glm::vec3(0, 0, -5), glm::quat(glm::radians(glm::vec3(-45, 180, 0))));
-		mist::DirectionalLight& directionalLight = sm->AddComponent<mist::DirectionalLight>(directionalLightEntity, directionalLightT, glm::vec3(1,1,1));
+		sm->AddComponent<mist::Transform>(directionalLightEntity, glm::vec3(0, 0, -5), glm::quat(glm::radians(glm::vec3(-45, 180, 0))));
+		mist::DirectionalLight& directionalLight = sm->AddComponent<mist::DirectionalLight>(directionalLightEntity, glm::vec3(1,1,1));
 	}
 
 	void SceneWindow::Cleanup() {
@@ -82,12 +82,15 @@ namespace mistEditor {
 		mist::SceneManager* sm = mist::Application::Get().GetSceneManager();
 		float delta = mist::Application::Get().GetDeltaTime();
 
-		auto view = sm->GetActiveScene().view<mist::Transform, mist::MeshRenderer>();
-		view.each([delta](mist::Transform &transform, mist::MeshRenderer &render) {
-			transform.Rotate(glm::radians(30.0f) * delta, { 0, 1, 0 });
+		entt::registry& scene = sm->GetActiveScene();
+		auto group = sm->GetRenderGroup(sm->GetActiveSceneIndex());
+		group.each([&scene, delta](const entt::entity entity, mist::Transform &transform, mist::MeshRenderer &render) {
+			scene.patch<mist::Transform>(entity, [delta](mist::Transform& transform) {
+				transform.Rotate(glm::radians(30.0f) * delta, { 0, 1, 0 });
+			});
 		});
 
-		mist::Transform& transform = sm->GetComponent<mist::Transform>(sceneCameraEntity);
+		mist::Transform& transform = sm->PatchComponent<mist::Transform>(sceneCameraEntity);
 		glm::vec2 mouse;
 		uint32_t buttons = SDL_GetRelativeMouseState(&mouse.x, &mouse.y);
 		mouse *= 1.0;	// Sensitivity
@@ -140,14 +143,17 @@ namespace mistEditor {
 		ImGui::PopStyleVar();
 	}
 
+	mist::RenderGraphTexture SceneWindow::AddPasses(mist::RenderGraph& graph) {
+		const mist::RenderGraphTexture sceneColor = graph.ImportRenderData("Scene", renderData);
+		graph.AddPass("Scene").WriteColor(sceneColor).RecordInParallel().Execute([this]() { OnRender(); });
+		return sceneColor;
+	}
+
 	void SceneWindow::OnRender() {
-		mist::RenderAPI* renderAPI = mist::Application::Get().GetRenderAPI();
-		renderAPI->BeginRenderPass(renderData->GetRenderDataID());
 		mist::SceneManager* sm = mist::Application::Get().GetSceneManager();
 		mist::Camera& cam = dynamic_cast<mist::Camera&>(sm->GetComponent<mist::SceneCamera>(sceneCameraEntity));
-		sm->UpdateSceneCamera(cam, renderData->GetRenderDataID());
+		sm->UpdateSceneCamera(cam, sm->GetComponent<mist::Transform>(sceneCameraEntity), renderData->GetRenderDataID());
 		sm->SubmitActiveScene(renderData->GetRenderDataID());
-		renderAPI->EndRenderPass();
 	}
 
 	void SceneWindow::PostRender() {
@@ -4,6 +4,7 @@
 #include <renderer/Framebuffer.hpp>
 #include <renderer/Buffer.hpp>
 #include <renderer/Shader.hpp>
+#include <renderer/RenderGraph.hpp>
 #include <components/Camera.hpp>
 #include <imgui/ImguiLayer.hpp>
 #include <entt/entt.hpp>
@@ -16,6 +17,8 @@ namespace mistEditor {
 		void Initialize();
 		void OnEditorUpdate();
 		void OnImguiRender();
+		// Adds the pass drawing the scene, returns its color output for the passes that show it
+		mist::RenderGraphTexture AddPasses(mist::RenderGraph& graph);
 		void OnRender();
 		void PostRender();
 		void Cleanup();
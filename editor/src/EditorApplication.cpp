@@ -13,6 +13,7 @@
 
 void Run() {
     mist::Application editor = mist::Application("Editor");
+    editor.GetShaderLibrary()->EnableHotReload();
     mistEditor::EditorLayer* editorLayer = new mistEditor::EditorLayer();
     editor.PushLayer(editorLayer);
     editor.Run();
@@ -10,9 +10,19 @@ namespace mistEditor {
 	void EditorLayer::OnAttach() {
 		ImguiLayer::OnAttach();
 		sceneWindow.Initialize();
+
+		renderGraph = mist::RenderGraph::Create();
+		const mist::RenderGraphTexture sceneColor = sceneWindow.AddPasses(*renderGraph);
+		const mist::RenderGraphTexture swapchain = renderGraph->ImportRenderData("Swapchain", renderData);
+		renderGraph->AddPass("ImGui").Read(sceneColor).WriteColor(swapchain).Execute([this]() {
+			Begin();
+			OnImguiRender();
+			End();
+		});
 	}
 
 	void EditorLayer::OnDetach() {
+		renderGraph = nullptr;
 		sceneWindow.Cleanup();
 		ImguiLayer::OnDetach();
 	}
@@ -24,14 +34,7 @@ namespace mistEditor {
 	void EditorLayer::OnRender() {
 		mist::RenderAPI* api = mist::Application::Get().GetRenderAPI();
 		api->BeginFrame();
-
-		sceneWindow.OnRender();
-
-		api->BeginRenderPass(renderData->GetRenderDataID());
-		Begin();
-		OnImguiRender();
-		End();
-		api->EndRenderPass();
+		renderGraph->Execute();
 		api->EndFrame();
 
 		sceneWindow.PostRender();
@@ -1,5 +1,6 @@
 #pragma once
 #include <imgui/ImguiLayer.hpp>
+#include <renderer/RenderGraph.hpp>
 #include "Editor/SceneWindow.hpp"
 
 namespace mistEditor {
@@ -23,5 +24,6 @@ namespace mistEditor {
 		void SaveSceneAs();
 
 		SceneWindow sceneWindow;
+		mist::Scope<mist::RenderGraph> renderGraph;
 	};
 }
\ No newline at end of file
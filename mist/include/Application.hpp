@@ -4,8 +4,10 @@
 #include "LayerStack.hpp"
 #include "renderer/RenderAPI.hpp"
 #include "renderer/Shader.hpp"
+#include "renderer/GeometryPool.hpp"
 #include "SceneManager.hpp"
 #include "physics/Physics.hpp"
+#include "ThreadPool.hpp"
 
 namespace mist {
 	class Application {
@@ -29,7 +31,9 @@ namespace mist {
 		inline Window* GetWindow() { return window; }
 		inline const char* GetApplicationName() { return appName; }
 		inline ShaderLibrary* GetShaderLibrary() { return &shaderLib; }
+		inline GeometryPool* GetGeometryPool() { return geometryPool.get(); }
 		inline SceneManager* GetSceneManager() { return &sceneManager; }
+		inline ThreadPool* GetThreadPool() { return &threadPool; }
 	private:
 		static Application* instance;
 		const float maxDeltaTime = 0.05f;	// Stop weird issues if the game freezes, lags, etc.
@@ -41,7 +45,9 @@ namespace mist {
 		ShaderLibrary shaderLib;
 		Window* window;
 		RenderAPI* renderAPI;
+		Scope<GeometryPool> geometryPool;
 		SceneManager sceneManager;
 		Physics physics;
+		ThreadPool threadPool;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <type_traits>
+#include <entt/entt.hpp>
+#include "components/Transform.hpp"
+#include "components/MeshRenderer.hpp"
+#include "components/Collider.hpp"
+#include "components/DirectionalLight.hpp"
+
+namespace mist {
+	// Records which entities had a tracked component added or modified this frame. Modifications are only seen
+	// when they go through patch/replace (SceneManager::PatchComponent/ReplaceComponent), not through raw references
+	class ChangeTracker {
+	public:
+		void Connect(entt::registry& registry);
+		void Clear();
+
+		template<typename T>
+		inline const entt::sparse_set& GetDirty() const { return dirty[IndexOf<T>()]; }
+
+		template<typename T>
+		inline const bool IsDirty() const { return !dirty[IndexOf<T>()].empty(); }
+
+		template<typename T>
+		inline const bool IsDirty(const entt::entity entity) const { return dirty[IndexOf<T>()].contains(entity); }
+	private:
+		template<typename T>
+		static constexpr size_t IndexOf() {
+			if constexpr (std::is_same_v<T, Transform>)
+				return 0;
+			else if constexpr (std::is_same_v<T, MeshRenderer>)
+				return 1;
+			else if constexpr (std::is_same_v<T, Collider>)
+				return 2;
+			else {
+				static_assert(std::is_same_v<T, DirectionalLight>, "Component is not change tracked");
+				return 3;
+			}
+		}
+
+		template<typename T>
+		void OnChanged(entt::registry& registry, const entt::entity entity) {
+			entt::sparse_set& set = dirty[IndexOf<T>()];
+			if (!set.contains(entity))
+				set.push(entity);
+		}
+
+		template<typename T>
+		void OnDestroyed(entt::registry& registry, const entt::entity entity) {
+			dirty[IndexOf<T>()].remove(entity);
+		}
+
+		template<typename T>
+		void ConnectComponent(entt::registry& registry) {
+			registry.on_construct<T>().template connect<&ChangeTracker::OnChanged<T>>(*this);
+			registry.on_update<T>().template connect<&ChangeTracker::OnChanged<T>>(*this);
+			registry.on_destroy<T>().template connect<&ChangeTracker::OnDestroyed<T>>(*this);
+		}
+
+		std::array<entt::sparse_set, 4> dirty;
+	};
+}
\ No newline at end of file
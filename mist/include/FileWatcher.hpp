@@ -0,0 +1,19 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Core.hpp"
+
+namespace mist {
+	// Reports watched files that changed on disk. Linux listens through inotify, Windows polls write times
+	class FileWatcher {
+	public:
+		virtual ~FileWatcher() {}
+
+		virtual void Watch(const std::string& path) = 0;
+		// Files changed since the last call, in the form they were watched. Each is reported once however many
+		// times it was written
+		virtual std::vector<std::string> Poll() = 0;
+
+		static Scope<FileWatcher> Create();
+	};
+}
\ No newline at end of file
@@ -1,11 +1,16 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "Core.hpp"
 
 namespace mist {
 	class Utils {
 	public:
 		static std::string ReadFile(const std::string& path);
+		// Empty when the file does not exist, for caches that are allowed to be missing
+		static std::vector<uint8_t> ReadBinaryFile(const std::string& path);
+		// Written next to the target then renamed over it so a crash never leaves a half written file
+		static bool WriteBinaryFile(const std::string& path, const void* data, const size_t size);
 	};
 
 	class FileDialog {
@@ -1,8 +1,25 @@
 #pragma once
+#include <functional>
 #include <entt/entt.hpp>
+#include "components/Transform.hpp"
 #include "components/Camera.hpp"
+#include "components/MeshRenderer.hpp"
+#include "components/Rigidbody.hpp"
+#include "components/Collider.hpp"
+#include "data/Prefab.hpp"
+#include "physics/SpatialHashGrid.hpp"
+#include "ChangeTracker.hpp"
+#include "renderer/Frustum.hpp"
+#include "renderer/DrawList.hpp"
+#include "renderer/RenderAPI.hpp"
 
 namespace mist {
+	class Physics;
+	class ThreadPool;
+
+	// Runs on a worker thread, it must only touch the scene it is given and not the renderer
+	using SceneUpdateCallback = std::function<void(entt::registry& scene, const float delta)>;
+
 	class SceneManager {
 	public:
 		const entt::entity CreateEntity();
@@ -22,23 +39,94 @@ namespace mist {
 		T& GetComponent(const entt::entity entity) {
 			return loadedScenes[activeScene].get<T>(entity);
 		}
+
+		// Modify a component in place and record the change, use this over GetComponent for tracked components
+		template<typename T, typename ... Func>
+		T& PatchComponent(const entt::entity entity, Func&& ... funcs) {
+			return loadedScenes[activeScene].patch<T>(entity, std::forward<Func>(funcs)...);
+		}
+
+		template<typename T, typename ... Args>
+		T& ReplaceComponent(const entt::entity entity, Args&& ... args) {
+			return loadedScenes[activeScene].replace<T>(entity, std::forward<Args>(args)...);
+		}
 		
+		// Captures the entities into a prefab, the first entity is the root and the rest are stored relative to it
+		Ref<Prefab> CreatePrefab(const std::vector<entt::entity>& entities);
+		// Creates count copies of the prefab in the active scene, placed at transforms if given otherwise at the origin.
+		// Entities are returned grouped per prefab entity, so entity i of instance j is at [i * count + j]
+		std::vector<entt::entity> Instantiate(const Prefab& prefab, const size_t count, const std::vector<Transform>& transforms = {});
+
 		inline const int32_t GetActiveSceneIndex() { return activeScene; }
 		inline entt::registry& GetActiveScene() { return loadedScenes[activeScene]; }
+		inline entt::registry& GetScene(const int32_t sceneIndex) { return loadedScenes[sceneIndex]; }
+		inline const size_t GetSceneCount() const { return loadedScenes.size(); }
+
+		// Entities whose tracked components changed since the last ClearChanges
+		inline ChangeTracker& GetChangeTracker(const int32_t sceneIndex) { return *changeTrackers[sceneIndex]; }
+		// Called at the end of each frame once every system has consumed the changes
+		void ClearChanges();
+
+		// Spatial index over every entity with a Transform, kept in sync at the end of each scene update
+		inline SpatialHashGrid& GetSpatialIndex(const int32_t sceneIndex) { return *spatialIndices[sceneIndex]; }
+		void UpdateSpatialIndex(const int32_t sceneIndex);
+
+		// Live scenes are updated every frame alongside the active scene, each on its own worker
+		void SetSceneLive(const int32_t sceneIndex, const bool live);
+		inline const bool IsSceneLive(const int32_t sceneIndex) const { return liveScenes[sceneIndex]; }
+		void SetSceneUpdate(const int32_t sceneIndex, SceneUpdateCallback callback);
+		// Runs the update callback and physics tick for the active and live scenes in parallel, returns once all are done
+		void UpdateScenes(Physics& physics, ThreadPool& threadPool, const float delta);
+
+		// Render group owns Transform so the render loop walks both arrays in lockstep, EnTT only allows
+		// a component to be owned by one group so physics observes Transform instead of owning it
+		inline auto GetRenderGroup(const int32_t sceneIndex) { return loadedScenes[sceneIndex].group<Transform, MeshRenderer>(); }
+		inline auto GetPhysicsGroup(const int32_t sceneIndex) { return loadedScenes[sceneIndex].group<Rigidbody, Collider>(entt::get<Transform>); }
 
 		inline void SubmitActiveScene(const uint8_t renderDataID) { SubmitScene(renderDataID, activeScene); }
+		// Draws are split into recording jobs of at least MIN_DRAWS_PER_RECORDING_JOB, they only run
+		// in parallel when the render pass was begun for parallel recording
 		void SubmitScene(const uint8_t renderDataID, const int32_t sceneIndex);
 
-		void UpdateSceneCamera(const Camera& camera, const uint8_t renderDataID);
-		void UpdateSceneCamera(const uint8_t renderDataID);
+		// Rebuilds the view from the transform on every call rather than detecting changes, so a moved camera is never missed
+		void UpdateSceneCamera(const Camera& camera, const Transform& transform, const uint8_t renderDataID);
+		inline void UpdateSceneCamera(const uint8_t renderDataID) { UpdateSceneCamera(renderDataID, activeScene); }
+		void UpdateSceneCamera(const uint8_t renderDataID, const int32_t sceneIndex);
 
 		void LoadEmptyScene();
 		void LoadScene();
 		void SetActiveScene(const int32_t sceneIndex);
 
 		void Cleanup();
+
+		static constexpr size_t MIN_DRAWS_PER_RECORDING_JOB = 1024;
 	private:
+		// Consecutive draw commands recorded under one bind, indirect runs share a pipeline while direct runs are one batch
+		struct DrawRun {
+			uint32_t firstBatch;
+			uint32_t batchCount;
+		};
+
 		int32_t activeScene = -1;
 		std::vector<entt::registry> loadedScenes;
+		std::vector<bool> liveScenes;
+		std::vector<SceneUpdateCallback> sceneUpdates;
+		std::vector<Scope<SpatialHashGrid>> spatialIndices;
+		std::vector<Scope<ChangeTracker>> changeTrackers;
+
+		// Culling state, frustums and positions are captured per render data when its camera is updated
+		std::unordered_map<uint8_t, Frustum> cameraFrustums;
+		std::unordered_map<uint8_t, glm::vec3> cameraPositions;
+		BoundingSphereBatch cullSpheres;
+		std::vector<uint8_t> cullVisible;
+
+		// Batching state, visible renderers are sorted so ones sharing a shader and mesh become one instanced draw
+		std::vector<const MeshRenderer*> visibleRenderers;
+		std::vector<glm::mat4> visibleMatrices;
+		DrawList drawList;
+		std::vector<glm::mat4> instanceMatrices;
+		std::vector<IndexedDrawCommand> drawCommands;
+		std::vector<const MeshRenderer*> batchRenderers;	// Renderer each draw command was built from
+		std::vector<DrawRun> drawRuns;	// Only runs whose pipeline is ready
 	};
 }
\ No newline at end of file
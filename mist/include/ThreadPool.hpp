@@ -0,0 +1,46 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace mist {
+	class ThreadPool {
+	public:
+		ThreadPool(size_t threadCount = 0);	// 0 picks one thread per core minus the main thread
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		template<typename Func>
+		std::future<std::invoke_result_t<Func>> Submit(Func&& func) {
+			using Result = std::invoke_result_t<Func>;
+			// std::function needs a copyable target so the task is shared rather than moved in
+			auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+			std::future<Result> future = task->get_future();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.emplace([task]() { (*task)(); });
+			}
+
+			condition.notify_one();
+			return future;
+		}
+
+		inline size_t GetThreadCount() const { return workers.size(); }
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> tasks;
+		std::mutex mutex;
+		std::condition_variable condition;
+		bool stopping = false;
+	};
+}
\ No newline at end of file
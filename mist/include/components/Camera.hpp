@@ -7,16 +7,19 @@ namespace mist {
 	public:
 		enum ProjectionType { Perspective = 0, Orthographic = 1 };
 	public:
-		Camera(Transform& transform);
+		Camera();
 		virtual ~Camera();
 
+		// Projection state only, the view comes from the entity's Transform which the camera no longer holds
 		bool IsEqual(const Camera& other) const;
+		// Also compares the view, which is what a camera compared before its transform was passed in
+		bool IsEqual(const Camera& other, const Transform& transform, const Transform& otherTransform) const;
 
 		void RecreateCamera();
 
 		glm::mat4 GetProjectionMatrix() const;
-		glm::mat4 GetViewMatrix() const;
-		glm::mat4 GetViewProjectionMatrix() const;
+		glm::mat4 GetViewMatrix(const Transform& transform) const;
+		glm::mat4 GetViewProjectionMatrix(const Transform& transform) const;
 		
 		ProjectionType GetProjectionType() const { return type; }
 		void SetProjectionType(ProjectionType value) { type = value; RecreateCamera(); };
@@ -26,9 +29,6 @@ namespace mist {
 		float GetCameraWidth() const { return width; }
 		float GetCameraHeight() const { return height; }
 
-		inline void SetTransform(Transform& value) { transformComponent = value; }
-		inline Transform& GetTransform() const { return transformComponent; }
-
 		// ORTHOGRAPHIC
 		void SetOrthographicCamera(const float width, const float height, const float size = 10, const float nearPlane = -1, const float farPlane = 1);
 		
@@ -61,7 +61,6 @@ namespace mist {
 		// General camera
 		ProjectionType type;
 		glm::mat4 projectionMatrix;
-		Transform& transformComponent;
 
 		float width;
 		float height;
@@ -78,6 +77,6 @@ namespace mist {
 
 	class SceneCamera : public Camera {
 	public:
-		SceneCamera(Transform& transform);
+		SceneCamera();
 	};
 }
\ No newline at end of file
@@ -4,13 +4,8 @@
 namespace mist {
 	struct DirectionalLight {
 	public:
-		DirectionalLight(Transform& transform, const glm::vec3 lightColor) : transformComponent(transform), lightColor(lightColor) {}
-
-		inline void SetTransform(Transform& value) { transformComponent = value; }
-		inline Transform& GetTransform() const { return transformComponent; }
+		DirectionalLight(const glm::vec3 lightColor) : lightColor(lightColor) {}
 
 		glm::vec3 lightColor;
-	private:
-		Transform& transformComponent;
 	};
 }
\ No newline at end of file
@@ -1,28 +1,28 @@
 #pragma once
 #include <string>
 #include "data/Mesh.hpp"
-#include "renderer/Buffer.hpp"
+#include "renderer/GeometryPool.hpp"
+#include "renderer/Shader.hpp"
 #include "components/Transform.hpp"
 
 namespace mist {
     class MeshRenderer {
     public:
-        MeshRenderer(Transform& transform, std::string shaderName, Ref<Mesh> mesh);
-        ~MeshRenderer();
+        MeshRenderer(std::string shaderName, Ref<Mesh> mesh, ShaderVariantKey variantKey = 0);
 
-        void Bind(const uint8_t renderDataID);
-        void Draw();
+        void Bind(const uint8_t renderDataID) const;
+        // Model matrices come from the instance data uploaded through RenderAPI::UploadInstances
+        void Draw(const uint32_t instanceCount = 1, const uint32_t firstInstance = 0) const;
         void Apply();
         void Clear();
 
-        inline void SetTransform(Transform& value) { transformComponent = value; }
-		inline Transform& GetTransform() const { return transformComponent; }
-
         std::string shaderName; // TODO: this will be changed when doing materials properly
+        ShaderVariantKey variantKey = 0;    // Keywords enabled on the shader, each key is its own pipeline
         Ref<Mesh> mesh;
-        Ref<VertexBuffer> vBuffer;
-        Ref<IndexBuffer> iBuffer;
-    private:
-        Transform& transformComponent;
+        Ref<GeometryRange> geometry;    // Shared by every renderer using the same mesh
+
+        // Integer ids used for draw sorting, Apply must be called after changing shaderName, variantKey or mesh
+        uint32_t meshID = 0;
+        ShaderHandle shaderHandle = INVALID_SHADER_HANDLE;   // Resolved from shaderName and variantKey on first submit
     };
 }
\ No newline at end of file
@@ -12,9 +12,18 @@ namespace mist {
         std::vector<Vertex> vertices;
         std::vector<uint32_t> indices;
 
+        // Local space bounds, kept up to date by RecalculateBounds which the constructor calls
+        glm::vec3 boundsMin = glm::vec3(0);
+        glm::vec3 boundsMax = glm::vec3(0);
+        glm::vec3 boundsCenter = glm::vec3(0);
+        float boundsRadius = 0;
+        // Bumped by GenerateNormals and RecalculateBounds, renderers upload the mesh again on their next Apply once it changes
+        uint32_t revision = 0;
+
         Mesh();
         Mesh(const std::vector<Vertex>& _vertices, const std::vector<uint32_t>& _indices);
 
         void GenerateNormals();
+        void RecalculateBounds();
     };
 }
\ No newline at end of file
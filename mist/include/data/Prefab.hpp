@@ -0,0 +1,34 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <vector>
+#include "Core.hpp"
+#include "data/Mesh.hpp"
+#include "renderer/Shader.hpp"
+#include "components/Transform.hpp"
+#include "components/Rigidbody.hpp"
+#include "components/Collider.hpp"
+#include "components/DirectionalLight.hpp"
+
+namespace mist {
+	struct PrefabMeshRenderer {
+		std::string shaderName;
+		Ref<Mesh> mesh;
+		ShaderVariantKey variantKey = 0;
+	};
+
+	// A single entity in a prefab, the transform is relative to the prefab root
+	struct PrefabEntity {
+		Transform transform;
+		std::optional<PrefabMeshRenderer> meshRenderer;
+		std::optional<Rigidbody> rigidbody;
+		std::optional<Collider> collider;
+		std::optional<DirectionalLight> directionalLight;
+	};
+
+	// Captured set of entities and their components that can be stamped out many times with SceneManager::Instantiate
+	struct Prefab {
+		std::string name;
+		std::vector<PrefabEntity> entities;
+	};
+}
\ No newline at end of file
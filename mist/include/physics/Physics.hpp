@@ -8,6 +8,6 @@ namespace mist {
 	class Physics {
 	public:
 		IntersectData DetectCollision(const Transform& transformA, const Collider& colliderA, const Transform& transformB, const Collider& colliderB);
-		void Simulate(const float delta);
+		void Simulate(const int32_t sceneIndex, const float delta);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <entt/entt.hpp>
+#include "Math.hpp"
+
+namespace mist {
+	// Uniform hash grid over entity positions, only entities that change cell are moved between buckets
+	class SpatialHashGrid {
+	public:
+		SpatialHashGrid(const float cellSize = 4.0f);
+
+		void Insert(const entt::entity entity, const glm::vec3 position);
+		void Update(const entt::entity entity, const glm::vec3 position);
+		void Remove(const entt::entity entity);
+		void Clear();
+
+		inline const bool Contains(const entt::entity entity) const { return locations.contains(entity); }
+		inline const size_t GetEntityCount() const { return locations.size(); }
+		inline const float GetCellSize() const { return cellSize; }
+
+		// Queries append to results so callers can reuse the vector between queries
+		void QueryRadius(const glm::vec3 center, const float radius, std::vector<entt::entity>& results) const;
+		void QueryAABB(const glm::vec3 min, const glm::vec3 max, std::vector<entt::entity>& results) const;
+		// Results are ordered nearest first
+		void QueryKNearest(const glm::vec3 center, const size_t k, std::vector<entt::entity>& results) const;
+	private:
+		// Cell coordinates are clamped to this so casts stay defined and cell ranges never overflow when multiplied out,
+		// anything further out shares the edge cells and is still filtered by its exact position
+		static constexpr int32_t MAX_CELL_COORDINATE = 1 << 20;
+
+		struct CellKey {
+			int32_t x, y, z;
+			bool operator==(const CellKey& other) const = default;
+		};
+
+		struct CellKeyHash {
+			size_t operator()(const CellKey& key) const {
+				return (static_cast<size_t>(key.x) * 73856093) ^ (static_cast<size_t>(key.y) * 19349663) ^ (static_cast<size_t>(key.z) * 83492791);
+			}
+		};
+
+		struct CellEntry {
+			entt::entity entity;
+			glm::vec3 position;
+		};
+
+		struct EntityLocation {
+			CellKey cell;
+			uint32_t index;
+		};
+
+		CellKey GetCell(const glm::vec3 position) const;
+		void AddToCell(const entt::entity entity, const glm::vec3 position, const CellKey cell);
+		void RemoveFromCell(const EntityLocation location);
+		const size_t GetCellCount(const CellKey min, const CellKey max) const;
+
+		float cellSize;
+		float inverseCellSize;
+		std::unordered_map<CellKey, std::vector<CellEntry>, CellKeyHash> cells;
+		std::unordered_map<entt::entity, EntityLocation> locations;
+	};
+}
\ No newline at end of file
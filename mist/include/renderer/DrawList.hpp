@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mist {
+	// Draws sorted by a packed 64 bit key so state changes only happen when the key prefix changes
+	// | pipeline 16 | mesh 24 | depth 24 |, the descriptor set is picked by pipeline and mesh so it shares their bits
+	class DrawList {
+	public:
+		static constexpr uint64_t PIPELINE_BITS = 16;
+		static constexpr uint64_t MESH_BITS = 24;
+		static constexpr uint64_t DEPTH_BITS = 24;
+
+		// Depth must be positive, its float bits are used directly as they sort the same as the value
+		static uint64_t MakeKey(const uint32_t pipeline, const uint32_t mesh, const float depth);
+		static inline const uint32_t GetPipeline(const uint64_t key) { return static_cast<uint32_t>(key >> (MESH_BITS + DEPTH_BITS)); }
+		static inline const uint32_t GetMesh(const uint64_t key) { return static_cast<uint32_t>((key >> DEPTH_BITS) & ((1ull << MESH_BITS) - 1)); }
+		// Draws with the same batch key can go in one instanced draw
+		static inline const uint64_t GetBatch(const uint64_t key) { return key >> DEPTH_BITS; }
+
+		void Clear();
+		void Reserve(const size_t count);
+		void Add(const uint64_t key, const uint32_t index);
+		// LSD radix sort on bytes, stable so equal keys keep the order they were added in
+		void Sort();
+
+		inline const size_t Size() const { return keys.size(); }
+		inline const uint64_t GetKey(const size_t i) const { return keys[i]; }
+		inline const uint32_t GetIndex(const size_t i) const { return indices[i]; }
+	private:
+		std::vector<uint64_t> keys;
+		std::vector<uint32_t> indices;
+		std::vector<uint64_t> scratchKeys;
+		std::vector<uint32_t> scratchIndices;
+	};
+}
\ No newline at end of file
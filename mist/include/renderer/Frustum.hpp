@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include "Math.hpp"
+
+namespace mist {
+	// Bounding spheres stored as separate arrays so the cull loop runs over packed floats
+	struct BoundingSphereBatch {
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+		std::vector<float> radius;
+
+		void Clear();
+		void Reserve(const size_t count);
+		void Add(const glm::vec3 center, const float radius);
+		inline const size_t Size() const { return radius.size(); }
+	};
+
+	class Frustum {
+	public:
+		Frustum() = default;
+		// Planes are extracted for a zero to one depth range to match the projection used by Camera
+		Frustum(const glm::mat4& viewProjection);
+
+		bool IntersectsSphere(const glm::vec3 center, const float radius) const;
+		bool IntersectsAABB(const glm::vec3 min, const glm::vec3 max) const;
+		// Writes 1 for every sphere at least partially inside the frustum and 0 otherwise, returns the visible count
+		size_t CullSpheres(const BoundingSphereBatch& spheres, std::vector<uint8_t>& visible) const;
+
+		glm::vec4 planes[6];	// xyz normal pointing inwards, w distance
+	};
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+#include "Core.hpp"
+#include "data/Mesh.hpp"
+
+namespace mist {
+	// Where a mesh lives inside the pool, offsets are in vertices and indices rather than bytes
+	struct GeometryRange {
+		uint32_t vertexOffset = 0;
+		uint32_t vertexCount = 0;
+		uint32_t firstIndex = 0;
+		uint32_t indexCount = 0;
+	};
+
+	// Every mesh is suballocated from one vertex and one index buffer, so they are bound once
+	// and draws only differ by the range they read
+	class GeometryPool {
+	public:
+		virtual ~GeometryPool() {}
+
+		virtual GeometryRange Upload(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) = 0;
+		virtual void Free(const GeometryRange& range) = 0;
+		virtual void Bind() const = 0;
+		virtual void Clear() = 0;
+
+		static Scope<GeometryPool> Create();
+	};
+}
\ No newline at end of file
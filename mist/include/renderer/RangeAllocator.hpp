@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mist {
+	// First fit free list over [0, capacity), freed blocks merge with their neighbours so the list stays short.
+	// Units are whatever the owner chooses, the geometry pool uses vertices and indices
+	class RangeAllocator {
+	public:
+		static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+		RangeAllocator(const uint32_t capacity = 0);
+
+		// Returns INVALID_OFFSET when no free block is large enough
+		uint32_t Allocate(const uint32_t size);
+		void Free(const uint32_t offset, const uint32_t size);
+		// Extends the range, allocations keep their offsets
+		void Grow(const uint32_t newCapacity);
+
+		inline const uint32_t GetCapacity() const { return capacity; }
+		inline const uint32_t GetUsed() const { return used; }
+		inline const size_t GetFreeBlockCount() const { return freeBlocks.size(); }
+	private:
+		struct Block {
+			uint32_t offset;
+			uint32_t size;
+		};
+
+		std::vector<Block> freeBlocks;	// Sorted by offset
+		uint32_t capacity = 0;
+		uint32_t used = 0;
+	};
+}
\ No newline at end of file
@@ -1,4 +1,6 @@
 #pragma once
+#include <vector>
+#include <functional>
 #include <Math.hpp>
 #include "Core.hpp"
 #include "renderer/Buffer.hpp"
@@ -8,10 +10,20 @@
 #include "Framebuffer.hpp"
 
 namespace mist {
+	// Same layout as VkDrawIndexedIndirectCommand so it can be copied straight into an indirect buffer
+	struct IndexedDrawCommand {
+		uint32_t indexCount;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t vertexOffset;
+		uint32_t firstInstance;
+	};
+
 	class RenderAPI {
 	public:
 		enum API { None, Vulkan };
 		enum VSYNC { Off, On, TripleBuffer };
+		enum DrawMode { Direct, Indirect };
 
 		virtual ~RenderAPI() {}
 
@@ -24,16 +36,33 @@ namespace mist {
 		virtual void WaitForIdle() = 0;
 		virtual void BeginFrame() = 0;
 		virtual void EndFrame() = 0;
-		virtual void BeginRenderPass(const uint8_t renderDataID) = 0;
+		// Passes begun for parallel recording can only be filled through RecordParallel
+		virtual void BeginRenderPass(const uint8_t renderDataID, const bool parallelRecording = false) = 0;
+		// Calls record once per job, spread over the thread pool with each job in its own command buffer, and plays
+		// them back in job order. In a pass not begun for parallel recording the jobs just run in order on this thread
+		virtual void RecordParallel(const uint8_t renderDataID, const uint32_t jobCount, const std::function<void(const uint32_t job)>& record) = 0;
 		virtual void EndRenderPass() = 0;
-		virtual void UpdateDirectionalLight(const uint8_t renderDataID, const DirectionalLight& light) = 0;
-		virtual void UpdateCamera(const uint8_t renderDataID, const Camera& camera) = 0;
+		// Changed should be false when neither the light nor its transform changed since the last call, the light data is then
+		// reused rather than rebuilt. It is still copied into every frame as the uniform arena starts each frame empty
+		virtual void UpdateDirectionalLight(const uint8_t renderDataID, const Transform& transform, const DirectionalLight& light, const bool changed) = 0;
+		virtual void UpdateCamera(const uint8_t renderDataID, const Transform& transform, const Camera& camera) = 0;
+		// Uploads model matrices for this frame, returns the firstInstance to pass to Draw for the first of them
+		virtual uint32_t UploadInstances(const uint8_t renderDataID, const std::vector<glm::mat4>& modelMatrices) = 0;
+		// Binds the descriptors for the renderer's shader, geometry comes from the pool bound through GeometryPool::Bind
 		virtual void BindMeshRenderer(const uint8_t renderDataID, const MeshRenderer& meshRenderer) = 0;
-		virtual void Draw(uint32_t indexCount) = 0;
+		virtual void Draw(const IndexedDrawCommand& command) = 0;
+		// Uploads this frame's draw commands, returns the index of the first for DrawIndirect
+		virtual uint32_t UploadDrawCommands(const uint8_t renderDataID, const std::vector<IndexedDrawCommand>& commands) = 0;
+		// Draws commandCount uploaded commands with the currently bound pipeline and buffers
+		virtual void DrawIndirect(const uint8_t renderDataID, const uint32_t firstCommand, const uint32_t commandCount) = 0;
 
 		virtual API GetAPI() = 0;
 
 		virtual void SetVsyncMode(RenderAPI::VSYNC newMode) = 0;
 		virtual VSYNC GetVsyncMode() = 0;
+
+		// Indirect records one draw per pipeline instead of one per batch, falls back to direct when the device cannot
+		virtual void SetDrawMode(RenderAPI::DrawMode newMode) = 0;
+		virtual DrawMode GetDrawMode() = 0;
 	};
 }
\ No newline at end of file
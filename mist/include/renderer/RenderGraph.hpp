@@ -0,0 +1,138 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+#include "Core.hpp"
+#include "renderer/Framebuffer.hpp"
+
+namespace mist {
+	using RenderGraphTexture = uint32_t;
+
+	// How a pass touches a texture, backends map each to the layout, stages and access it needs
+	enum class RenderGraphAccess {
+		None,				// Untouched so far this frame, the contents are undefined
+		ColorAttachment,
+		DepthAttachment,
+		ShaderRead,
+	};
+
+	struct RenderGraphTextureDesc {
+		uint32_t width = 1, height = 1;
+		FramebufferTextureFormat format = FramebufferTextureFormat::None;
+	};
+
+	// Issued before the pass it belongs to so everything earlier that touched the texture is done with it
+	struct RenderGraphBarrier {
+		RenderGraphTexture texture;
+		RenderGraphAccess before;
+		RenderGraphAccess after;
+	};
+
+	// Only textures whose masks overlap can share memory, backends use it for the memory types an image allows
+	struct RenderGraphMemoryRequirements {
+		uint64_t size = 0;
+		uint32_t compatibleMask = UINT32_MAX;
+	};
+
+	struct RenderGraphAliasing {
+		std::vector<uint32_t> textureBlocks;	// [texture] = block it lives in, INVALID_BLOCK for imported or unused textures
+		std::vector<RenderGraphMemoryRequirements> blocks;
+
+		static constexpr uint32_t INVALID_BLOCK = UINT32_MAX;
+	};
+
+	// Passes run in the order they were added. Each declares the textures it reads and writes, from which the graph
+	// culls passes nothing uses unless they have side effects, works out the barriers between them and lets transient textures share memory
+	class RenderGraph {
+	public:
+		using ExecuteFunc = std::function<void()>;
+
+		class PassBuilder {
+		public:
+			PassBuilder& Read(const RenderGraphTexture texture);
+			// Clearing discards what earlier passes wrote, otherwise the attachment is loaded and they are kept
+			PassBuilder& WriteColor(const RenderGraphTexture texture, const bool clear = true);
+			PassBuilder& WriteDepth(const RenderGraphTexture texture, const bool clear = true);
+			// Only for passes writing an imported render data, see RenderAPI::BeginRenderPass
+			PassBuilder& RecordInParallel();
+			// Never culled, for passes whose results leave the graph some other way such as readbacks or buffer writes
+			PassBuilder& HasSideEffects();
+			// Runs inside the render pass for the pass's attachments, or outside any pass when it writes none
+			PassBuilder& Execute(ExecuteFunc func);
+
+			inline const uint32_t GetIndex() const { return pass; }
+		private:
+			friend class RenderGraph;
+			PassBuilder(RenderGraph& graph, const uint32_t pass) : graph(graph), pass(pass) {}
+
+			PassBuilder& Write(const RenderGraphTexture texture, const RenderGraphAccess access, const bool clear);
+
+			RenderGraph& graph;
+			uint32_t pass;
+		};
+
+		virtual ~RenderGraph() {}
+
+		// Transient textures only live inside the graph, those whose lifetimes never overlap share memory
+		RenderGraphTexture CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc);
+		void ResizeTexture(const RenderGraphTexture texture, const uint32_t width, const uint32_t height);
+		// The render data's attachments are drawn with its own render pass. Its result leaves the graph so passes
+		// writing it are never culled
+		RenderGraphTexture ImportRenderData(const std::string& name, const Ref<RenderData>& renderData);
+
+		PassBuilder AddPass(const std::string& name);
+
+		// Culls passes, works out barriers and lifetimes then lets the backend place transients. Execute calls it
+		// whenever something changed since the last compile
+		void Compile();
+		virtual void Execute() = 0;
+
+		// Greedily packs transients into blocks, a block is reused once the texture in it is last used by an earlier pass
+		RenderGraphAliasing AssignAliases(const std::vector<RenderGraphMemoryRequirements>& requirements) const;
+
+		inline const size_t GetPassCount() const { return passes.size(); }
+		inline const bool IsPassCulled(const uint32_t pass) const { return passes[pass].culled; }
+		inline const std::vector<RenderGraphBarrier>& GetPassBarriers(const uint32_t pass) const { return passes[pass].barriers; }
+
+		static Scope<RenderGraph> Create();
+	protected:
+		struct TextureNode {
+			std::string name;
+			RenderGraphTextureDesc desc;
+			Ref<RenderData> renderData;		// Only set for imported textures
+			uint32_t firstPass = UINT32_MAX;	// Lifetime over the passes left after culling
+			uint32_t lastPass = 0;
+
+			inline const bool IsImported() const { return renderData != nullptr; }
+			inline const bool IsUsed() const { return firstPass != UINT32_MAX; }
+		};
+
+		struct TextureAccess {
+			RenderGraphTexture texture;
+			RenderGraphAccess access;
+			bool clear = false;
+		};
+
+		struct PassNode {
+			std::string name;
+			std::vector<TextureAccess> reads;
+			std::vector<TextureAccess> writes;
+			ExecuteFunc execute;
+			Ref<RenderData> renderData;		// Render data whose pass this records into, null when its attachments are transient
+			bool parallelRecording = false;
+			bool sideEffects = false;
+			bool culled = false;
+			std::vector<RenderGraphBarrier> barriers;
+		};
+
+		// Called at the end of Compile for the backend to recreate whatever depends on the transients
+		virtual void OnCompile() = 0;
+
+		std::vector<TextureNode> textures;
+		std::vector<PassNode> passes;
+		bool compiled = false;
+	private:
+		void CullPasses();
+		void BuildBarriers();
+	};
+}
\ No newline at end of file
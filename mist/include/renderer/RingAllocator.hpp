@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace mist {
+	// Ring over [0, capacity) where ranges are handed out in order and grouped into submissions. Submissions are
+	// retired oldest first, so one that completes early can never free space an older pending one still uses
+	class RingAllocator {
+	public:
+		static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+		RingAllocator(const uint64_t capacity = 0);
+
+		// Returns INVALID_OFFSET when the space left before the oldest pending submission is too small
+		uint64_t Allocate(const uint64_t size);
+		// Groups everything allocated since the last submit under value, values must increase
+		void Submit(const uint64_t value);
+		// Frees every submission up to and including value, which must all have completed
+		void Retire(const uint64_t value);
+		// Drops every allocation, only safe once nothing is reading any of them
+		void Reset(const uint64_t newCapacity);
+
+		inline const uint64_t GetCapacity() const { return capacity; }
+		inline const size_t GetPendingCount() const { return submissions.size(); }
+	private:
+		struct Submission {
+			uint64_t value;
+			uint64_t end;	// Head when submitted, everything before it is free once the submission retires
+		};
+
+		std::deque<Submission> submissions;	// Oldest first
+		uint64_t capacity = 0;
+		uint64_t head = 0;
+		uint64_t tail = 0;
+	};
+}
\ No newline at end of file
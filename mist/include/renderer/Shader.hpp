@@ -2,26 +2,56 @@
 #include <string>
 #include <Math.hpp>
 #include <unordered_map>
+#include <vector>
+#include <future>
 #include "Core.hpp"
+#include "FileWatcher.hpp"
 
 namespace mist {
+	class ThreadPool;
+
+	// Bit i enables the shader's i-th keyword, variants are looked up by this rather than by name
+	using ShaderVariantKey = uint64_t;
+
 	class Shader {
 	public:
 		virtual ~Shader() {}
 
 		virtual void Clear() = 0;
 
-		virtual void Bind(const uint8_t renderDataId) const = 0;
+		// Queues the pipeline build if there is none yet, returns true once Bind can record it. Binding a prepared
+		// shader never changes state so it is safe from recording workers
+		virtual bool Prepare(const uint8_t renderDataId) const = 0;
+		// False while the pipeline is still being built, the caller should skip the draws that needed it
+		virtual bool Bind(const uint8_t renderDataId) const = 0;
 		virtual void Unbind(const uint8_t renderDataId) const = 0;
 
 		virtual void SetUniformData(const uint8_t renderDataId, const std::string& name, const int size, const void* value) = 0;
 
 		virtual const std::string& GetName() const = 0;
+		// Empty for shaders built from inline sources
+		virtual const std::string& GetSourcePath() const = 0;
+
+		// Bits of the keys that map to a declared keyword, anything outside it picks the same variant
+		virtual ShaderVariantKey GetVariantMask() const = 0;
+		virtual ShaderVariantKey GetVariantKey() const = 0;
+		virtual Ref<Shader> CreateVariant(const ShaderVariantKey key) const = 0;
+
+		// Compiles the source again into a new shader, safe to call off the main thread. Null when compiling failed
+		virtual Ref<Shader> Recompile() const = 0;
+		// Takes over a recompiled shader's code on the main thread, pipelines built from the old code are dropped
+		virtual void ReplaceWith(Shader& reloaded) = 0;
 
 		static Ref<Shader> Create(const std::string& path);
 		static Ref<Shader> Create(const std::string& name, const std::string& vertexSrc, const std::string& fragmentSrc);
+		// Compiles on the pool and blocks until every shader is done, failed shaders come back null
+		static std::vector<Ref<Shader>> CreateBatch(const std::vector<std::string>& paths, ThreadPool& threadPool);
 	};
 
+	// Index of a shader in the library, stays valid for the library's lifetime so hot paths can skip the name lookup
+	using ShaderHandle = uint32_t;
+	static constexpr ShaderHandle INVALID_SHADER_HANDLE = UINT32_MAX;
+
 	class ShaderLibrary {
 	public:
 		void Add(const Ref<Shader>& shader);
@@ -29,12 +59,42 @@ namespace mist {
 
 		Ref<Shader> Load(const std::string& path);
 		Ref<Shader> Load(const std::string& name, const std::string& path);
+		// Compiles every shader and stage across the application's thread pool, shaders are added once they
+		// have all finished and are returned in the order of paths
+		std::vector<Ref<Shader>> LoadBatch(const std::vector<std::string>& paths);
 
 		Ref<Shader> Get(const std::string& name);
+		inline const Ref<Shader>& Get(const ShaderHandle handle) const { return handleShaders[handle]; }
+		ShaderHandle GetHandle(const std::string& name) const;
+		// Only the variants asked for are ever compiled, the first request for a key builds it and later ones reuse it
+		ShaderHandle GetVariant(const ShaderHandle base, const ShaderVariantKey key);
 		const std::unordered_map<std::string, Ref<Shader>> GetAllShaders() const { return shaders; }
 
 		bool Exists(const std::string& name) const;
+
+		// Watches the source of every loaded shader and recompiles it in the background when it changes,
+		// handles and references stay valid as shaders are updated in place
+		void EnableHotReload();
+		// Waits for reloads still compiling, must run before the render API shuts down
+		void DisableHotReload();
+		// Swaps in reloads that finished compiling, called between frames
+		void Update();
 	private:
+		struct PendingReload {
+			std::vector<ShaderHandle> handles;
+			std::vector<uint64_t> generations;	// Per handle, reloads can finish out of order so stale ones are dropped
+			std::future<std::vector<Ref<Shader>>> shaders;
+		};
+
+		void WatchSource(const Ref<Shader>& shader);
+
 		std::unordered_map<std::string, Ref<Shader>> shaders;
+		std::unordered_map<std::string, ShaderHandle> handles;
+		std::vector<Ref<Shader>> handleShaders;
+		std::unordered_map<ShaderHandle, std::unordered_map<ShaderVariantKey, ShaderHandle>> variantHandles;
+		Scope<FileWatcher> sourceWatcher;
+		std::vector<PendingReload> pendingReloads;
+		std::vector<uint64_t> issuedGenerations;	// [handle] = generation of its newest reload
+		std::vector<uint64_t> appliedGenerations;	// [handle] = generation currently swapped in
 	};
 }
\ No newline at end of file
@@ -23,12 +23,15 @@ namespace mist {
 		SDL_Init(SDL_INIT_VIDEO);
 		window = Window::Create(WindowProperties(name));
 		renderAPI->Initialize();
+		geometryPool = GeometryPool::Create();
 	}
 
 	Application::~Application() {
+		shaderLib.DisableHotReload();
 		renderAPI->WaitForIdle();
 		layerStack.Clear();
 		sceneManager.Cleanup();
+		geometryPool = nullptr;
 		renderAPI->Shutdown();
 		SDL_Quit();
 	}
@@ -64,16 +67,20 @@ namespace mist {
 				}
 			}
 			
+			shaderLib.Update();
+
 			for (Layer* layer : layerStack) {
 				layer->OnUpdate();
 			}
 
-			physics.Simulate(deltaTime);
+			sceneManager.UpdateScenes(physics, threadPool, deltaTime);
 			
 			for (Layer* layer : layerStack) {
 				layer->OnRender();
 			}
 
+			sceneManager.ClearChanges();
+
 			std::chrono::high_resolution_clock::time_point currentTime = std::chrono::high_resolution_clock::now();
 			deltaTime = std::min(std::chrono::duration<float>(currentTime - lastTime).count(), maxDeltaTime);
 			lastTime = currentTime;
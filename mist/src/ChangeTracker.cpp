@@ -0,0 +1,15 @@
+#include "ChangeTracker.hpp"
+
+namespace mist {
+	void ChangeTracker::Connect(entt::registry& registry) {
+		ConnectComponent<Transform>(registry);
+		ConnectComponent<MeshRenderer>(registry);
+		ConnectComponent<Collider>(registry);
+		ConnectComponent<DirectionalLight>(registry);
+	}
+
+	void ChangeTracker::Clear() {
+		for (entt::sparse_set& set : dirty)
+			set.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#include "FileWatcher.hpp"
+
+#if _WIN32
+#include "platform/windows/WindowsFileWatcher.hpp"
+#elif __linux__
+#include "platform/linux/LinuxFileWatcher.hpp"
+#endif
+
+namespace mist {
+	Scope<FileWatcher> FileWatcher::Create() {
+#if _WIN32
+		return CreateScope<WindowsFileWatcher>();
+#elif __linux__
+		return CreateScope<LinuxFileWatcher>();
+#endif
+	}
+}
\ No newline at end of file
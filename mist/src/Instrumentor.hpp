@@ -87,6 +87,27 @@ namespace mist {
 			}
 		}
 
+		// Counter events show as a graph track in chrome://tracing
+		void WriteCounter(const char* name, const char* series, const double value) {
+			auto now = FloatingPointMicroseconds{ std::chrono::steady_clock::now().time_since_epoch() };
+			std::stringstream json;
+
+			json << std::setprecision(3) << std::fixed;
+			json << ",{";
+			json << "\"name\":\"" << name << "\",";
+			json << "\"ph\":\"C\",";
+			json << "\"pid\":0,";
+			json << "\"ts\":" << now.count() << ',';
+			json << "\"args\":{\"" << series << "\":" << value << "}";
+			json << "}";
+
+			std::lock_guard lock(m_Mutex);
+			if (m_CurrentSession) {
+				m_OutputStream << json.str();
+				m_OutputStream.flush();
+			}
+		}
+
 		static Instrumentor& Get() {
 			static Instrumentor instance;
 			return instance;
@@ -208,9 +229,11 @@ namespace mist {
 #define MIST_PROFILE_SCOPE_LINE(name, line)					    MIST_PROFILE_SCOPE_LINE2(name, line)
 #define MIST_PROFILE_SCOPE(name)								MIST_PROFILE_SCOPE_LINE(name, __LINE__)
 #define MIST_PROFILE_FUNCTION()								    MIST_PROFILE_SCOPE(MIST_FUNC_SIG)
+#define MIST_PROFILE_COUNTER(name, series, value)				::mist::Instrumentor::Get().WriteCounter(name, series, static_cast<double>(value))
 #else
 #define MIST_PROFILE_BEGIN_SESSION(name, filepath)
 #define MIST_PROFILE_END_SESSION()
 #define MIST_PROFILE_SCOPE(name)
 #define MIST_PROFILE_FUNCTION()
+#define MIST_PROFILE_COUNTER(name, series, value)
 #endif
\ No newline at end of file
@@ -7,7 +7,12 @@ namespace mist {
     public:
         static void Init();
 
-        inline static std::shared_ptr<spdlog::logger>& GetLogger() { return logger; }
+        // Initialises itself if used before Application does, as the tests drive engine code without one
+        inline static std::shared_ptr<spdlog::logger>& GetLogger() {
+            if (logger == nullptr)
+                Init();
+            return logger;
+        }
     private:
         static std::shared_ptr<spdlog::logger> logger;
     };
@@ -1,5 +1,6 @@
 #include "PlatformUtils.hpp"
 #include <fstream>
+#include <filesystem>
 #include "Debug.hpp"
 
 namespace mist {
@@ -19,4 +20,44 @@ namespace mist {
 
 		return result;
 	}
+
+	std::vector<uint8_t> Utils::ReadBinaryFile(const std::string& path) {
+		std::vector<uint8_t> result;
+		std::ifstream in(path, std::ios::binary);
+
+		if (in) {
+			in.seekg(0, std::ios::end);
+			result.resize(static_cast<size_t>(in.tellg()));
+			in.seekg(0, std::ios::beg);
+			in.read(reinterpret_cast<char*>(result.data()), result.size());
+		}
+
+		return result;
+	}
+
+	bool Utils::WriteBinaryFile(const std::string& path, const void* data, const size_t size) {
+		const std::string tempPath = path + ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out) {
+				MIST_ERROR("Failed to open file at: {0}", tempPath);
+				return false;
+			}
+
+			out.write(static_cast<const char*>(data), size);
+			if (!out) {
+				MIST_ERROR("Failed to write file at: {0}", tempPath);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, path, error);
+		if (error) {
+			MIST_ERROR("Failed to replace file at: {0}", path);
+			return false;
+		}
+
+		return true;
+	}
 }
\ No newline at end of file
@@ -1,10 +1,20 @@
 #include "SceneManager.hpp"
-#include "components/Transform.hpp"
+#include <algorithm>
 #include "components/DirectionalLight.hpp"
+#include "physics/Physics.hpp"
+#include "ThreadPool.hpp"
 #include <Application.hpp>
 #include <Debug.hpp>
 
 namespace mist {
+	void OnTransformConstruct(SpatialHashGrid& grid, entt::registry& registry, const entt::entity entity) {
+		grid.Insert(entity, registry.get<Transform>(entity).position);
+	}
+
+	void OnTransformDestroy(SpatialHashGrid& grid, entt::registry& registry, const entt::entity entity) {
+		grid.Remove(entity);
+	}
+
 	const entt::entity SceneManager::CreateEntity() {
 		const entt::entity entity = loadedScenes[activeScene].create();
 		return entity;
@@ -14,56 +24,311 @@ namespace mist {
 		loadedScenes[activeScene].destroy(entity);
 	}
 
+	Ref<Prefab> SceneManager::CreatePrefab(const std::vector<entt::entity>& entities) {
+		MIST_ASSERT(!entities.empty(), "Cannot create a prefab from no entities");
+		entt::registry& scene = loadedScenes[activeScene];
+		Ref<Prefab> prefab = CreateRef<Prefab>();
+		prefab->entities.reserve(entities.size());
+
+		const Transform root = scene.get<Transform>(entities[0]);
+		const glm::quat inverseRootRotation = glm::inverse(root.rotation);
+
+		for (const entt::entity entity : entities) {
+			PrefabEntity& prefabEntity = prefab->entities.emplace_back();
+			
+			if (const Transform* transform = scene.try_get<Transform>(entity)) {
+				prefabEntity.transform.position = (inverseRootRotation * (transform->position - root.position)) / root.scale;
+				prefabEntity.transform.rotation = inverseRootRotation * transform->rotation;
+				prefabEntity.transform.scale = transform->scale / root.scale;
+			}
+
+			if (const MeshRenderer* renderer = scene.try_get<MeshRenderer>(entity))
+				prefabEntity.meshRenderer = PrefabMeshRenderer { renderer->shaderName, renderer->mesh, renderer->variantKey };
+
+			if (const Rigidbody* rigidbody = scene.try_get<Rigidbody>(entity))
+				prefabEntity.rigidbody = *rigidbody;
+
+			if (const Collider* collider = scene.try_get<Collider>(entity))
+				prefabEntity.collider = *collider;
+
+			if (const DirectionalLight* light = scene.try_get<DirectionalLight>(entity))
+				prefabEntity.directionalLight = *light;
+		}
+
+		return prefab;
+	}
+
+	std::vector<entt::entity> SceneManager::Instantiate(const Prefab& prefab, const size_t count, const std::vector<Transform>& transforms) {
+		MIST_PROFILE_FUNCTION();
+		MIST_ASSERT(transforms.empty() || transforms.size() == count, "Instantiate needs one transform per instance");
+		entt::registry& scene = loadedScenes[activeScene];
+
+		std::vector<entt::entity> entities(prefab.entities.size() * count);
+		scene.create(entities.begin(), entities.end());
+
+		std::vector<Transform> worldTransforms(count);
+		for (size_t i = 0; i < prefab.entities.size(); ++i) {
+			const PrefabEntity& source = prefab.entities[i];
+			auto first = entities.begin() + (i * count);
+			auto last = first + count;
+
+			for (size_t j = 0; j < count; ++j) {
+				if (transforms.empty()) {
+					worldTransforms[j] = source.transform;
+					continue;
+				}
+
+				const Transform& root = transforms[j];
+				worldTransforms[j].position = root.position + root.rotation * (root.scale * source.transform.position);
+				worldTransforms[j].rotation = root.rotation * source.transform.rotation;
+				worldTransforms[j].scale = root.scale * source.transform.scale;
+			}
+
+			scene.insert<Transform>(first, last, worldTransforms.begin());
+
+			// Every instance copies the same renderer so the mesh and its GPU buffers are shared
+			if (source.meshRenderer.has_value())
+				scene.insert<MeshRenderer>(first, last, MeshRenderer(source.meshRenderer->shaderName, source.meshRenderer->mesh, source.meshRenderer->variantKey));
+
+			if (source.rigidbody.has_value())
+				scene.insert<Rigidbody>(first, last, source.rigidbody.value());
+
+			if (source.collider.has_value())
+				scene.insert<Collider>(first, last, source.collider.value());
+
+			if (source.directionalLight.has_value())
+				scene.insert<DirectionalLight>(first, last, source.directionalLight.value());
+		}
+
+		return entities;
+	}
+
 	void SceneManager::SubmitScene(const uint8_t renderDataID, const int32_t sceneIndex) {
-		auto lightView = loadedScenes[sceneIndex].view<DirectionalLight>();
+		const ChangeTracker& changes = *changeTrackers[sceneIndex];
+		auto lightView = loadedScenes[sceneIndex].view<Transform, DirectionalLight>();
 		for (auto entity : lightView) {
-			Application::Get().GetRenderAPI()->UpdateDirectionalLight(renderDataID, loadedScenes[activeScene].get<DirectionalLight>(entity));
+			auto [transform, light] = lightView.get<Transform, DirectionalLight>(entity);
+			const bool changed = changes.IsDirty<DirectionalLight>(entity) || changes.IsDirty<Transform>(entity);
+			Application::Get().GetRenderAPI()->UpdateDirectionalLight(renderDataID, transform, light, changed);
 			break;	// Only pass the first directional light as there should only be 1
 		}
 		
 		ShaderLibrary* shaderLib = Application::Get().GetShaderLibrary();
-		auto view = loadedScenes[sceneIndex].view<MeshRenderer>();
+		auto group = GetRenderGroup(sceneIndex);
+
+		// Cull everything up front so no commands are recorded for objects outside the camera
+		cullSpheres.Clear();
+		cullSpheres.Reserve(group.size());
+		group.each([this](const Transform& transform, const MeshRenderer& renderer) {
+			const float maxScale = glm::max(glm::max(glm::abs(transform.scale.x), glm::abs(transform.scale.y)), glm::abs(transform.scale.z));
+			const glm::vec3 center = transform.position + transform.rotation * (transform.scale * renderer.mesh->boundsCenter);
+			cullSpheres.Add(center, renderer.mesh->boundsRadius * maxScale);
+		});
+
+		size_t visibleCount = cullSpheres.Size();
+		auto frustum = cameraFrustums.find(renderDataID);
+		if (frustum != cameraFrustums.end())
+			visibleCount = frustum->second.CullSpheres(cullSpheres, cullVisible);
+		else
+			cullVisible.assign(cullSpheres.Size(), 1);
+
+		MIST_PROFILE_COUNTER("SceneManager::SubmitScene culling", "tested", cullSpheres.Size());
+		MIST_PROFILE_COUNTER("SceneManager::SubmitScene culling", "visible", visibleCount);
 		
-		// Binding and unbinding a shader pipeline after each object is terrible but will do for testing sake
-		// ideally we bind a shader then render everything with that shader before moving on
-		// unless there is better methods im unaware of
-		std::string currentPipeline;
-		view.each([renderDataID, shaderLib, &currentPipeline](MeshRenderer &renderer) {
-			if (renderer.shaderName.compare(currentPipeline) != 0) {
-				shaderLib->Get(renderer.shaderName)->Bind(renderDataID);
-				currentPipeline = renderer.shaderName;
+		auto cameraPosition = cameraPositions.find(renderDataID);
+		const glm::vec3 viewPosition = cameraPosition != cameraPositions.end() ? cameraPosition->second : glm::vec3(0.0f);
+
+		visibleRenderers.clear();
+		visibleMatrices.clear();
+		drawList.Clear();
+		drawList.Reserve(visibleCount);
+		size_t index = 0;
+		group.each([this, shaderLib, viewPosition, &index](const Transform& transform, MeshRenderer& renderer) {
+			if (!cullVisible[index++])
+				return;
+
+			if (renderer.shaderHandle == INVALID_SHADER_HANDLE)
+				renderer.shaderHandle = shaderLib->GetVariant(shaderLib->GetHandle(renderer.shaderName), renderer.variantKey);
+
+			// Front to back within a batch so early depth testing rejects more
+			const glm::vec3 offset = transform.position - viewPosition;
+			drawList.Add(DrawList::MakeKey(renderer.shaderHandle, renderer.meshID, glm::dot(offset, offset)), static_cast<uint32_t>(visibleRenderers.size()));
+			visibleRenderers.push_back(&renderer);
+			visibleMatrices.push_back(transform.GetLocalToWorldMatrix());
+		});
+
+		if (visibleRenderers.empty())
+			return;
+
+		drawList.Sort();
+
+		instanceMatrices.resize(drawList.Size());
+		for (size_t i = 0; i < drawList.Size(); ++i)
+			instanceMatrices[i] = visibleMatrices[drawList.GetIndex(i)];
+
+		RenderAPI* renderAPI = Application::Get().GetRenderAPI();
+		const uint32_t firstInstance = renderAPI->UploadInstances(renderDataID, instanceMatrices);
+
+		drawCommands.clear();
+		batchRenderers.clear();
+		size_t batchStart = 0;
+		for (size_t i = 1; i <= drawList.Size(); ++i) {
+			if (i < drawList.Size() && DrawList::GetBatch(drawList.GetKey(i)) == DrawList::GetBatch(drawList.GetKey(batchStart)))
+				continue;
+
+			const MeshRenderer* renderer = visibleRenderers[drawList.GetIndex(batchStart)];
+			IndexedDrawCommand command {};
+			command.indexCount = renderer->geometry->indexCount;
+			command.instanceCount = static_cast<uint32_t>(i - batchStart);
+			command.firstIndex = renderer->geometry->firstIndex;
+			command.vertexOffset = static_cast<int32_t>(renderer->geometry->vertexOffset);
+			command.firstInstance = firstInstance + static_cast<uint32_t>(batchStart);
+			drawCommands.push_back(command);
+			batchRenderers.push_back(renderer);
+			batchStart = i;
+		}
+
+		const bool indirect = renderAPI->GetDrawMode() == RenderAPI::DrawMode::Indirect;
+		const uint32_t firstCommand = indirect ? renderAPI->UploadDrawCommands(renderDataID, drawCommands) : 0;
+
+		// Draws are worked out on this thread first, pipeline builds are queued here so recording jobs only read
+		drawRuns.clear();
+		ShaderHandle currentPipeline = INVALID_SHADER_HANDLE;
+		bool pipelineReady = false;
+		size_t runStart = 0;
+		for (size_t i = 1; i <= batchRenderers.size(); ++i) {
+			// Indirect merges consecutive batches that share a pipeline, direct records each batch
+			const MeshRenderer& renderer = *batchRenderers[runStart];
+			if (indirect && i < batchRenderers.size() && batchRenderers[i]->shaderHandle == renderer.shaderHandle)
+				continue;
+
+			if (renderer.shaderHandle != currentPipeline) {
+				pipelineReady = shaderLib->Get(renderer.shaderHandle)->Prepare(renderDataID);
+				currentPipeline = renderer.shaderHandle;
+			}
+
+			// Pipelines still building in the background skip their draws instead of stalling the frame
+			if (pipelineReady)
+				drawRuns.push_back({ static_cast<uint32_t>(runStart), static_cast<uint32_t>(i - runStart) });
+
+			runStart = i;
+		}
+
+		MIST_PROFILE_COUNTER("SceneManager::SubmitScene batching", "draws", drawRuns.size());
+		if (drawRuns.empty())
+			return;
+
+		// Small scenes stay on one job as splitting them costs more than recording does
+		const size_t maxJobs = Application::Get().GetThreadPool()->GetThreadCount() + 1;
+		const size_t jobCount = std::clamp<size_t>(drawRuns.size() / MIN_DRAWS_PER_RECORDING_JOB, 1, maxJobs);
+		const size_t runsPerJob = (drawRuns.size() + jobCount - 1) / jobCount;
+
+		renderAPI->RecordParallel(renderDataID, static_cast<uint32_t>(jobCount), [this, shaderLib, renderAPI, renderDataID, indirect, firstCommand, runsPerJob](const uint32_t job) {
+			const size_t first = job * runsPerJob;
+			const size_t last = std::min(first + runsPerJob, drawRuns.size());
+
+			// Bound state does not carry between command buffers so each job binds the geometry pool itself
+			Application::Get().GetGeometryPool()->Bind();
+
+			ShaderHandle boundPipeline = INVALID_SHADER_HANDLE;
+			for (size_t i = first; i < last; ++i) {
+				const DrawRun& run = drawRuns[i];
+				const MeshRenderer& renderer = *batchRenderers[run.firstBatch];
+				if (renderer.shaderHandle != boundPipeline) {
+					shaderLib->Get(renderer.shaderHandle)->Bind(renderDataID);
+					renderer.Bind(renderDataID);
+					boundPipeline = renderer.shaderHandle;
+				}
+
+				if (indirect)
+					renderAPI->DrawIndirect(renderDataID, firstCommand + run.firstBatch, run.batchCount);
+				else
+					renderAPI->Draw(drawCommands[run.firstBatch]);
 			}
-			
-			renderer.Bind(renderDataID);
-			renderer.Draw();
 		});
 	}
 
-	void SceneManager::UpdateSceneCamera(const Camera& camera, const uint8_t renderDataID) {
-		Application::Get().GetRenderAPI()->UpdateCamera(renderDataID, camera);
+	void SceneManager::UpdateSceneCamera(const Camera& camera, const Transform& transform, const uint8_t renderDataID) {
+		cameraFrustums[renderDataID] = Frustum(camera.GetViewProjectionMatrix(transform));
+		cameraPositions[renderDataID] = transform.position;
+		Application::Get().GetRenderAPI()->UpdateCamera(renderDataID, transform, camera);
 	}
 
-	void SceneManager::UpdateSceneCamera(const uint8_t renderDataID) {
-		auto camView = loadedScenes[activeScene].view<Camera>();
+	void SceneManager::UpdateSceneCamera(const uint8_t renderDataID, const int32_t sceneIndex) {
+		auto camView = loadedScenes[sceneIndex].view<Transform, Camera>();
 		
-		Camera* cam;
 		for (auto entity : camView) {
-			cam = loadedScenes[activeScene].try_get<Camera>(entity);
-
-			if (cam != nullptr)
-				break;
+			auto [transform, cam] = camView.get<Transform, Camera>(entity);
+			UpdateSceneCamera(cam, transform, renderDataID);
+			return;
 		}
 
-		if (cam != nullptr) {
-			Application::Get().GetRenderAPI()->UpdateCamera(renderDataID, *cam);
-			return;
+		MIST_WARN("No camera in scene " + std::to_string(sceneIndex));
+	}
+
+	void SceneManager::UpdateSpatialIndex(const int32_t sceneIndex) {
+		MIST_PROFILE_FUNCTION();
+		SpatialHashGrid& grid = *spatialIndices[sceneIndex];
+		entt::registry& scene = loadedScenes[sceneIndex];
+
+		// Only entities that moved this frame are touched, those that stayed in the same cell just have their position refreshed
+		for (const entt::entity entity : changeTrackers[sceneIndex]->GetDirty<Transform>())
+			grid.Update(entity, scene.get<Transform>(entity).position);
+	}
+
+	void SceneManager::ClearChanges() {
+		for (Scope<ChangeTracker>& tracker : changeTrackers)
+			tracker->Clear();
+	}
+
+	void SceneManager::SetSceneLive(const int32_t sceneIndex, const bool live) {
+		liveScenes[sceneIndex] = live;
+	}
+
+	void SceneManager::SetSceneUpdate(const int32_t sceneIndex, SceneUpdateCallback callback) {
+		sceneUpdates[sceneIndex] = callback;
+	}
+
+	void SceneManager::UpdateScenes(Physics& physics, ThreadPool& threadPool, const float delta) {
+		MIST_PROFILE_FUNCTION();
+		std::vector<std::future<void>> pending;
+		pending.reserve(loadedScenes.size());
+
+		// Scenes share nothing with each other so each can be ticked on its own worker
+		for (size_t i = 0; i < loadedScenes.size(); ++i) {
+			const int32_t sceneIndex = static_cast<int32_t>(i);
+			if (sceneIndex != activeScene && !liveScenes[i])
+				continue;
+
+			pending.push_back(threadPool.Submit([this, &physics, sceneIndex, delta]() {
+				MIST_PROFILE_SCOPE("SceneManager::UpdateScene");
+				if (sceneUpdates[sceneIndex])
+					sceneUpdates[sceneIndex](loadedScenes[sceneIndex], delta);
+
+				physics.Simulate(sceneIndex, delta);
+				UpdateSpatialIndex(sceneIndex);
+			}));
 		}
 
-		MIST_WARN("No camera in active scene");
+		for (std::future<void>& task : pending)
+			task.get();
 	}
 
 	void SceneManager::LoadEmptyScene() {
 		loadedScenes.push_back(entt::registry{});
+		liveScenes.push_back(false);
+		sceneUpdates.push_back(nullptr);
+
+		entt::registry& scene = loadedScenes.back();
+		SpatialHashGrid& grid = *spatialIndices.emplace_back(CreateScope<SpatialHashGrid>());
+		scene.on_construct<Transform>().connect<&OnTransformConstruct>(grid);
+		scene.on_destroy<Transform>().connect<&OnTransformDestroy>(grid);
+		changeTrackers.emplace_back(CreateScope<ChangeTracker>())->Connect(scene);
+
+		// Create the groups up front so components are packed as they are added rather than sorted on first use
+		const int32_t sceneIndex = static_cast<int32_t>(loadedScenes.size()) - 1;
+		GetRenderGroup(sceneIndex);
+		GetPhysicsGroup(sceneIndex);
 		MIST_INFO("Loaded empty scene");
 		
 		if (activeScene == -1)
@@ -0,0 +1,45 @@
+#include "ThreadPool.hpp"
+
+namespace mist {
+	ThreadPool::ThreadPool(size_t threadCount) {
+		if (threadCount == 0) {
+			const size_t cores = std::thread::hardware_concurrency();
+			threadCount = cores > 1 ? cores - 1 : 1;
+		}
+
+		workers.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i)
+			workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+
+		condition.notify_all();
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	void ThreadPool::WorkerLoop() {
+		while (true) {
+			std::function<void()> task;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+				// Drain remaining work before exiting so no submitted future is left unfulfilled
+				if (stopping && tasks.empty())
+					return;
+
+				task = std::move(tasks.front());
+				tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
\ No newline at end of file
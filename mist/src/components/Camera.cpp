@@ -3,14 +3,13 @@
 #include <Debug.hpp>
 
 namespace mist {
-	Camera::Camera(Transform& transform) : transformComponent(transform) {}
+	Camera::Camera() {}
 
 	Camera::~Camera() {}
 
 	bool Camera::IsEqual(const Camera& other) const {
 		return type == other.type &&
 			projectionMatrix == other.projectionMatrix &&
-			transformComponent.IsEqual(other.transformComponent) &&
 			width == other.width &&
 			height == other.height &&
 			aspect == other.aspect &&
@@ -22,6 +21,10 @@ namespace mist {
 			perspectiveFarPlane == other.perspectiveFarPlane;
 	}
 
+	bool Camera::IsEqual(const Camera& other, const Transform& transform, const Transform& otherTransform) const {
+		return IsEqual(other) && transform.IsEqual(otherTransform);
+	}
+
 	void Camera::RecreateCamera() {
 		if (type == Orthographic) {
 			float left = -size * aspect * 0.5f;
@@ -44,16 +47,16 @@ namespace mist {
 		return projectionMatrix;
 	}
 
-	glm::mat4 Camera::GetViewMatrix() const {
+	glm::mat4 Camera::GetViewMatrix(const Transform& transform) const {
 		return glm::lookAtLH(
-			transformComponent.position, 
-			transformComponent.position + transformComponent.Forward(),
-			transformComponent.Up()
+			transform.position, 
+			transform.position + transform.Forward(),
+			transform.Up()
 		);
 	}
 
-	glm::mat4 Camera::GetViewProjectionMatrix() const {
-		return projectionMatrix * GetViewMatrix();
+	glm::mat4 Camera::GetViewProjectionMatrix(const Transform& transform) const {
+		return projectionMatrix * GetViewMatrix(transform);
 	}
 
 	void Camera::SetViewportSize(float _width, float _height) {
@@ -75,7 +78,7 @@ namespace mist {
 		RecreateCamera();
 	}
 
-	Camera::Camera(const Camera& other) : type(other.type), projectionMatrix(other.projectionMatrix), transformComponent(other.transformComponent), 
+	Camera::Camera(const Camera& other) : type(other.type), projectionMatrix(other.projectionMatrix), 
 		width(other.width), height(other.height), aspect(other.aspect),
 		size(other.size), orthographicNearPlane(other.orthographicNearPlane), orthographicFarPlane(other.orthographicFarPlane),
 		fov(other.fov), perspectiveNearPlane(other.perspectiveNearPlane), perspectiveFarPlane(other.perspectiveNearPlane) {}
@@ -86,7 +89,6 @@ namespace mist {
 
 		type = other.type;
 		projectionMatrix = other.projectionMatrix;
-		transformComponent = other.transformComponent;
 		width = other.width;
 		height = other.height;
 		aspect = other.aspect;
@@ -112,5 +114,5 @@ namespace mist {
 		RecreateCamera();
 	}
 
-	SceneCamera::SceneCamera(Transform& transform) : Camera(transform) {}
+	SceneCamera::SceneCamera() : Camera() {}
 }
@@ -1,32 +1,88 @@
 #include "components/MeshRenderer.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include "renderer/DrawList.hpp"
 #include "Application.hpp"
+#include "Debug.hpp"
 
 namespace mist {
-	MeshRenderer::MeshRenderer(Transform& transform, std::string shaderName, mist::Ref<Mesh> mesh) : transformComponent(transform), shaderName(shaderName), mesh(mesh) {
-		Apply();
+	// Pool ranges are shared by every renderer using the same mesh, entries are removed once the last one lets go
+	struct SharedMeshGeometry {
+		std::weak_ptr<GeometryRange> geometry;
+		std::weak_ptr<Mesh> owner;	// A freed mesh's address can be reused, so the pointer key alone is not enough
+		uint32_t revision;
+		uint32_t id;
+	};
+
+	static std::unordered_map<const Mesh*, SharedMeshGeometry> sharedMeshGeometry;
+	static uint32_t nextMeshID = 0;
+	static std::vector<uint32_t> freeMeshIDs;	// Released with their range so ids stay within the draw key's mesh bits
+
+	static uint32_t AcquireMeshID() {
+		if (!freeMeshIDs.empty()) {
+			const uint32_t id = freeMeshIDs.back();
+			freeMeshIDs.pop_back();
+			return id;
+		}
+
+		MIST_ASSERT(nextMeshID < (1u << DrawList::MESH_BITS), "Ran out of mesh ids, live meshes no longer fit the draw key");
+		return nextMeshID++;
 	}
 
-	MeshRenderer::~MeshRenderer() {}
+	// Deleter for the shared range, so it and its id are released however the last renderer holding it goes away,
+	// including components destroyed with their entity or scene that never call Clear
+	static void ReleaseGeometry(GeometryRange* range, const uint32_t id) {
+		Application::Get().GetGeometryPool()->Free(*range);
+		delete range;
+		freeMeshIDs.push_back(id);
+		std::erase_if(sharedMeshGeometry, [](const auto& entry) { return entry.second.geometry.expired(); });
+	}
+
+	static Ref<GeometryRange> UploadGeometry(const Mesh& mesh, const uint32_t id) {
+		GeometryRange* range = new GeometryRange(Application::Get().GetGeometryPool()->Upload(mesh.vertices, mesh.indices));
+		return Ref<GeometryRange>(range, [id](GeometryRange* released) { ReleaseGeometry(released, id); });
+	}
 
-	void MeshRenderer::Bind(const uint8_t renderDataID) {
+	MeshRenderer::MeshRenderer(std::string shaderName, mist::Ref<Mesh> mesh, ShaderVariantKey variantKey) : shaderName(shaderName), variantKey(variantKey), mesh(mesh) {
+		Apply();
+	}
+
+	void MeshRenderer::Bind(const uint8_t renderDataID) const {
 		Application::Get().GetRenderAPI()->BindMeshRenderer(renderDataID, *this);
 	}
 	
-	void MeshRenderer::Draw() {
-		Application::Get().GetRenderAPI()->Draw(mesh->indices.size());
+	void MeshRenderer::Draw(const uint32_t instanceCount, const uint32_t firstInstance) const {
+		IndexedDrawCommand command {};
+		command.indexCount = geometry->indexCount;
+		command.instanceCount = instanceCount;
+		command.firstIndex = geometry->firstIndex;
+		command.vertexOffset = static_cast<int32_t>(geometry->vertexOffset);
+		command.firstInstance = firstInstance;
+		Application::Get().GetRenderAPI()->Draw(command);
 	}
 
 	void MeshRenderer::Apply() {
 		Clear();
-		vBuffer = mist::VertexBuffer::Create(mesh->vertices);
-		iBuffer = mist::IndexBuffer::Create(mesh->indices);
+
+		SharedMeshGeometry& shared = sharedMeshGeometry[mesh.get()];
+		geometry = shared.geometry.lock();
+
+		// An edited or different mesh starts a new entry, the old range stays with the renderers still holding it
+		if (geometry != nullptr && (shared.owner.lock() != mesh || shared.revision != mesh->revision))
+			geometry = nullptr;
+
+		if (geometry == nullptr) {
+			const uint32_t id = AcquireMeshID();
+			geometry = UploadGeometry(*mesh, id);
+			shared = { geometry, mesh, mesh->revision, id };
+		}
+
+		meshID = shared.id;
+		shaderHandle = INVALID_SHADER_HANDLE;
 	}
 
 	void MeshRenderer::Clear() {
-		if (vBuffer != nullptr)
-			vBuffer->Clear();
-
-		if (iBuffer != nullptr)
-			iBuffer->Clear();
+		// The range's deleter releases it once this was the last renderer holding it
+		geometry = nullptr;
 	}
 }
\ No newline at end of file
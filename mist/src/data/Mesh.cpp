@@ -3,9 +3,12 @@
 namespace mist {
 	Mesh::Mesh() {}
 
-	Mesh::Mesh(const std::vector<Vertex>& _vertices, const std::vector<uint32_t>& _indices) : vertices(_vertices), indices(_indices) {}
+	Mesh::Mesh(const std::vector<Vertex>& _vertices, const std::vector<uint32_t>& _indices) : vertices(_vertices), indices(_indices) {
+		RecalculateBounds();
+	}
 
 	void Mesh::GenerateNormals() {
+		++revision;
 		for (size_t i = 0; i < indices.size(); i += 3) {
 			int i0 = indices[i];
 			int i1 = indices[i + 1];
@@ -27,4 +30,26 @@ namespace mist {
 		for (Vertex& vertex : vertices)
 			vertex.normal = glm::normalize(vertex.normal);
 	}
+
+	void Mesh::RecalculateBounds() {
+		++revision;
+		if (vertices.empty()) {
+			boundsMin = boundsMax = boundsCenter = glm::vec3(0);
+			boundsRadius = 0;
+			return;
+		}
+
+		boundsMin = vertices[0].position;
+		boundsMax = vertices[0].position;
+		for (const Vertex& vertex : vertices) {
+			boundsMin = glm::min(boundsMin, vertex.position);
+			boundsMax = glm::max(boundsMax, vertex.position);
+		}
+
+		// Sphere around the box center, slightly looser than a minimal sphere but cheap and stable
+		boundsCenter = (boundsMin + boundsMax) * 0.5f;
+		boundsRadius = 0;
+		for (const Vertex& vertex : vertices)
+			boundsRadius = glm::max(boundsRadius, glm::distance(boundsCenter, vertex.position));
+	}
 }
\ No newline at end of file
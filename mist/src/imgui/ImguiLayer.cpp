@@ -72,12 +72,22 @@ namespace mist {
 			info.Device = context.GetDevice();
 			info.QueueFamily = indicies.graphicsFamily.value();
 			info.Queue = context.GetGraphicsQueue();
-			info.PipelineCache = VK_NULL_HANDLE;
+			info.PipelineCache = context.GetPipelineCache();
 			info.DescriptorPool = data->descriptors.GetImGuiDescriptorPool();
 			info.MinImageCount = capabilities.minImageCount;
 			info.ImageCount = swapchainImageCount;
 			info.Allocator = context.GetAllocationCallbacks();
 			info.PipelineInfoMain.RenderPass = data->renderPass;
+			if (context.IsDynamicRenderingEnabled()) {
+				// The formats have to match what the swapchain render data begins rendering with
+				info.UseDynamicRendering = true;
+				VkPipelineRenderingCreateInfo& renderingInfo = info.PipelineInfoMain.PipelineRenderingCreateInfo;
+				renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+				renderingInfo.colorAttachmentCount = static_cast<uint32_t>(data->colorFormats.size());
+				renderingInfo.pColorAttachmentFormats = data->colorFormats.data();
+				renderingInfo.depthAttachmentFormat = data->depthFormat;
+				renderingInfo.stencilAttachmentFormat = data->stencilFormat;
+			}
 			info.PipelineInfoMain.Subpass = 0;
 			info.PipelineInfoMain.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 			info.CheckVkResultFn = CheckVkResult;
@@ -227,28 +227,41 @@ namespace mist {
 		return IntersectData(false, glm::vec3(0,0,0));
 	}
 
-	void Physics::Simulate(const float delta) {
-		entt::registry& scene = Application::Get().GetSceneManager()->GetActiveScene();
+	void Physics::Simulate(const int32_t sceneIndex, const float delta) {
+		SceneManager* sceneManager = Application::Get().GetSceneManager();
+		entt::registry& scene = sceneManager->GetScene(sceneIndex);
+
+		scene.view<Transform, Rigidbody>().each([&scene, delta](entt::entity entity, Transform& transform, Rigidbody& rigidbody) {
+			scene.patch<Transform>(entity, [&rigidbody, delta](Transform& transform) {
+				Integrate(transform, rigidbody, delta);
+			});
+		});
+
+		// Gather the collider set once so the pair loop below reads from a contiguous array
+		// instead of going back through the registry for every pair
+		struct ColliderEntry {
+			entt::entity entity;
+			const Transform* transform;
+			const Collider* collider;
+		};
 
-		scene.view<Transform, Rigidbody>().each([delta](entt::entity entity, Transform& transform, Rigidbody& rigidbody) {
-			Integrate(transform, rigidbody, delta);
+		auto colliderGroup = sceneManager->GetPhysicsGroup(sceneIndex);
+		std::vector<ColliderEntry> colliders;
+		colliders.reserve(colliderGroup.size());
+		colliderGroup.each([&colliders](entt::entity entity, Rigidbody& rigidbody, Collider& collider, Transform& transform) {
+			colliders.push_back({ entity, &transform, &collider });
 		});
 
 		std::unordered_map<entt::entity, std::vector<CollisionEvent>> entityCollisions;
-		auto colliderView = scene.view<Transform, Rigidbody, Collider>();
-		std::vector<entt::entity> colliderEntities(colliderView.begin(), colliderView.end());
-
-		for (size_t i = 0; i < colliderEntities.size(); ++i) {
-			entt::entity a = colliderEntities[i];
-			auto [transformA, colliderA] = colliderView.get<Transform, Collider>(a);
+		for (size_t i = 0; i < colliders.size(); ++i) {
+			const ColliderEntry& a = colliders[i];
 
-			for (size_t j = i + 1; j < colliderEntities.size(); ++j) {
-				entt::entity b = colliderEntities[j];
-				auto [transformB, colliderB] = colliderView.get<Transform, Collider>(b);
-				IntersectData data = DetectCollision(transformA, colliderA, transformB, colliderB);
+			for (size_t j = i + 1; j < colliders.size(); ++j) {
+				const ColliderEntry& b = colliders[j];
+				IntersectData data = DetectCollision(*a.transform, *a.collider, *b.transform, *b.collider);
 
 				if (data.isIntersecting)
-					entityCollisions[a].emplace_back(b, data.minimumTranslationVector);
+					entityCollisions[a.entity].emplace_back(b.entity, data.minimumTranslationVector);
 			}
 		}
 
@@ -273,11 +286,13 @@ namespace mist {
 				
 				const float correctionPercent = 0.2f;
 				glm::vec3 correction = collision.minimumTranslationVector * correctionPercent;
-				Transform& transform = colliderView.get<Transform>(entity);
-				Transform& otherTransform = colliderView.get<Transform>(collision.collidingEntity);
-	
-				transform.position += (correction * (otherRigidbody.mass / (rigidbody.mass + otherRigidbody.mass)));
-				otherTransform.position -= (correction * (rigidbody.mass / (rigidbody.mass + otherRigidbody.mass)));
+				const float massSum = rigidbody.mass + otherRigidbody.mass;
+				scene.patch<Transform>(entity, [&](Transform& transform) {
+					transform.position += (correction * (otherRigidbody.mass / massSum));
+				});
+				scene.patch<Transform>(collision.collidingEntity, [&](Transform& otherTransform) {
+					otherTransform.position -= (correction * (rigidbody.mass / massSum));
+				});
 			}
 		}
 	}
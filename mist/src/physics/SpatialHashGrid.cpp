@@ -0,0 +1,187 @@
+#include "physics/SpatialHashGrid.hpp"
+#include <algorithm>
+
+namespace mist {
+	SpatialHashGrid::SpatialHashGrid(const float cellSize) : cellSize(cellSize), inverseCellSize(1.0f / cellSize) {}
+
+	void SpatialHashGrid::Insert(const entt::entity entity, const glm::vec3 position) {
+		if (locations.contains(entity)) {
+			Update(entity, position);
+			return;
+		}
+
+		AddToCell(entity, position, GetCell(position));
+	}
+
+	void SpatialHashGrid::Update(const entt::entity entity, const glm::vec3 position) {
+		auto it = locations.find(entity);
+		if (it == locations.end()) {
+			AddToCell(entity, position, GetCell(position));
+			return;
+		}
+
+		const EntityLocation location = it->second;
+		const CellKey cell = GetCell(position);
+		if (cell == location.cell) {
+			cells[cell][location.index].position = position;
+			return;
+		}
+
+		RemoveFromCell(location);
+		AddToCell(entity, position, cell);
+	}
+
+	void SpatialHashGrid::Remove(const entt::entity entity) {
+		auto it = locations.find(entity);
+		if (it == locations.end())
+			return;
+
+		RemoveFromCell(it->second);
+		locations.erase(entity);
+	}
+
+	void SpatialHashGrid::Clear() {
+		cells.clear();
+		locations.clear();
+	}
+
+	void SpatialHashGrid::QueryRadius(const glm::vec3 center, const float radius, std::vector<entt::entity>& results) const {
+		const float radiusSqr = radius * radius;
+		const CellKey min = GetCell(center - glm::vec3(radius));
+		const CellKey max = GetCell(center + glm::vec3(radius));
+
+		auto testCell = [&](const std::vector<CellEntry>& entries) {
+			for (const CellEntry& entry : entries) {
+				if (glm::distance2(entry.position, center) <= radiusSqr)
+					results.push_back(entry.entity);
+			}
+		};
+
+		// Huge queries touch fewer buckets by walking the occupied cells instead of the covered ones
+		if (GetCellCount(min, max) > cells.size()) {
+			for (const auto& [cell, entries] : cells)
+				testCell(entries);
+			return;
+		}
+
+		for (int32_t x = min.x; x <= max.x; ++x) {
+			for (int32_t y = min.y; y <= max.y; ++y) {
+				for (int32_t z = min.z; z <= max.z; ++z) {
+					auto it = cells.find({ x, y, z });
+					if (it != cells.end())
+						testCell(it->second);
+				}
+			}
+		}
+	}
+
+	void SpatialHashGrid::QueryAABB(const glm::vec3 min, const glm::vec3 max, std::vector<entt::entity>& results) const {
+		const CellKey minCell = GetCell(min);
+		const CellKey maxCell = GetCell(max);
+
+		auto testCell = [&](const std::vector<CellEntry>& entries) {
+			for (const CellEntry& entry : entries) {
+				if (glm::all(glm::greaterThanEqual(entry.position, min)) && glm::all(glm::lessThanEqual(entry.position, max)))
+					results.push_back(entry.entity);
+			}
+		};
+
+		if (GetCellCount(minCell, maxCell) > cells.size()) {
+			for (const auto& [cell, entries] : cells)
+				testCell(entries);
+			return;
+		}
+
+		for (int32_t x = minCell.x; x <= maxCell.x; ++x) {
+			for (int32_t y = minCell.y; y <= maxCell.y; ++y) {
+				for (int32_t z = minCell.z; z <= maxCell.z; ++z) {
+					auto it = cells.find({ x, y, z });
+					if (it != cells.end())
+						testCell(it->second);
+				}
+			}
+		}
+	}
+
+	void SpatialHashGrid::QueryKNearest(const glm::vec3 center, const size_t k, std::vector<entt::entity>& results) const {
+		if (k == 0 || locations.empty())
+			return;
+
+		std::vector<std::pair<float, entt::entity>> candidates;
+		auto addCell = [&](const std::vector<CellEntry>& entries) {
+			for (const CellEntry& entry : entries)
+				candidates.emplace_back(glm::distance2(entry.position, center), entry.entity);
+		};
+
+		// Search shells of cells outwards from the center, once k candidates are found that are closer than
+		// the nearest unsearched shell could be nothing further out can beat them
+		const CellKey origin = GetCell(center);
+		for (int32_t ring = 0; ; ++ring) {
+			const size_t side = static_cast<size_t>(ring) * 2 + 1;
+			if (side * side * side > cells.size()) {
+				candidates.clear();
+				for (const auto& [cell, entries] : cells)
+					addCell(entries);
+				break;
+			}
+
+			for (int32_t x = -ring; x <= ring; ++x) {
+				for (int32_t y = -ring; y <= ring; ++y) {
+					for (int32_t z = -ring; z <= ring; ++z) {
+						if (std::max({ std::abs(x), std::abs(y), std::abs(z) }) != ring)
+							continue;
+
+						auto it = cells.find({ origin.x + x, origin.y + y, origin.z + z });
+						if (it != cells.end())
+							addCell(it->second);
+					}
+				}
+			}
+
+			if (candidates.size() >= k) {
+				std::nth_element(candidates.begin(), candidates.begin() + (k - 1), candidates.end());
+				const float searchedDistance = ring * cellSize;
+				if (candidates[k - 1].first <= searchedDistance * searchedDistance)
+					break;
+			}
+
+			if (candidates.size() == locations.size())
+				break;
+		}
+
+		const size_t count = std::min(k, candidates.size());
+		std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+		for (size_t i = 0; i < count; ++i)
+			results.push_back(candidates[i].second);
+	}
+
+	SpatialHashGrid::CellKey SpatialHashGrid::GetCell(const glm::vec3 position) const {
+		const glm::vec3 scaled = glm::clamp(glm::floor(position * inverseCellSize), glm::vec3(-MAX_CELL_COORDINATE), glm::vec3(MAX_CELL_COORDINATE));
+		return { static_cast<int32_t>(scaled.x), static_cast<int32_t>(scaled.y), static_cast<int32_t>(scaled.z) };
+	}
+
+	void SpatialHashGrid::AddToCell(const entt::entity entity, const glm::vec3 position, const CellKey cell) {
+		std::vector<CellEntry>& entries = cells[cell];
+		locations[entity] = { cell, static_cast<uint32_t>(entries.size()) };
+		entries.push_back({ entity, position });
+	}
+
+	void SpatialHashGrid::RemoveFromCell(const EntityLocation location) {
+		auto it = cells.find(location.cell);
+		std::vector<CellEntry>& entries = it->second;
+
+		// Swap with the last entry so removal is constant time, the moved entity needs its index fixed up
+		if (location.index != entries.size() - 1) {
+			entries[location.index] = entries.back();
+			locations[entries[location.index].entity].index = location.index;
+		}
+
+		entries.pop_back();
+		if (entries.empty())
+			cells.erase(it);
+	}
+
+	const size_t SpatialHashGrid::GetCellCount(const CellKey min, const CellKey max) const {
+		return static_cast<size_t>(max.x - min.x + 1) * static_cast<size_t>(max.y - min.y + 1) * static_cast<size_t>(max.z - min.z + 1);
+	}
+}
\ No newline at end of file
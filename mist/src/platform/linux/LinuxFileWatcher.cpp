@@ -0,0 +1,72 @@
+#if __linux__
+#include "platform/linux/LinuxFileWatcher.hpp"
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <filesystem>
+#include <unordered_set>
+#include "Debug.hpp"
+
+namespace mist {
+	LinuxFileWatcher::LinuxFileWatcher() {
+		inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (inotifyFd < 0)
+			MIST_ERROR("Failed to create inotify instance, file changes will not be picked up");
+	}
+
+	LinuxFileWatcher::~LinuxFileWatcher() {
+		if (inotifyFd >= 0)
+			close(inotifyFd);
+	}
+
+	void LinuxFileWatcher::Watch(const std::string& path) {
+		if (inotifyFd < 0)
+			return;
+
+		const std::filesystem::path filePath(path);
+		const std::string folder = filePath.has_parent_path() ? filePath.parent_path().string() : ".";
+
+		auto folderWatch = folderWatches.find(folder);
+		if (folderWatch == folderWatches.end()) {
+			const int watch = inotify_add_watch(inotifyFd, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+			if (watch < 0) {
+				MIST_ERROR("Failed to watch folder: {0}", folder);
+				return;
+			}
+			folderWatch = folderWatches.emplace(folder, watch).first;
+		}
+
+		watchedFiles[folderWatch->second][filePath.filename().string()] = path;
+	}
+
+	std::vector<std::string> LinuxFileWatcher::Poll() {
+		std::vector<std::string> changed;
+		if (inotifyFd < 0)
+			return changed;
+
+		std::unordered_set<std::string> seen;
+		alignas(inotify_event) char buffer[4096];
+		while (true) {
+			const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+			if (length <= 0)
+				break;
+
+			for (ssize_t offset = 0; offset < length;) {
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				offset += sizeof(inotify_event) + event->len;
+				if (event->len == 0)
+					continue;
+
+				auto files = watchedFiles.find(event->wd);
+				if (files == watchedFiles.end())
+					continue;
+
+				auto file = files->second.find(event->name);
+				if (file != files->second.end() && seen.insert(file->second).second)
+					changed.push_back(file->second);
+			}
+		}
+
+		return changed;
+	}
+}
+#endif
\ No newline at end of file
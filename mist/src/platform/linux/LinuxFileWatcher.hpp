@@ -0,0 +1,22 @@
+#pragma once
+#include <unordered_map>
+#include "FileWatcher.hpp"
+
+namespace mist {
+	class LinuxFileWatcher : public FileWatcher {
+	public:
+		LinuxFileWatcher();
+		virtual ~LinuxFileWatcher() override;
+
+		LinuxFileWatcher(const LinuxFileWatcher& other) = delete;
+		LinuxFileWatcher& operator=(const LinuxFileWatcher& other) = delete;
+
+		virtual void Watch(const std::string& path) override;
+		virtual std::vector<std::string> Poll() override;
+	private:
+		int inotifyFd = -1;
+		// Folders are watched rather than files, editors that save by renaming over the file would drop a file watch
+		std::unordered_map<std::string, int> folderWatches;
+		std::unordered_map<int, std::unordered_map<std::string, std::string>> watchedFiles;	// Watch -> file name -> watched path
+	};
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#if _WIN32
+#include "platform/windows/WindowsFileWatcher.hpp"
+
+namespace mist {
+	void WindowsFileWatcher::Watch(const std::string& path) {
+		std::error_code error;
+		writeTimes[path] = std::filesystem::last_write_time(path, error);
+	}
+
+	std::vector<std::string> WindowsFileWatcher::Poll() {
+		std::vector<std::string> changed;
+
+		// Stat calls for every file each frame add up, changes only need to land within a blink
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now - lastPoll < pollInterval)
+			return changed;
+		lastPoll = now;
+
+		for (std::pair<const std::string, std::filesystem::file_time_type>& file : writeTimes) {
+			std::error_code error;
+			const std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(file.first, error);
+			// Missing mid save, picked up on a later poll once the file is back
+			if (error || writeTime == file.second)
+				continue;
+
+			file.second = writeTime;
+			changed.push_back(file.first);
+		}
+
+		return changed;
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+#include "FileWatcher.hpp"
+
+namespace mist {
+	// Polls write times rather than using ReadDirectoryChangesW, which needs a thread or overlapped io per folder
+	class WindowsFileWatcher : public FileWatcher {
+	public:
+		WindowsFileWatcher() {}
+		virtual ~WindowsFileWatcher() override {}
+
+		virtual void Watch(const std::string& path) override;
+		virtual std::vector<std::string> Poll() override;
+	private:
+		const std::chrono::milliseconds pollInterval = std::chrono::milliseconds(500);
+
+		std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+		std::chrono::steady_clock::time_point lastPoll;
+	};
+}
\ No newline at end of file
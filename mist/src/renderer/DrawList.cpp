@@ -0,0 +1,63 @@
+#include "renderer/DrawList.hpp"
+#include <cstring>
+
+namespace mist {
+	uint64_t DrawList::MakeKey(const uint32_t pipeline, const uint32_t mesh, const float depth) {
+		uint32_t depthBits;
+		std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+		return (static_cast<uint64_t>(pipeline & ((1u << PIPELINE_BITS) - 1)) << (MESH_BITS + DEPTH_BITS)) |
+			(static_cast<uint64_t>(mesh & ((1u << MESH_BITS) - 1)) << DEPTH_BITS) |
+			static_cast<uint64_t>(depthBits >> (32 - DEPTH_BITS));
+	}
+
+	void DrawList::Clear() {
+		keys.clear();
+		indices.clear();
+	}
+
+	void DrawList::Reserve(const size_t count) {
+		keys.reserve(count);
+		indices.reserve(count);
+	}
+
+	void DrawList::Add(const uint64_t key, const uint32_t index) {
+		keys.push_back(key);
+		indices.push_back(index);
+	}
+
+	void DrawList::Sort() {
+		const size_t count = keys.size();
+		if (count < 2)
+			return;
+
+		scratchKeys.resize(count);
+		scratchIndices.resize(count);
+
+		for (uint32_t shift = 0; shift < 64; shift += 8) {
+			size_t offsets[256] = {};
+			for (const uint64_t key : keys)
+				++offsets[(key >> shift) & 0xFF];
+
+			// Every key shares this byte so the pass would not move anything
+			if (offsets[(keys[0] >> shift) & 0xFF] == count)
+				continue;
+
+			size_t total = 0;
+			for (size_t& offset : offsets) {
+				const size_t bucketCount = offset;
+				offset = total;
+				total += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; ++i) {
+				const size_t destination = offsets[(keys[i] >> shift) & 0xFF]++;
+				scratchKeys[destination] = keys[i];
+				scratchIndices[destination] = indices[i];
+			}
+
+			keys.swap(scratchKeys);
+			indices.swap(scratchIndices);
+		}
+	}
+}
\ No newline at end of file
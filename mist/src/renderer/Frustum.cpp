@@ -0,0 +1,93 @@
+#include "renderer/Frustum.hpp"
+
+namespace mist {
+	void BoundingSphereBatch::Clear() {
+		x.clear();
+		y.clear();
+		z.clear();
+		radius.clear();
+	}
+
+	void BoundingSphereBatch::Reserve(const size_t count) {
+		x.reserve(count);
+		y.reserve(count);
+		z.reserve(count);
+		radius.reserve(count);
+	}
+
+	void BoundingSphereBatch::Add(const glm::vec3 center, const float sphereRadius) {
+		x.push_back(center.x);
+		y.push_back(center.y);
+		z.push_back(center.z);
+		radius.push_back(sphereRadius);
+	}
+
+	Frustum::Frustum(const glm::mat4& viewProjection) {
+		// glm is column major so rows are gathered across the columns
+		const glm::vec4 row0 = { viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0] };
+		const glm::vec4 row1 = { viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1] };
+		const glm::vec4 row2 = { viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2] };
+		const glm::vec4 row3 = { viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3] };
+
+		planes[0] = row3 + row0;	// Left
+		planes[1] = row3 - row0;	// Right
+		planes[2] = row3 + row1;	// Bottom
+		planes[3] = row3 - row1;	// Top
+		planes[4] = row2;			// Near
+		planes[5] = row3 - row2;	// Far
+
+		for (glm::vec4& plane : planes)
+			plane /= glm::length(glm::vec3(plane));
+	}
+
+	bool Frustum::IntersectsSphere(const glm::vec3 center, const float radius) const {
+		for (const glm::vec4& plane : planes) {
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool Frustum::IntersectsAABB(const glm::vec3 min, const glm::vec3 max) const {
+		for (const glm::vec4& plane : planes) {
+			// Corner furthest along the plane normal
+			const glm::vec3 positive = {
+				plane.x >= 0 ? max.x : min.x,
+				plane.y >= 0 ? max.y : min.y,
+				plane.z >= 0 ? max.z : min.z
+			};
+
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	size_t Frustum::CullSpheres(const BoundingSphereBatch& spheres, std::vector<uint8_t>& visible) const {
+		const size_t count = spheres.Size();
+		visible.assign(count, 1);
+
+		const float* x = spheres.x.data();
+		const float* y = spheres.y.data();
+		const float* z = spheres.z.data();
+		const float* radius = spheres.radius.data();
+		uint8_t* result = visible.data();
+
+		// Branch free inner loop over packed arrays so the compiler can vectorise it for whatever SIMD width the target has
+		for (const glm::vec4& plane : planes) {
+			const float nx = plane.x, ny = plane.y, nz = plane.z, d = plane.w;
+			for (size_t i = 0; i < count; ++i) {
+				const float distance = nx * x[i] + ny * y[i] + nz * z[i] + d;
+				result[i] &= static_cast<uint8_t>(distance >= -radius[i]);
+			}
+		}
+
+		size_t visibleCount = 0;
+		for (size_t i = 0; i < count; ++i)
+			visibleCount += result[i];
+
+		return visibleCount;
+	}
+}
\ No newline at end of file
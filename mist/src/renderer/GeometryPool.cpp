@@ -0,0 +1,19 @@
+#include "renderer/GeometryPool.hpp"
+#include "Debug.hpp"
+#include "Application.hpp"
+#include "renderer/vulkan/VulkanGeometryPool.hpp"
+
+namespace mist {
+	Scope<GeometryPool> GeometryPool::Create() {
+		switch (Application::Get().GetRenderAPI()->GetAPI()) {
+		case RenderAPI::API::None:
+			MIST_ASSERT(false, "None render API not supported");
+			return nullptr;
+		case RenderAPI::API::Vulkan:
+			return CreateScope<VulkanGeometryPool>();
+		default:
+			MIST_ASSERT(false, "Unknown render API");
+			return nullptr;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include "renderer/RangeAllocator.hpp"
+#include <algorithm>
+#include "Debug.hpp"
+
+namespace mist {
+	RangeAllocator::RangeAllocator(const uint32_t capacity) {
+		Grow(capacity);
+	}
+
+	uint32_t RangeAllocator::Allocate(const uint32_t size) {
+		if (size == 0)
+			return INVALID_OFFSET;
+
+		for (size_t i = 0; i < freeBlocks.size(); ++i) {
+			Block& block = freeBlocks[i];
+			if (block.size < size)
+				continue;
+
+			const uint32_t offset = block.offset;
+			block.offset += size;
+			block.size -= size;
+			if (block.size == 0)
+				freeBlocks.erase(freeBlocks.begin() + i);
+
+			used += size;
+			return offset;
+		}
+
+		return INVALID_OFFSET;
+	}
+
+	void RangeAllocator::Free(const uint32_t offset, const uint32_t size) {
+		if (size == 0)
+			return;
+
+		MIST_ASSERT(offset + size <= capacity, "Freeing outside of the allocator range");
+		auto next = std::lower_bound(freeBlocks.begin(), freeBlocks.end(), offset, [](const Block& block, const uint32_t value) {
+			return block.offset < value;
+		});
+
+		const bool mergePrevious = next != freeBlocks.begin() && (next - 1)->offset + (next - 1)->size == offset;
+		const bool mergeNext = next != freeBlocks.end() && offset + size == next->offset;
+
+		if (mergePrevious && mergeNext) {
+			(next - 1)->size += size + next->size;
+			freeBlocks.erase(next);
+		} else if (mergePrevious) {
+			(next - 1)->size += size;
+		} else if (mergeNext) {
+			next->offset = offset;
+			next->size += size;
+		} else {
+			freeBlocks.insert(next, { offset, size });
+		}
+
+		used -= size;
+	}
+
+	void RangeAllocator::Grow(const uint32_t newCapacity) {
+		if (newCapacity <= capacity)
+			return;
+
+		const uint32_t added = newCapacity - capacity;
+		if (!freeBlocks.empty() && freeBlocks.back().offset + freeBlocks.back().size == capacity)
+			freeBlocks.back().size += added;
+		else
+			freeBlocks.push_back({ capacity, added });
+
+		capacity = newCapacity;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "renderer/RenderGraph.hpp"
+#include <algorithm>
+#include <unordered_set>
+#include "Debug.hpp"
+#include "Application.hpp"
+#include "renderer/vulkan/VulkanRenderGraph.hpp"
+
+namespace mist {
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::Read(const RenderGraphTexture texture) {
+		MIST_ASSERT(texture < graph.textures.size(), "Render graph texture does not exist");
+		graph.passes[pass].reads.push_back({ texture, RenderGraphAccess::ShaderRead });
+		graph.compiled = false;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteColor(const RenderGraphTexture texture, const bool clear) {
+		return Write(texture, RenderGraphAccess::ColorAttachment, clear);
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::WriteDepth(const RenderGraphTexture texture, const bool clear) {
+		return Write(texture, RenderGraphAccess::DepthAttachment, clear);
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::Write(const RenderGraphTexture texture, const RenderGraphAccess access, const bool clear) {
+		MIST_ASSERT(texture < graph.textures.size(), "Render graph texture does not exist");
+		PassNode& node = graph.passes[pass];
+		const TextureNode& written = graph.textures[texture];
+
+		// An imported render data brings its own render pass, so it cannot share one with other attachments
+		if (written.IsImported()) {
+			MIST_ASSERT(node.writes.empty() || node.renderData == written.renderData, "A pass writing a render data can not write other attachments");
+			MIST_ASSERT(clear, "Render data passes always clear their attachments");
+			node.renderData = written.renderData;
+		} else {
+			MIST_ASSERT(node.renderData == nullptr, "A pass writing a render data can not write other attachments");
+		}
+
+		node.writes.push_back({ texture, access, clear });
+		graph.compiled = false;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::RecordInParallel() {
+		graph.passes[pass].parallelRecording = true;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::HasSideEffects() {
+		graph.passes[pass].sideEffects = true;
+		graph.compiled = false;
+		return *this;
+	}
+
+	RenderGraph::PassBuilder& RenderGraph::PassBuilder::Execute(ExecuteFunc func) {
+		graph.passes[pass].execute = std::move(func);
+		return *this;
+	}
+
+	RenderGraphTexture RenderGraph::CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc) {
+		TextureNode& texture = textures.emplace_back();
+		texture.name = name;
+		texture.desc = desc;
+		compiled = false;
+		return static_cast<RenderGraphTexture>(textures.size() - 1);
+	}
+
+	void RenderGraph::ResizeTexture(const RenderGraphTexture texture, const uint32_t width, const uint32_t height) {
+		MIST_ASSERT(!textures[texture].IsImported(), "Imported textures are resized through their render data");
+		textures[texture].desc.width = width;
+		textures[texture].desc.height = height;
+		compiled = false;
+	}
+
+	RenderGraphTexture RenderGraph::ImportRenderData(const std::string& name, const Ref<RenderData>& renderData) {
+		TextureNode& texture = textures.emplace_back();
+		texture.name = name;
+		texture.renderData = renderData;
+		texture.desc.width = renderData->GetProperties().width;
+		texture.desc.height = renderData->GetProperties().height;
+		texture.desc.format = renderData->GetProperties().attachments[0].textureFormat;
+		compiled = false;
+		return static_cast<RenderGraphTexture>(textures.size() - 1);
+	}
+
+	RenderGraph::PassBuilder RenderGraph::AddPass(const std::string& name) {
+		passes.emplace_back().name = name;
+		compiled = false;
+		return PassBuilder(*this, static_cast<uint32_t>(passes.size() - 1));
+	}
+
+	void RenderGraph::Compile() {
+		CullPasses();
+		BuildBarriers();
+
+		for (TextureNode& texture : textures) {
+			texture.firstPass = UINT32_MAX;
+			texture.lastPass = 0;
+		}
+
+		for (uint32_t i = 0; i < passes.size(); ++i) {
+			if (passes[i].culled)
+				continue;
+
+			for (const std::vector<TextureAccess>* accesses : { &passes[i].reads, &passes[i].writes }) {
+				for (const TextureAccess& access : *accesses) {
+					TextureNode& texture = textures[access.texture];
+					texture.firstPass = std::min(texture.firstPass, i);
+					texture.lastPass = std::max(texture.lastPass, i);
+				}
+			}
+		}
+
+		OnCompile();
+		compiled = true;
+	}
+
+	void RenderGraph::CullPasses() {
+		// Walks backwards tracking textures a later pass still needs the contents of. A pass survives if it writes
+		// one of them or an imported texture or has side effects, a clear ends the need for whatever came before it
+		std::unordered_set<RenderGraphTexture> needed;
+		for (size_t i = passes.size(); i-- > 0;) {
+			PassNode& pass = passes[i];
+			pass.culled = !pass.sideEffects;
+			for (const TextureAccess& write : pass.writes) {
+				if (textures[write.texture].IsImported() || needed.contains(write.texture))
+					pass.culled = false;
+			}
+
+			if (pass.culled)
+				continue;
+
+			for (const TextureAccess& write : pass.writes) {
+				if (write.clear)
+					needed.erase(write.texture);
+				else
+					needed.insert(write.texture);
+			}
+
+			for (const TextureAccess& read : pass.reads)
+				needed.insert(read.texture);
+		}
+	}
+
+	void RenderGraph::BuildBarriers() {
+		std::vector<RenderGraphAccess> states(textures.size(), RenderGraphAccess::None);
+		for (PassNode& pass : passes) {
+			pass.barriers.clear();
+			if (pass.culled)
+				continue;
+
+			// Reads of the same kind can overlap, anything involving a write has to wait for what came before
+			for (const TextureAccess& read : pass.reads) {
+				if (states[read.texture] == read.access)
+					continue;
+
+				pass.barriers.push_back({ read.texture, states[read.texture], read.access });
+				states[read.texture] = read.access;
+			}
+
+			for (const TextureAccess& write : pass.writes) {
+				MIST_ASSERT(std::none_of(pass.reads.begin(), pass.reads.end(), [&write](const TextureAccess& read) { return read.texture == write.texture; }), "A pass can not read and write the same texture");
+				pass.barriers.push_back({ write.texture, states[write.texture], write.access });
+				states[write.texture] = write.access;
+			}
+		}
+	}
+
+	RenderGraphAliasing RenderGraph::AssignAliases(const std::vector<RenderGraphMemoryRequirements>& requirements) const {
+		RenderGraphAliasing aliasing;
+		aliasing.textureBlocks.assign(textures.size(), RenderGraphAliasing::INVALID_BLOCK);
+
+		std::vector<RenderGraphTexture> order;
+		for (RenderGraphTexture i = 0; i < textures.size(); ++i) {
+			if (!textures[i].IsImported() && textures[i].IsUsed())
+				order.push_back(i);
+		}
+		std::sort(order.begin(), order.end(), [this](const RenderGraphTexture a, const RenderGraphTexture b) { return textures[a].firstPass < textures[b].firstPass; });
+
+		std::vector<uint32_t> blockLastPass;
+		for (const RenderGraphTexture texture : order) {
+			const RenderGraphMemoryRequirements& required = requirements[texture];
+			const TextureNode& node = textures[texture];
+
+			// Prefers the smallest free block that already fits, then the largest one to grow as little memory as possible
+			uint32_t chosen = RenderGraphAliasing::INVALID_BLOCK;
+			for (uint32_t block = 0; block < aliasing.blocks.size(); ++block) {
+				if (blockLastPass[block] >= node.firstPass || (aliasing.blocks[block].compatibleMask & required.compatibleMask) == 0)
+					continue;
+
+				if (chosen == RenderGraphAliasing::INVALID_BLOCK) {
+					chosen = block;
+					continue;
+				}
+
+				const uint64_t chosenSize = aliasing.blocks[chosen].size;
+				const uint64_t blockSize = aliasing.blocks[block].size;
+				const bool chosenFits = chosenSize >= required.size;
+				const bool blockFits = blockSize >= required.size;
+				if ((blockFits && (!chosenFits || blockSize < chosenSize)) || (!blockFits && !chosenFits && blockSize > chosenSize))
+					chosen = block;
+			}
+
+			if (chosen == RenderGraphAliasing::INVALID_BLOCK) {
+				chosen = static_cast<uint32_t>(aliasing.blocks.size());
+				aliasing.blocks.push_back({ 0, UINT32_MAX });
+				blockLastPass.push_back(0);
+			}
+
+			RenderGraphMemoryRequirements& block = aliasing.blocks[chosen];
+			block.size = std::max(block.size, required.size);
+			block.compatibleMask &= required.compatibleMask;
+			blockLastPass[chosen] = node.lastPass;
+			aliasing.textureBlocks[texture] = chosen;
+		}
+
+		return aliasing;
+	}
+
+	Scope<RenderGraph> RenderGraph::Create() {
+		switch (Application::Get().GetRenderAPI()->GetAPI()) {
+		case RenderAPI::API::None:
+			MIST_ASSERT(false, "None render API not supported");
+			return nullptr;
+		case RenderAPI::API::Vulkan:
+			return CreateScope<VulkanRenderGraph>();
+		default:
+			MIST_ASSERT(false, "Unknown render API");
+			return nullptr;
+		}
+	}
+}
\ No newline at end of file
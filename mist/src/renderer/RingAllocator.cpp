@@ -0,0 +1,54 @@
+#include "renderer/RingAllocator.hpp"
+#include "Debug.hpp"
+
+namespace mist {
+	RingAllocator::RingAllocator(const uint64_t capacity) {
+		Reset(capacity);
+	}
+
+	uint64_t RingAllocator::Allocate(const uint64_t size) {
+		// Head never catches up to tail from behind, so head == tail always means empty
+		if (head >= tail) {
+			if (capacity - head >= size) {
+				const uint64_t offset = head;
+				head += size;
+				return offset;
+			}
+
+			if (tail > size) {
+				head = size;
+				return 0;
+			}
+
+			return INVALID_OFFSET;
+		}
+
+		if (tail - head > size) {
+			const uint64_t offset = head;
+			head += size;
+			return offset;
+		}
+
+		return INVALID_OFFSET;
+	}
+
+	void RingAllocator::Submit(const uint64_t value) {
+		MIST_ASSERT(submissions.empty() || submissions.back().value < value, "Ring submissions must be made in increasing order");
+		submissions.push_back({ value, head });
+	}
+
+	void RingAllocator::Retire(const uint64_t value) {
+		// Older submissions are freed along with it, retiring one that was already covered does nothing
+		while (!submissions.empty() && submissions.front().value <= value) {
+			tail = submissions.front().end;
+			submissions.pop_front();
+		}
+	}
+
+	void RingAllocator::Reset(const uint64_t newCapacity) {
+		submissions.clear();
+		capacity = newCapacity;
+		head = 0;
+		tail = 0;
+	}
+}
\ No newline at end of file
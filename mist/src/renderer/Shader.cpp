@@ -30,15 +30,34 @@ namespace mist {
 		return nullptr;
 	}
 
+	std::vector<Ref<Shader>> Shader::CreateBatch(const std::vector<std::string>& paths, ThreadPool& threadPool) {
+		switch (Application::Get().GetRenderAPI()->GetAPI()) {
+		case RenderAPI::None:
+			MIST_ASSERT(false, "No render API set");
+			return {};
+		case RenderAPI::Vulkan:
+			return VulkanShader::CreateBatch(paths, threadPool);
+		}
+
+		MIST_ASSERT(false, "Unsupported API selected");
+		return {};
+	}
+
 	void ShaderLibrary::Add(const Ref<Shader>& shader) {
 		auto& name = shader->GetName();
 		MIST_ASSERT(!Exists(name), "Shader already exists.");
 		shaders[name] = shader;
+		handles[name] = static_cast<ShaderHandle>(handleShaders.size());
+		handleShaders.push_back(shader);
+		WatchSource(shader);
 	}
 
 	void ShaderLibrary::Add(const std::string& name, const Ref<Shader>& shader) {
 		MIST_ASSERT(!Exists(name), "Shader already exists.");
 		shaders[name] = shader;
+		handles[name] = static_cast<ShaderHandle>(handleShaders.size());
+		handleShaders.push_back(shader);
+		WatchSource(shader);
 	}
 
 	Ref<Shader> ShaderLibrary::Load(const std::string& path) {
@@ -53,12 +72,130 @@ namespace mist {
 		return shader;
 	}
 
+	std::vector<Ref<Shader>> ShaderLibrary::LoadBatch(const std::vector<std::string>& paths) {
+		std::vector<Ref<Shader>> loaded = Shader::CreateBatch(paths, *Application::Get().GetThreadPool());
+		for (const Ref<Shader>& shader : loaded) {
+			if (shader != nullptr)
+				Add(shader);
+		}
+
+		return loaded;
+	}
+
 	Ref<Shader> ShaderLibrary::Get(const std::string& name) {
 		MIST_ASSERT(Exists(name), "Shader not found");
 		return shaders[name];
 	}
 
+	ShaderHandle ShaderLibrary::GetHandle(const std::string& name) const {
+		MIST_ASSERT(Exists(name), "Shader not found");
+		return handles.at(name);
+	}
+
+	ShaderHandle ShaderLibrary::GetVariant(const ShaderHandle base, const ShaderVariantKey key) {
+		const Ref<Shader>& baseShader = handleShaders[base];
+		const ShaderVariantKey variantKey = key & baseShader->GetVariantMask();
+		if (variantKey == 0)
+			return base;
+
+		std::unordered_map<ShaderVariantKey, ShaderHandle>& variants = variantHandles[base];
+		auto variant = variants.find(variantKey);
+		if (variant != variants.end())
+			return variant->second;
+
+		Ref<Shader> shader = baseShader->CreateVariant(variantKey);
+		Add(shader);
+		const ShaderHandle handle = handles[shader->GetName()];
+		variants[variantKey] = handle;
+		return handle;
+	}
+
 	bool ShaderLibrary::Exists(const std::string& name) const {
 		return shaders.find(name) != shaders.end();
 	}
+
+	void ShaderLibrary::EnableHotReload() {
+		if (sourceWatcher != nullptr)
+			return;
+
+		sourceWatcher = FileWatcher::Create();
+		for (const Ref<Shader>& shader : handleShaders)
+			WatchSource(shader);
+	}
+
+	void ShaderLibrary::DisableHotReload() {
+		for (PendingReload& reload : pendingReloads)
+			reload.shaders.wait();
+
+		pendingReloads.clear();
+		issuedGenerations.clear();
+		appliedGenerations.clear();
+		sourceWatcher = nullptr;
+	}
+
+	void ShaderLibrary::Update() {
+		if (sourceWatcher == nullptr)
+			return;
+
+		issuedGenerations.resize(handleShaders.size(), 0);
+		appliedGenerations.resize(handleShaders.size(), 0);
+
+		for (const std::string& path : sourceWatcher->Poll()) {
+			// Variants share their base's source so they all reload together, in one task so equal defines hit the cache
+			PendingReload reload;
+			std::vector<Ref<Shader>> sources;
+			for (ShaderHandle handle = 0; handle < handleShaders.size(); ++handle) {
+				if (handleShaders[handle]->GetSourcePath() != path)
+					continue;
+
+				reload.handles.push_back(handle);
+				reload.generations.push_back(++issuedGenerations[handle]);
+				sources.push_back(handleShaders[handle]);
+			}
+
+			if (sources.empty())
+				continue;
+
+			MIST_INFO("Reloading shader: {0}", path);
+			reload.shaders = Application::Get().GetThreadPool()->Submit([sources]() {
+				std::vector<Ref<Shader>> reloaded;
+				for (const Ref<Shader>& shader : sources)
+					reloaded.push_back(shader->Recompile());
+				return reloaded;
+			});
+			pendingReloads.push_back(std::move(reload));
+		}
+
+		for (auto pending = pendingReloads.begin(); pending != pendingReloads.end();) {
+			if (pending->shaders.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				++pending;
+				continue;
+			}
+
+			std::vector<Ref<Shader>> reloaded = pending->shaders.get();
+			for (size_t i = 0; i < reloaded.size(); ++i) {
+				const ShaderHandle handle = pending->handles[i];
+				const Ref<Shader>& shader = handleShaders[handle];
+				// A later save already compiled and was swapped in, this result is from older source
+				if (pending->generations[i] < appliedGenerations[handle])
+					continue;
+
+				if (reloaded[i] == nullptr) {
+					MIST_ERROR("Failed to reload shader, keeping the previous version: {0}", shader->GetName());
+					continue;
+				}
+
+				shader->ReplaceWith(*reloaded[i]);
+				appliedGenerations[handle] = pending->generations[i];
+				MIST_INFO("Reloaded shader: {0}", shader->GetName());
+			}
+
+			pending = pendingReloads.erase(pending);
+		}
+	}
+
+	void ShaderLibrary::WatchSource(const Ref<Shader>& shader) {
+		if (sourceWatcher != nullptr && !shader->GetSourcePath().empty())
+			sourceWatcher->Watch(shader->GetSourcePath());
+	}
 }
\ No newline at end of file
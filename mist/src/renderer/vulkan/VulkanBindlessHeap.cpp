@@ -0,0 +1,187 @@
+#include "renderer/vulkan/VulkanBindlessHeap.hpp"
+#include "renderer/vulkan/VulkanContext.hpp"
+#include "renderer/vulkan/VulkanDebug.hpp"
+#include "Debug.hpp"
+#include "Log.hpp"
+#include <algorithm>
+
+namespace mist {
+	static constexpr uint32_t MAX_BINDLESS_DESCRIPTORS = 16384;
+
+	void VulkanBindlessHeap::Initialize() {
+		VulkanContext& context = VulkanContext::GetContext();
+		if (!context.IsBindlessSupported()) {
+			MIST_INFO("Descriptor indexing unsupported, bindless heap disabled");
+			return;
+		}
+
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProperties {};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &indexingProperties;
+		vkGetPhysicalDeviceProperties2(context.GetPhysicalDevice(), &properties);
+
+		storageBuffers = IndexPool();
+		sampledImages = IndexPool();
+		storageBuffers.capacity = std::min(MAX_BINDLESS_DESCRIPTORS, indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers);
+		sampledImages.capacity = std::min(MAX_BINDLESS_DESCRIPTORS, indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages);
+		storageBuffers.retired.resize(context.MAX_FRAMES_IN_FLIGHT);
+		sampledImages.retired.resize(context.MAX_FRAMES_IN_FLIGHT);
+
+		VkDescriptorSetLayoutBinding bindings[2] {};
+		bindings[0].binding = STORAGE_BUFFER_BINDING;
+		bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[0].descriptorCount = storageBuffers.capacity;
+		bindings[0].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+		bindings[1].binding = SAMPLED_IMAGE_BINDING;
+		bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		bindings[1].descriptorCount = sampledImages.capacity;
+		bindings[1].stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+
+		// Entries can be written while the set is bound and unused entries may stay empty
+		const VkDescriptorBindingFlags bindingFlags[2] = {
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT,
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+		};
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo {};
+		flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		flagsInfo.bindingCount = 2;
+		flagsInfo.pBindingFlags = bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &flagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = 2;
+		layoutInfo.pBindings = bindings;
+		CheckVkResult(vkCreateDescriptorSetLayout(context.GetDevice(), &layoutInfo, context.GetAllocationCallbacks(), &layout));
+
+		VkDescriptorPoolSize poolSizes[2] = {
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBuffers.capacity },
+			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, sampledImages.capacity }
+		};
+
+		VkDescriptorPoolCreateInfo poolInfo {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 2;
+		poolInfo.pPoolSizes = poolSizes;
+		CheckVkResult(vkCreateDescriptorPool(context.GetDevice(), &poolInfo, context.GetAllocationCallbacks(), &pool));
+
+		VkDescriptorSetAllocateInfo allocationInfo {};
+		allocationInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocationInfo.descriptorPool = pool;
+		allocationInfo.descriptorSetCount = 1;
+		allocationInfo.pSetLayouts = &layout;
+		CheckVkResult(vkAllocateDescriptorSets(context.GetDevice(), &allocationInfo, &descriptorSet));
+
+		MIST_INFO("Created bindless heap");
+	}
+
+	void VulkanBindlessHeap::Cleanup() {
+		VulkanContext& context = VulkanContext::GetContext();
+
+		if (pool != VK_NULL_HANDLE) {
+			vkDestroyDescriptorPool(context.GetDevice(), pool, context.GetAllocationCallbacks());
+			pool = VK_NULL_HANDLE;
+			descriptorSet = VK_NULL_HANDLE;
+		}
+
+		if (layout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(context.GetDevice(), layout, context.GetAllocationCallbacks());
+			layout = VK_NULL_HANDLE;
+			MIST_INFO("Destroyed bindless heap");
+		}
+	}
+
+	uint32_t VulkanBindlessHeap::AddStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+		MIST_ASSERT(IsCreated(), "Bindless heap is not available on this device");
+		RecycleRetired();
+		const uint32_t index = storageBuffers.Acquire();
+
+		VkDescriptorBufferInfo bufferInfo {};
+		bufferInfo.buffer = buffer;
+		bufferInfo.offset = offset;
+		bufferInfo.range = range;
+
+		VkWriteDescriptorSet write {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = STORAGE_BUFFER_BINDING;
+		write.dstArrayElement = index;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write.descriptorCount = 1;
+		write.pBufferInfo = &bufferInfo;
+		vkUpdateDescriptorSets(VulkanContext::GetContext().GetDevice(), 1, &write, 0, nullptr);
+		return index;
+	}
+
+	uint32_t VulkanBindlessHeap::AddSampledImage(VkImageView view, VkImageLayout imageLayout) {
+		MIST_ASSERT(IsCreated(), "Bindless heap is not available on this device");
+		RecycleRetired();
+		const uint32_t index = sampledImages.Acquire();
+
+		VkDescriptorImageInfo imageInfo {};
+		imageInfo.imageView = view;
+		imageInfo.imageLayout = imageLayout;
+
+		VkWriteDescriptorSet write {};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = descriptorSet;
+		write.dstBinding = SAMPLED_IMAGE_BINDING;
+		write.dstArrayElement = index;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+		write.descriptorCount = 1;
+		write.pImageInfo = &imageInfo;
+		vkUpdateDescriptorSets(VulkanContext::GetContext().GetDevice(), 1, &write, 0, nullptr);
+		return index;
+	}
+
+	void VulkanBindlessHeap::RemoveStorageBuffer(const uint32_t index) {
+		RecycleRetired();
+		storageBuffers.Release(VulkanContext::GetContext().GetCurrentFrameIndex(), index);
+	}
+
+	void VulkanBindlessHeap::RemoveSampledImage(const uint32_t index) {
+		RecycleRetired();
+		sampledImages.Release(VulkanContext::GetContext().GetCurrentFrameIndex(), index);
+	}
+
+	void VulkanBindlessHeap::Bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, const uint32_t set) const {
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, 1, &descriptorSet, 0, nullptr);
+	}
+
+	void VulkanBindlessHeap::RecycleRetired() {
+		// First use in a new frame, the fence for this frame has been waited on so indices it retired are unused
+		const uint32_t frameIndex = VulkanContext::GetContext().GetCurrentFrameIndex();
+		if (frame == static_cast<int64_t>(frameIndex))
+			return;
+
+		frame = frameIndex;
+		storageBuffers.Recycle(frameIndex);
+		sampledImages.Recycle(frameIndex);
+	}
+
+	uint32_t VulkanBindlessHeap::IndexPool::Acquire() {
+		if (!freeIndices.empty()) {
+			const uint32_t index = freeIndices.back();
+			freeIndices.pop_back();
+			return index;
+		}
+
+		MIST_ASSERT(next < capacity, "Bindless heap is full");
+		return next++;
+	}
+
+	void VulkanBindlessHeap::IndexPool::Release(const uint32_t frameIndex, const uint32_t index) {
+		retired[frameIndex].push_back(index);
+	}
+
+	void VulkanBindlessHeap::IndexPool::Recycle(const uint32_t frameIndex) {
+		freeIndices.insert(freeIndices.end(), retired[frameIndex].begin(), retired[frameIndex].end());
+		retired[frameIndex].clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace mist {
+	// One large update after bind descriptor set holding every storage buffer and sampled image registered with it.
+	// Shaders opt in by declaring the arrays at the material set and pick entries by an index from their per draw data,
+	// so the set is bound once per pipeline layout rather than once per draw
+	//
+	//	layout(std430, set = 1, binding = 0) readonly buffer Buffers { ... } buffers[];
+	//	layout(set = 1, binding = 1) uniform texture2D textures[];
+	class VulkanBindlessHeap {
+	public:
+		static constexpr uint32_t STORAGE_BUFFER_BINDING = 0;
+		static constexpr uint32_t SAMPLED_IMAGE_BINDING = 1;
+
+		// Does nothing when the device lacks descriptor indexing, IsCreated reports which happened
+		void Initialize();
+		void Cleanup();
+
+		// Indices stay valid until removed, removal is deferred until frames still using the index have finished
+		uint32_t AddStorageBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range);
+		uint32_t AddSampledImage(VkImageView view, VkImageLayout layout);
+		void RemoveStorageBuffer(const uint32_t index);
+		void RemoveSampledImage(const uint32_t index);
+
+		void Bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, const uint32_t set) const;
+
+		inline const bool IsCreated() const { return descriptorSet != VK_NULL_HANDLE; }
+		inline const VkDescriptorSetLayout GetLayout() const { return layout; }
+	private:
+		struct IndexPool {
+			uint32_t capacity = 0;
+			uint32_t next = 0;
+			std::vector<uint32_t> freeIndices;
+			std::vector<std::vector<uint32_t>> retired;	// Per frame in flight, reusable once that frame comes around again
+
+			uint32_t Acquire();
+			void Release(const uint32_t frameIndex, const uint32_t index);
+			void Recycle(const uint32_t frameIndex);
+		};
+
+		void RecycleRetired();
+
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		IndexPool storageBuffers;
+		IndexPool sampledImages;
+		int64_t frame = -1;
+	};
+}
\ No newline at end of file
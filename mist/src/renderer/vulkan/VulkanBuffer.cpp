@@ -3,6 +3,7 @@
 #include "Log.hpp"
 #include "renderer/vulkan/VulkanContext.hpp"
 #include "Debug.hpp"
+#include <algorithm>
 
 namespace mist {
 	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VmaAllocation& bufferAlloc, VmaMemoryUsage allocUsage, VmaAllocationCreateFlags allocFlags, VmaAllocationInfo& info) {
@@ -21,33 +22,22 @@ namespace mist {
 		CheckVkResult(vmaCreateBuffer(context.GetAllocator(), &bufferInfo, &allocCreateInfo, &buffer, &bufferAlloc, &info));
 	}
 
-	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset) {
 		VulkanContext& context = VulkanContext::GetContext();
 		context.BeginSingleTimeCommands();
 		
 		VkBufferCopy copyRegion {};
 		copyRegion.srcOffset = 0;
-		copyRegion.dstOffset = 0;
+		copyRegion.dstOffset = dstOffset;
 		copyRegion.size = size;
 		vkCmdCopyBuffer(context.GetTempCommandBuffer(), srcBuffer, dstBuffer, 1, &copyRegion);
 		
 		context.EndSingleTimeCommands();
 	}
 	
-	void SetBufferData(const void* data, VkDeviceSize size, VkBuffer& buffer) {
+	void SetBufferData(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize dstOffset) {
 		VulkanContext& context = VulkanContext::GetContext();
-		
-		VkBuffer stagingBuffer;
-		VmaAllocation stagingAlloc;
-		VmaAllocationInfo info {};
-		CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffer, stagingAlloc, VMA_MEMORY_USAGE_CPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, info);
-		
-		memcpy(info.pMappedData, data, size);
-		vmaFlushAllocation(context.GetAllocator(), stagingAlloc, 0, size);
-
-		CopyBuffer(stagingBuffer, buffer, size);
-
-		vmaDestroyBuffer(context.GetAllocator(), stagingBuffer, stagingAlloc);
+		context.GetStagingRing().Upload(context.GetCurrentFrameIndex(), data, size, buffer, dstOffset);
 	}
 	
 	VulkanVertexBuffer::VulkanVertexBuffer(uint32_t count) {
@@ -132,8 +122,10 @@ namespace mist {
 	void VulkanIndexBuffer::Clear() {
 		VulkanContext& context = VulkanContext::GetContext();
 		
-		if (indexBuffer != VK_NULL_HANDLE)
+		if (indexBuffer != VK_NULL_HANDLE) {
 			vmaDestroyBuffer(context.GetAllocator(), indexBuffer, indexAlloc);
+			indexBuffer = VK_NULL_HANDLE;
+		}
 
 		MIST_INFO("Destroyed index buffer");
 	}
@@ -148,50 +140,139 @@ namespace mist {
 		SetBufferData(indices.data(), size, indexBuffer);
 	}
 	
-	UniformBuffer::UniformBuffer() : size(0) {
-		MIST_WARN("Created new uniform buffer but no buffer allocated yet");
-	}
-	
-	UniformBuffer::UniformBuffer(uint32_t size, void* data) : size(size) {
+	StorageBuffer::StorageBuffer(VkDeviceSize size, VkBufferUsageFlags usage) : size(size) {
 		VmaAllocationInfo info {};
-		CreateBuffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, uboBuffer, uboAlloc, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, info);
-		SetData(size, data);
-		MIST_INFO("Created new uniform buffer and set data");
+		CreateBuffer(size, usage, storageBuffer, storageAlloc, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, info);
+		mappedData = info.pMappedData;
+		MIST_INFO("Created new storage buffer");
 	}
-	
-	UniformBuffer::~UniformBuffer() {}
-	
-	UniformBuffer::UniformBuffer(UniformBuffer&& other) noexcept : uboBuffer(other.uboBuffer), uboAlloc(other.uboAlloc), size(other.size) {
-		other.Clear();
+
+	StorageBuffer::~StorageBuffer() {
+		Clear();
 	}
-	
-	UniformBuffer& UniformBuffer::operator=(UniformBuffer&& other) noexcept {
-		if (this != &other) {
-			this->Clear();
-			this->uboBuffer = other.uboBuffer;
-			this->uboAlloc = other.uboAlloc;
-			this->size = other.size;
-			other.Clear();
+
+	void StorageBuffer::SetData(VkDeviceSize offset, VkDeviceSize dataSize, const void* data) {
+		MIST_ASSERT(offset + dataSize <= size, "Storage buffer write out of range");
+		VulkanContext& context = VulkanContext::GetContext();
+		memcpy(static_cast<uint8_t*>(mappedData) + offset, data, dataSize);
+		vmaFlushAllocation(context.GetAllocator(), storageAlloc, offset, dataSize);
+	}
+
+	void StorageBuffer::Clear() {
+		VulkanContext& context = VulkanContext::GetContext();
+
+		if (storageBuffer != VK_NULL_HANDLE) {
+			vmaDestroyBuffer(context.GetAllocator(), storageBuffer, storageAlloc);
+			storageBuffer = VK_NULL_HANDLE;
+			mappedData = nullptr;
+			MIST_INFO("Destroyed storage buffer");
 		}
-		
-		return *this;
 	}
 
-	void UniformBuffer::SetData(uint32_t size, void* data) {
+	bool FrameLinearRegion::Fits(const VkDeviceSize size) {
+		// First use in a new frame, the fence for this frame has been waited on so its region is free again. Keyed on the
+		// frame number as a frame that skipped this buffer would otherwise leave the slot's old cursor in place
+		const uint64_t frameNumber = VulkanContext::GetContext().GetFrameNumber();
+		if (frame != frameNumber) {
+			frame = frameNumber;
+			cursor = 0;
+		}
+
+		return cursor + size <= perFrame;
+	}
+
+	bool FrameLinearRegion::Grow(const VkDeviceSize size, const VkDeviceSize minPerFrame) {
+		VkDeviceSize newPerFrame = std::max(perFrame * 2, minPerFrame);
+		while (newPerFrame < cursor + size)
+			newPerFrame *= 2;
+
+		const bool grewMidFrame = perFrame > 0 && cursor > 0;
+		perFrame = newPerFrame;
+		return grewMidFrame;
+	}
+
+	VkDeviceSize FrameLinearRegion::Allocate(const uint32_t frameIndex, const VkDeviceSize size) {
+		MIST_ASSERT(frame == VulkanContext::GetContext().GetFrameNumber() && cursor + size <= perFrame, "Reserve must be called before writing");
+		const VkDeviceSize offset = frameIndex * perFrame + cursor;
+		cursor += size;
+		return offset;
+	}
+
+	void FrameLinearRegion::Clear() {
+		perFrame = 0;
+		cursor = 0;
+		frame = UINT64_MAX;
+	}
+
+	FrameRegionBuffer::FrameRegionBuffer(VkBufferUsageFlags usage, uint32_t elementSize, uint32_t minElementsPerFrame)
+		: usage(usage), elementSize(elementSize), minElementsPerFrame(minElementsPerFrame) {}
+
+	bool FrameRegionBuffer::Reserve(const uint32_t frameIndex, const uint32_t count) {
+		if (region.Fits(count) && buffer != nullptr)
+			return false;
+
 		VulkanContext& context = VulkanContext::GetContext();
-		
-		void* mappedData;
-		vmaMapMemory(context.GetAllocator(), uboAlloc, &mappedData);
-		memcpy(mappedData, data, size);
-		vmaUnmapMemory(context.GetAllocator(), uboAlloc);
+		region.Grow(count, minElementsPerFrame);
+
+		// Frames in flight and commands already recorded this frame still read the old buffer, which keeps what they
+		// wrote. Elements written from here on go to the new one
+		if (buffer != nullptr)
+			context.DeferRelease([retired = Ref<StorageBuffer>(std::move(buffer))]() mutable { retired = nullptr; });
+
+		buffer = CreateScope<StorageBuffer>(static_cast<VkDeviceSize>(elementSize) * region.GetPerFrame() * context.MAX_FRAMES_IN_FLIGHT, usage);
+		return true;
 	}
 
-	void UniformBuffer::Clear() {
+	uint32_t FrameRegionBuffer::Write(const uint32_t frameIndex, const void* data, const uint32_t count) {
+		const uint32_t first = static_cast<uint32_t>(region.Allocate(frameIndex, count));
+		buffer->SetData(static_cast<VkDeviceSize>(elementSize) * first, static_cast<VkDeviceSize>(elementSize) * count, data);
+		return first;
+	}
+
+	void FrameRegionBuffer::Clear() {
+		buffer = nullptr;
+		region.Clear();
+	}
+
+	UniformArena::UniformArena(VkDeviceSize minBytesPerFrame) : minBytesPerFrame(minBytesPerFrame) {}
+
+	bool UniformArena::Reserve(const uint32_t frameIndex, const VkDeviceSize size) {
 		VulkanContext& context = VulkanContext::GetContext();
+		if (alignment == 0) {
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(context.GetPhysicalDevice(), &properties);
+			alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 16);
+		}
 
-		if (uboBuffer != VK_NULL_HANDLE)
-			vmaDestroyBuffer(context.GetAllocator(), uboBuffer, uboAlloc);
-		
-		MIST_INFO("Destroyed uniform buffer");
+		const VkDeviceSize alignedSize = (size + alignment - 1) & ~(alignment - 1);
+		if (region.Fits(alignedSize) && buffer != nullptr)
+			return false;
+
+		const VkDeviceSize oldFrameOffset = GetFrameOffset(frameIndex);
+		const bool grewMidFrame = region.Grow(alignedSize, (minBytesPerFrame + alignment - 1) & ~(alignment - 1));
+		Ref<StorageBuffer> retired = std::move(buffer);
+		buffer = CreateScope<StorageBuffer>(region.GetPerFrame() * context.MAX_FRAMES_IN_FLIGHT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+		if (retired == nullptr)
+			return true;
+
+		// Binds still to come this frame use offsets from earlier writes, which are relative to the frame's region
+		if (grewMidFrame)
+			buffer->SetData(GetFrameOffset(frameIndex), region.GetUsed(), static_cast<const uint8_t*>(retired->GetMappedData()) + oldFrameOffset);
+
+		// Frames in flight and commands already recorded this frame still read the old buffer
+		context.DeferRelease([retired]() mutable { retired = nullptr; });
+		return true;
+	}
+
+	uint32_t UniformArena::Write(const uint32_t frameIndex, const void* data, const VkDeviceSize size) {
+		const VkDeviceSize alignedSize = (size + alignment - 1) & ~(alignment - 1);
+		const VkDeviceSize offset = region.Allocate(frameIndex, alignedSize);
+		buffer->SetData(offset, size, data);
+		return static_cast<uint32_t>(offset - GetFrameOffset(frameIndex));
+	}
+
+	void UniformArena::Clear() {
+		buffer = nullptr;
+		region.Clear();
 	}
 }
\ No newline at end of file
@@ -2,8 +2,14 @@
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
 #include "renderer/Buffer.hpp"
+#include "Core.hpp"
 
 namespace mist {
+	void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer& buffer, VmaAllocation& bufferAlloc, VmaMemoryUsage allocUsage, VmaAllocationCreateFlags allocFlags, VmaAllocationInfo& info);
+	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+	// Queued on the staging ring, the copy runs ahead of this frame's draws
+	void SetBufferData(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize dstOffset = 0);
+
 	class VulkanVertexBuffer : public VertexBuffer {
 	public:
 		VulkanVertexBuffer(uint32_t count);
@@ -41,23 +47,93 @@ namespace mist {
 		VmaAllocation indexAlloc;
 	};
 
-	class UniformBuffer {
+	// Host visible buffer that stays mapped for its whole lifetime
+	class StorageBuffer {
 	public:
-		UniformBuffer();
-		UniformBuffer(uint32_t size, void* data);
-		~UniformBuffer();
+		StorageBuffer(VkDeviceSize size, VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		~StorageBuffer();
 
-		UniformBuffer(UniformBuffer&& other) noexcept;
-		UniformBuffer& operator=(UniformBuffer&& other) noexcept;
+		StorageBuffer(const StorageBuffer&) = delete;
+		StorageBuffer& operator=(const StorageBuffer&) = delete;
 
-		void SetData(uint32_t size, void* data);
+		void SetData(VkDeviceSize offset, VkDeviceSize size, const void* data);
 		void Clear();
 
-		const VkBuffer& GetBuffer() const { return uboBuffer; }
+		const VkBuffer& GetBuffer() const { return storageBuffer; }
 		const VkDeviceSize GetSize() const { return size; }
+		const void* GetMappedData() const { return mappedData; }
 	private:
-		VkBuffer uboBuffer;
-		VmaAllocation uboAlloc;
+		VkBuffer storageBuffer = VK_NULL_HANDLE;
+		VmaAllocation storageAlloc;
 		VkDeviceSize size;
+		void* mappedData = nullptr;
+	};
+
+	// Linear allocation within one region per frame in flight, in whatever unit the owning buffer counts in
+	class FrameLinearRegion {
+	public:
+		// Restarts the region on the first use of each frame, then checks if size more units still fit
+		bool Fits(const VkDeviceSize size);
+		// Grows the per frame capacity to hold size more units, returns true if it grew after this frame had allocated
+		bool Grow(const VkDeviceSize size, const VkDeviceSize minPerFrame);
+		// Returns the offset of the allocation from the start of the whole buffer
+		VkDeviceSize Allocate(const uint32_t frameIndex, const VkDeviceSize size);
+		void Clear();
+
+		inline const VkDeviceSize GetPerFrame() const { return perFrame; }
+		// Units allocated so far this frame
+		inline const VkDeviceSize GetUsed() const { return cursor; }
+	private:
+		VkDeviceSize perFrame = 0;
+		VkDeviceSize cursor = 0;
+		uint64_t frame = UINT64_MAX;	// Frame number the cursor belongs to
+	};
+
+	// Mapped buffer split into one region per frame in flight, each frame appends from the start of its own region
+	class FrameRegionBuffer {
+	public:
+		FrameRegionBuffer(VkBufferUsageFlags usage, uint32_t elementSize, uint32_t minElementsPerFrame);
+
+		// Makes room for count more elements this frame, returns true when the buffer was recreated so descriptors
+		// must point at the new one. The old buffer lives on until the frames that may use it have finished
+		bool Reserve(const uint32_t frameIndex, const uint32_t count);
+		// Appends to this frame's region and returns the index of the first element written
+		uint32_t Write(const uint32_t frameIndex, const void* data, const uint32_t count);
+		void Clear();
+
+		inline const VkBuffer GetBuffer() const { return buffer != nullptr ? buffer->GetBuffer() : VK_NULL_HANDLE; }
+		inline const uint32_t GetElementSize() const { return elementSize; }
+		inline const bool IsCreated() const { return buffer != nullptr; }
+	private:
+		Scope<StorageBuffer> buffer;
+		VkBufferUsageFlags usage;
+		uint32_t elementSize;
+		uint32_t minElementsPerFrame;
+		FrameLinearRegion region;
+	};
+
+	// Mapped uniform memory split into one region per frame in flight. Values are bump allocated at the device's
+	// offset alignment and bound through dynamic uniform descriptors, so one descriptor serves every update
+	class UniformArena {
+	public:
+		UniformArena(VkDeviceSize minBytesPerFrame);
+
+		// Makes room for size more bytes this frame, returns true when the buffer was recreated so descriptors must
+		// point at the new one. What this frame already wrote is copied across and the old buffer lives on until the
+		// frames that may use it have finished
+		bool Reserve(const uint32_t frameIndex, const VkDeviceSize size);
+		// Appends to this frame's region and returns the copy's offset within that region, which survives growth
+		uint32_t Write(const uint32_t frameIndex, const void* data, const VkDeviceSize size);
+		void Clear();
+
+		// Added to an offset from Write to get the dynamic offset to bind with
+		inline const uint32_t GetFrameOffset(const uint32_t frameIndex) const { return static_cast<uint32_t>(frameIndex * region.GetPerFrame()); }
+		inline const VkBuffer GetBuffer() const { return buffer != nullptr ? buffer->GetBuffer() : VK_NULL_HANDLE; }
+		inline const bool IsCreated() const { return buffer != nullptr; }
+	private:
+		Scope<StorageBuffer> buffer;
+		VkDeviceSize alignment = 0;
+		VkDeviceSize minBytesPerFrame;
+		FrameLinearRegion region;
 	};
 }
\ No newline at end of file
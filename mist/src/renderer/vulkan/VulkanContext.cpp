@@ -1,10 +1,12 @@
 #include "VulkanContext.hpp"
 #include <Math.hpp>
 #include <set>
+#include <cstring>
 #include <SDL3/SDL_vulkan.h>
 #include "renderer/vulkan/VulkanDebug.hpp"
 #include "Application.hpp"
 #include "Debug.hpp"
+#include "PlatformUtils.hpp"
 #include "renderer/vulkan/VulkanHelper.hpp"
 #include "renderer/vulkan/VulkanRenderData.hpp"
 
@@ -40,7 +42,19 @@ namespace mist {
 			if (indices.Valid())
 				break;
 		}
-		
+
+		// Prefer a transfer only family as those map to the copy engines, otherwise any family without graphics
+		for (uint32_t i = 0; i < count && !indices.transferFamily.has_value(); i++) {
+			if ((queues[i].queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queues[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+				indices.transferFamily = i;
+		}
+
+		for (uint32_t i = 0; i < count && !indices.transferFamily.has_value(); i++) {
+			if ((queues[i].queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT)) && !(queues[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+				indices.transferFamily = i;
+		}
+
+		free(queues);
 		return indices;
 	}
 
@@ -233,7 +247,9 @@ namespace mist {
 	void VulkanContext::CreateDevice() {
 		QueueFamilyIndices indicies = FindQueueFamilies();
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<uint32_t> uniqueQueueFamilies = { indicies.graphicsFamily.value(), indicies.presentFamily.value() };
+		graphicsQueueFamily = indicies.graphicsFamily.value();
+		transferQueueFamily = indicies.transferFamily.value_or(graphicsQueueFamily);
+		std::set<uint32_t> uniqueQueueFamilies = { graphicsQueueFamily, indicies.presentFamily.value(), transferQueueFamily };
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
 			VkDeviceQueueCreateInfo createInfo{};
@@ -248,19 +264,128 @@ namespace mist {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME
 		};
 
-		VkPhysicalDeviceFeatures deviceFeatures{};
-		vkGetPhysicalDeviceFeatures(physicalDevice, &deviceFeatures);
+		vkGetPhysicalDeviceFeatures(physicalDevice, &enabledFeatures);
+
+		// 1.3 structs may only be chained when the device itself reports 1.3
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+		const bool supportsVulkan13 = deviceProperties.apiVersion >= VK_API_VERSION_1_3;
+
+		// Uploads are tracked across the transfer and graphics queues with timeline semaphores, there is no fence only path
+		if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+			MIST_CRITICAL("{0} only supports Vulkan {1}.{2}, 1.2 or later is required", deviceProperties.deviceName, VK_API_VERSION_MAJOR(deviceProperties.apiVersion), VK_API_VERSION_MINOR(deviceProperties.apiVersion));
+			abort();
+		}
+
+		VkPhysicalDeviceVulkan13Features supported13 {};
+		supported13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		VkPhysicalDeviceVulkan12Features supported12 {};
+		supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		supported12.pNext = supportsVulkan13 ? &supported13 : nullptr;
+		VkPhysicalDeviceFeatures2 supported {};
+		supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported.pNext = &supported12;
+		vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+
+		// Core since 1.2 but still optional there
+		if (!supported12.timelineSemaphore) {
+			MIST_CRITICAL("{0} does not support timeline semaphores, which are required", deviceProperties.deviceName);
+			abort();
+		}
+
+		VkPhysicalDeviceVulkan12Features vulkan12Features {};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vulkan12Features.timelineSemaphore = VK_TRUE;
+
+		// Everything the bindless heap relies on, it is skipped when any of it is missing
+		bindlessSupported = supported12.runtimeDescriptorArray && supported12.descriptorBindingPartiallyBound &&
+			supported12.descriptorBindingStorageBufferUpdateAfterBind && supported12.descriptorBindingSampledImageUpdateAfterBind &&
+			supported12.shaderStorageBufferArrayNonUniformIndexing && supported12.shaderSampledImageArrayNonUniformIndexing;
+		if (bindlessSupported) {
+			vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+			vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+			vulkan12Features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+			vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			vulkan12Features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+			vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		}
+
+		// Render data targets are begun with vkCmdBeginRendering when available, render passes are the fallback
+		VkPhysicalDeviceVulkan13Features vulkan13Features {};
+		vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		dynamicRenderingEnabled = supportsVulkan13 && supported13.dynamicRendering;
+		if (dynamicRenderingEnabled) {
+			vulkan13Features.dynamicRendering = VK_TRUE;
+			vulkan12Features.pNext = &vulkan13Features;
+			MIST_INFO("Using dynamic rendering");
+		}
 
 		VkDeviceCreateInfo deviceCreateInfo{};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceCreateInfo.pNext = &vulkan12Features;
 		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
 		deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
 		deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
-		deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
+		deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
 		CheckVkResult(vkCreateDevice(physicalDevice, &deviceCreateInfo, allocationCallbacks, &device));
 		vkGetDeviceQueue(device, indicies.graphicsFamily.value(), 0, &graphicsQueue);
 		vkGetDeviceQueue(device, indicies.presentFamily.value(), 0, &presentQueue);
+		vkGetDeviceQueue(device, transferQueueFamily, 0, &transferQueue);
+
+		if (HasDedicatedTransferQueue())
+			MIST_INFO("Using dedicated transfer queue family " + std::to_string(transferQueueFamily));
+	}
+
+	static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+
+	void VulkanContext::CreatePipelineCache() {
+		std::vector<uint8_t> data = Utils::ReadBinaryFile(PIPELINE_CACHE_PATH);
+
+		// A cache from another GPU or driver is rejected by the header check and rebuilt from scratch,
+		// drivers are meant to do this themselves but not all of them cope with foreign data
+		if (!data.empty()) {
+			VkPhysicalDeviceProperties properties;
+			vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+			VkPipelineCacheHeaderVersionOne header {};
+			bool valid = data.size() >= sizeof(header);
+			if (valid) {
+				memcpy(&header, data.data(), sizeof(header));
+				valid = header.headerSize >= sizeof(header) && header.headerSize <= data.size() &&
+					header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+					header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+					memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+			}
+
+			if (!valid) {
+				MIST_INFO("Pipeline cache on disk is for a different device or driver, ignoring it");
+				data.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo info {};
+		info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		info.initialDataSize = data.size();
+		info.pInitialData = data.empty() ? nullptr : data.data();
+		CheckVkResult(vkCreatePipelineCache(device, &info, allocationCallbacks, &pipelineCache));
+		MIST_INFO("Created pipeline cache with " + std::to_string(data.size()) + " bytes from disk");
+	}
+
+	void VulkanContext::SavePipelineCache() {
+		if (pipelineCache == VK_NULL_HANDLE)
+			return;
+
+		size_t size = 0;
+		CheckVkResult(vkGetPipelineCacheData(device, pipelineCache, &size, nullptr));
+		std::vector<uint8_t> data(size);
+		CheckVkResult(vkGetPipelineCacheData(device, pipelineCache, &size, data.data()));
+
+		if (size > 0 && Utils::WriteBinaryFile(PIPELINE_CACHE_PATH, data.data(), size))
+			MIST_INFO("Saved pipeline cache");
+
+		vkDestroyPipelineCache(device, pipelineCache, allocationCallbacks);
+		pipelineCache = VK_NULL_HANDLE;
 	}
 
 	void VulkanContext::CreateAllocator() {
@@ -289,6 +414,17 @@ namespace mist {
 			CheckVkResult(vkCreateSemaphore(device, &semaphoreInfo, allocationCallbacks, &frameDatas[i].acquireImageSempahore));
 			CheckVkResult(vkCreateFence(device, &fenceInfo, allocationCallbacks, &frameDatas[i].inFlightFence));
 		}
+
+		if (graphicsTimeline != VK_NULL_HANDLE)
+			vkDestroySemaphore(device, graphicsTimeline, allocationCallbacks);
+
+		VkSemaphoreTypeCreateInfo typeInfo {};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+		semaphoreInfo.pNext = &typeInfo;
+		CheckVkResult(vkCreateSemaphore(device, &semaphoreInfo, allocationCallbacks, &graphicsTimeline));
+		submittedFrameNumber = 0;
 	}
 
 	void VulkanContext::Initialize() {
@@ -296,16 +432,21 @@ namespace mist {
 		CreateSurface();
 		CreatePhysicalDevice();
 		CreateDevice();
+		CreatePipelineCache();
 		CreateAllocator();
 		CreateCommandPool();
 		AllocateCommandBuffers();
 		CreateFrameDatas();
+		stagingRing.Initialize(32 * 1024 * 1024);
+		bindlessHeap.Initialize();
+		pipelineCompiler = CreateScope<ThreadPool>(PIPELINE_COMPILE_THREADS);
 		MIST_INFO("Initialised Vulkan API");
 	}
 
 	void VulkanContext::Cleanup() {
 		for (std::pair<const uint8_t, Ref<VulkanRenderData>>& data : renderDatas)
 			data.second->Cleanup();
+		pipelineCompiler = nullptr;
 		for (VkImageView& swapchainImageView : swapchainImageViews)
 			vkDestroyImageView(device, swapchainImageView, allocationCallbacks);
 
@@ -315,15 +456,33 @@ namespace mist {
 		if (swapchain != VK_NULL_HANDLE)
 			vkDestroySwapchainKHR(device, swapchain, allocationCallbacks);
 
+		vkDeviceWaitIdle(device);
+		RunDeferredReleases(UINT64_MAX);
+
+		stagingRing.Cleanup();
+		bindlessHeap.Cleanup();
+
 		if (commandPool != VK_NULL_HANDLE)
 			vkDestroyCommandPool(device, commandPool, allocationCallbacks);
 
+		for (std::vector<RecordingSlot>& slots : recordingSlots) {
+			for (RecordingSlot& slot : slots)
+				vkDestroyCommandPool(device, slot.pool, allocationCallbacks);
+		}
+		recordingSlots.clear();
+
 		for (FrameData& data : frameDatas)
 			data.Cleanup();
 
+		if (graphicsTimeline != VK_NULL_HANDLE) {
+			vkDestroySemaphore(device, graphicsTimeline, allocationCallbacks);
+			graphicsTimeline = VK_NULL_HANDLE;
+		}
+
 		if (tempCommandBufferFence != VK_NULL_HANDLE)
 			vkDestroyFence(device, tempCommandBufferFence, allocationCallbacks);
 
+		SavePipelineCache();
 		vmaDestroyAllocator(allocator);
 		vkDestroyDevice(device, allocationCallbacks);
 		SDL_Vulkan_DestroySurface(instance, surface, allocationCallbacks);
@@ -428,7 +587,8 @@ namespace mist {
 			vkDestroySwapchainKHR(device, oldSwapchain, allocationCallbacks);
 
 		vkGetSwapchainImagesKHR(device, swapchain, &swapchainImageCount, nullptr);
-		std::vector<VkImage> swapchainImages(swapchainImageCount);
+		swapchainImages.resize(swapchainImageCount);
+		swapchainFormat = selectedFormat.format;
 		vkGetSwapchainImagesKHR(device, swapchain, &swapchainImageCount, swapchainImages.data());
 
 		for (VkImageView view : swapchainImageViews)
@@ -485,8 +645,21 @@ namespace mist {
 	}
 
 	void VulkanContext::BeginFrame() {
+		++frameNumber;
 		CheckVkResult(vkWaitForFences(device, 1, &frameDatas[currentFrame].inFlightFence, VK_TRUE, UINT64_MAX));
  		CheckVkResult(vkResetFences(device, 1, &frameDatas[currentFrame].inFlightFence));
+		RunDeferredReleases(GetCompletedFrameNumber());
+
+		for (std::pair<const uint8_t, Ref<VulkanRenderData>>& data : renderDatas)
+			data.second->pipeline.PublishReadyPipelines();
+
+		// The fence means this frame's secondaries have finished so their pools can be reset in one go
+		if (currentFrame < recordingSlots.size()) {
+			for (RecordingSlot& slot : recordingSlots[currentFrame]) {
+				CheckVkResult(vkResetCommandPool(device, slot.pool, 0));
+				slot.used = 0;
+			}
+		}
 
 		VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, frameDatas[currentFrame].acquireImageSempahore, VK_NULL_HANDLE, &imageIndex);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
@@ -507,19 +680,31 @@ namespace mist {
 	void VulkanContext::EndFrame() {
 		CheckVkResult(vkEndCommandBuffer(commandBuffers[currentFrame]));
 
+		// Uploads staged this frame go first so its draws see the data
+		stagingRing.Submit(currentFrame);
+
 		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		const VkSemaphore signalSemaphores[] = { submitSemaphores[imageIndex], graphicsTimeline };
+		const uint64_t signalValues[] = { 0, frameNumber };	// Binary semaphores ignore their value
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 2;
+		timelineInfo.pSignalSemaphoreValues = signalValues;
 
 		VkSubmitInfo submitInfo{};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
 		submitInfo.waitSemaphoreCount = 1;
 		submitInfo.pWaitSemaphores = &frameDatas[currentFrame].acquireImageSempahore;
 		submitInfo.pWaitDstStageMask = waitStages;
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffers[currentFrame];
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = &submitSemaphores[imageIndex];
+		submitInfo.signalSemaphoreCount = 2;
+		submitInfo.pSignalSemaphores = signalSemaphores;
 
 		CheckVkResult(vkQueueSubmit(graphicsQueue, 1, &submitInfo, frameDatas[currentFrame].inFlightFence));
+		submittedFrameNumber = frameNumber;
 
 		VkPresentInfoKHR presentInfo{};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -540,7 +725,18 @@ namespace mist {
 		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 	}
 
-	void VulkanContext::BeginRenderPass(const uint8_t renderDataID) {
+	void VulkanContext::DeferRelease(std::function<void()> release) {
+		deferredReleases.emplace_back(frameNumber, std::move(release));
+	}
+
+	void VulkanContext::RunDeferredReleases(const uint64_t completedFrame) {
+		while (!deferredReleases.empty() && deferredReleases.front().first <= completedFrame) {
+			deferredReleases.front().second();
+			deferredReleases.pop_front();
+		}
+	}
+
+	void VulkanContext::BeginRenderPass(const uint8_t renderDataID, const bool secondaryContents) {
 		Ref<VulkanRenderData> data = renderDatas[renderDataID]; 
 		uint32_t index = imageIndex;
 		if (data->GetProperties().type != FramebufferType::SWAPCHAIN)
@@ -551,32 +747,130 @@ namespace mist {
 		clearColor.color = { color.r, color.g, color.b, color.a };
 		VkClearValue depthValue {};
 		depthValue.depthStencil = { 1.0, 0 };
+
+		activeRenderData = data;
+		activeFramebufferIndex = index;
+		activeSecondaryContents = secondaryContents;
+
+		if (dynamicRenderingEnabled) {
+			activeFramebuffer = VK_NULL_HANDLE;
+			data->BeginRendering(commandBuffers[currentFrame], index, clearColor, depthValue, secondaryContents);
+		} else {
+			activeFramebuffer = data->framebuffers[index];
+			BeginRenderPassObject(*data, index, clearColor, depthValue, secondaryContents);
+		}
+
+		// Secondaries set their own viewport and scissor as dynamic state is not inherited
+		if (secondaryContents)
+			return;
 		
+		// Using dynamic viewport and scissor so needs to be set every frame
+		vkCmdSetViewport(commandBuffers[currentFrame], 0, 1, &data->viewport);
+		vkCmdSetScissor(commandBuffers[currentFrame], 0, 1, &data->scissor);
+	}
+
+	void VulkanContext::BeginRenderPassObject(VulkanRenderData& data, const uint32_t index, const VkClearValue& clearColor, const VkClearValue& depthValue, const bool secondaryContents) {
 		std::vector<VkClearValue> clearValues;
-		if (data->GetProperties().type == FramebufferType::SWAPCHAIN)
+		if (data.GetProperties().type == FramebufferType::SWAPCHAIN)
 			clearValues.push_back(clearColor);	// Swapchain image
 			
-		for (FramebufferAttachment& attachment : data->framebufferAttachments[index])
+		for (FramebufferAttachment& attachment : data.framebufferAttachments[index])
 			clearValues.push_back(attachment.isDepth ? depthValue : clearColor); 
 			
 		VkRenderPassBeginInfo renderPassInfo {};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = data->renderPass;
-		renderPassInfo.framebuffer = data->framebuffers[index];
+		renderPassInfo.renderPass = data.renderPass;
+		renderPassInfo.framebuffer = data.framebuffers[index];
 		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = data->scissor.extent;
+		renderPassInfo.renderArea.extent = data.scissor.extent;
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffers[currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-		
-		// Using dynamic viewport and scissor so needs to be set every frame
-		vkCmdSetViewport(commandBuffers[currentFrame], 0, 1, &data->viewport);
-		vkCmdSetScissor(commandBuffers[currentFrame], 0, 1, &data->scissor);
+		vkCmdBeginRenderPass(commandBuffers[currentFrame], &renderPassInfo, secondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 	}
 
 	void VulkanContext::EndRenderPass() {
-		vkCmdEndRenderPass(commandBuffers[currentFrame]);
+		if (dynamicRenderingEnabled)
+			activeRenderData->EndRendering(commandBuffers[currentFrame], activeFramebufferIndex);
+		else
+			vkCmdEndRenderPass(commandBuffers[currentFrame]);
+
+		activeRenderData = nullptr;
+		activeFramebuffer = VK_NULL_HANDLE;
+		activeSecondaryContents = false;
+	}
+
+	void VulkanContext::ReserveRecordingSlots(const uint32_t count) {
+		if (recordingSlots.size() < static_cast<size_t>(MAX_FRAMES_IN_FLIGHT))
+			recordingSlots.resize(MAX_FRAMES_IN_FLIGHT);
+
+		std::vector<RecordingSlot>& slots = recordingSlots[currentFrame];
+		while (slots.size() < count) {
+			// Transient as every buffer is rerecorded each frame, the pool is reset rather than its buffers
+			VkCommandPoolCreateInfo poolInfo {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			poolInfo.queueFamilyIndex = graphicsQueueFamily;
+			poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+			RecordingSlot& slot = slots.emplace_back();
+			CheckVkResult(vkCreateCommandPool(device, &poolInfo, allocationCallbacks, &slot.pool));
+		}
+	}
+
+	VkCommandBuffer VulkanContext::BeginSecondaryCommandBuffer(const uint32_t slot) {
+		MIST_ASSERT(activeRenderData != nullptr, "Secondary command buffers can only be recorded inside a render pass");
+		RecordingSlot& recordingSlot = recordingSlots[currentFrame][slot];
+
+		// Several passes a frame can each record with the same slot so buffers are handed out in turn
+		if (recordingSlot.used == recordingSlot.buffers.size()) {
+			VkCommandBufferAllocateInfo allocInfo {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = recordingSlot.pool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			CheckVkResult(vkAllocateCommandBuffers(device, &allocInfo, &recordingSlot.buffers.emplace_back()));
+		}
+
+		VkCommandBuffer commandBuffer = recordingSlot.buffers[recordingSlot.used++];
+
+		// Without a render pass object the secondary is told the attachment formats it will draw into instead
+		VkCommandBufferInheritanceRenderingInfo renderingInheritance {};
+		renderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		renderingInheritance.colorAttachmentCount = static_cast<uint32_t>(activeRenderData->colorFormats.size());
+		renderingInheritance.pColorAttachmentFormats = activeRenderData->colorFormats.data();
+		renderingInheritance.depthAttachmentFormat = activeRenderData->depthFormat;
+		renderingInheritance.stencilAttachmentFormat = activeRenderData->stencilFormat;
+		renderingInheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkCommandBufferInheritanceInfo inheritanceInfo {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.pNext = dynamicRenderingEnabled ? &renderingInheritance : nullptr;
+		inheritanceInfo.renderPass = activeRenderData->renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = activeFramebuffer;
+
+		VkCommandBufferBeginInfo beginInfo {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+		CheckVkResult(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &activeRenderData->viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &activeRenderData->scissor);
+
+		recordingCommandBuffer = commandBuffer;
+		return commandBuffer;
+	}
+
+	void VulkanContext::EndSecondaryCommandBuffer() {
+		CheckVkResult(vkEndCommandBuffer(recordingCommandBuffer));
+		recordingCommandBuffer = VK_NULL_HANDLE;
+	}
+
+	void VulkanContext::ExecuteSecondaryCommandBuffers(const std::vector<VkCommandBuffer>& secondaryBuffers) {
+		if (!secondaryBuffers.empty())
+			vkCmdExecuteCommands(commandBuffers[currentFrame], static_cast<uint32_t>(secondaryBuffers.size()), secondaryBuffers.data());
 	}
 
 	Ref<VulkanRenderData> VulkanContext::CreateNewRenderData() {
@@ -1,20 +1,33 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
+#include <deque>
+#include <functional>
 #include <optional>
 #include <vector>
 #include <unordered_map>
 #include "renderer/Framebuffer.hpp"
 #include "renderer/vulkan/VulkanRenderData.hpp"
+#include "renderer/vulkan/VulkanStagingRing.hpp"
+#include "renderer/vulkan/VulkanBindlessHeap.hpp"
+#include "ThreadPool.hpp"
 
 namespace mist {
 	struct QueueFamilyIndices {
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		std::optional<uint32_t> transferFamily;	// Only set when the device has a family without graphics that can copy
 
 		bool Valid() { return graphicsFamily.has_value() && presentFamily.has_value(); }
 	};
 
+	// Records secondary buffers for one job at a time. Each slot has its own pool so slots can record at once
+	struct RecordingSlot {
+		VkCommandPool pool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> buffers;
+		uint32_t used = 0;
+	};
+
 	struct FrameData {
 		VkSemaphore acquireImageSempahore;
 		VkFence inFlightFence;
@@ -42,31 +55,76 @@ namespace mist {
 		void RecreateSwapchain();
 		void BeginFrame();
 		void EndFrame();
-		void BeginRenderPass(const uint8_t renderDataID);
+		// Secondary contents passes can only be filled by executing secondary command buffers
+		void BeginRenderPass(const uint8_t renderDataID, const bool secondaryContents = false);
 		void EndRenderPass();
 
+		// Slots must be reserved on the main thread before any worker begins recording into them
+		void ReserveRecordingSlots(const uint32_t count);
+		// Begins a secondary buffer inside the active pass, until it ends it is what this thread's draws record into
+		VkCommandBuffer BeginSecondaryCommandBuffer(const uint32_t slot);
+		void EndSecondaryCommandBuffer();
+		void ExecuteSecondaryCommandBuffers(const std::vector<VkCommandBuffer>& secondaryBuffers);
+
+		// Runs release once every frame begun so far has finished on the GPU, for objects the frame being recorded or
+		// those in flight may still use. It can run as late as Cleanup so it must only free what it captured itself
+		void DeferRelease(std::function<void()> release);
+
 		Ref<VulkanRenderData> CreateNewRenderData();
-		Ref<VulkanRenderData> GetRenderData(const uint8_t renderDataId) { return renderDatas[renderDataId]; }
+		// Looked up without inserting so recording workers can call it alongside each other
+		Ref<VulkanRenderData> GetRenderData(const uint8_t renderDataId) const {
+			auto data = renderDatas.find(renderDataId);
+			return data != renderDatas.end() ? data->second : nullptr;
+		}
+		std::unordered_map<uint8_t, Ref<VulkanRenderData>>& GetRenderDatas() { return renderDatas; }
 
 		inline const VkInstance GetInstance() const { return instance; }
 		inline const VkSurfaceKHR GetSurface() const { return surface; }
 		inline const VkDevice GetDevice() const { return device; }
 		inline const VkPhysicalDevice GetPhysicalDevice() const { return physicalDevice; }
+		inline const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return enabledFeatures; }
 		inline const VkQueue GetGraphicsQueue() const { return graphicsQueue; }
 		inline const VkQueue GetPresentQueue() const { return presentQueue; }
+		// Falls back to the graphics queue when there is no dedicated transfer family
+		inline const VkQueue GetTransferQueue() const { return transferQueue; }
+		inline const uint32_t GetGraphicsQueueFamily() const { return graphicsQueueFamily; }
+		inline const uint32_t GetTransferQueueFamily() const { return transferQueueFamily; }
+		inline const bool HasDedicatedTransferQueue() const { return graphicsQueueFamily != transferQueueFamily; }
         inline const VkDebugUtilsMessengerEXT GetDebugMessenger() const { return debugMessenger; }
         inline const VmaAllocator GetAllocator() const { return allocator; }
 		inline const VkCommandPool GetCommandPool() const { return commandPool; }
 		inline const VkCommandBuffer GetTempCommandBuffer() const { return tempCommandBuffer; }
+		inline VulkanStagingRing& GetStagingRing() { return stagingRing; }
+		inline VulkanBindlessHeap& GetBindlessHeap() { return bindlessHeap; }
+		inline const VkPipelineCache GetPipelineCache() const { return pipelineCache; }
+		// Separate from the application's pool so slow pipeline builds never hold up per frame work queued there
+		inline ThreadPool& GetPipelineCompiler() { return *pipelineCompiler; }
+		inline const bool IsBindlessSupported() const { return bindlessSupported; }
+		// When set render data draws straight into its images and never creates render pass or framebuffer objects
+		inline const bool IsDynamicRenderingEnabled() const { return dynamicRenderingEnabled; }
 		inline const VkAllocationCallbacks* GetAllocationCallbacks() const { return allocationCallbacks; }
 		inline const VkSwapchainKHR GetSwapchain() const { return swapchain; }
 		inline const uint32_t GetCurrentFrameIndex() const { return currentFrame; }
+		// Counts every frame begun, unlike the frame index it never repeats so per frame state can tell a new frame apart
+		inline const uint64_t GetFrameNumber() const { return frameNumber; }
+		// Every frame up to this number has finished on the GPU, whatever only they used can be reused
+		inline const uint64_t GetCompletedFrameNumber() const { return frameNumber > static_cast<uint64_t>(MAX_FRAMES_IN_FLIGHT) ? frameNumber - MAX_FRAMES_IN_FLIGHT : 0; }
+		// Reaches a frame's number once its graphics submit finishes, other queues wait on it before touching what frames read
+		inline const VkSemaphore GetGraphicsTimeline() const { return graphicsTimeline; }
+		// Newest frame handed to the graphics queue, so the newest value the graphics timeline will ever be signalled with
+		inline const uint64_t GetSubmittedFrameNumber() const { return submittedFrameNumber; }
 		inline const VkCommandBuffer GetCommandBuffer(uint32_t index) const { return commandBuffers[index]; }
-		inline const VkCommandBuffer GetCurrentFrameCommandBuffer() const { return commandBuffers[currentFrame]; }
+		// Threads recording a secondary buffer get that instead of the frame's primary
+		inline const VkCommandBuffer GetCurrentFrameCommandBuffer() const { return recordingCommandBuffer != VK_NULL_HANDLE ? recordingCommandBuffer : commandBuffers[currentFrame]; }
+		inline const bool IsRecordingSecondary() const { return recordingCommandBuffer != VK_NULL_HANDLE; }
+		inline const bool IsRenderPassSecondary() const { return activeRenderData != nullptr && activeSecondaryContents; }
 		inline const uint32_t GetSwapchainImageCount() const { return static_cast<uint32_t>(swapchainImageViews.size()); }
 		inline const VkImageView GetSwapchainImageView(const uint8_t index) const { return swapchainImageViews[index]; }
+		inline const VkImage GetSwapchainImage(const uint32_t index) const { return swapchainImages[index]; }
+		inline const VkFormat GetSwapchainFormat() const { return swapchainFormat; }
 
 		const int MAX_FRAMES_IN_FLIGHT = 3;
+		const size_t PIPELINE_COMPILE_THREADS = 2;
 	private:
         VulkanContext() {}
         ~VulkanContext() {}
@@ -83,31 +141,57 @@ namespace mist {
 		void CreateCommandPool();
 		void AllocateCommandBuffers();
 		void CreateDescriptorPool();
+		void CreatePipelineCache();
+		void SavePipelineCache();
+		void BeginRenderPassObject(VulkanRenderData& data, const uint32_t index, const VkClearValue& clearColor, const VkClearValue& depthValue, const bool secondaryContents);
+		void RunDeferredReleases(const uint64_t completedFrame);
 
 		uint8_t GetNewRenderDataID();
 		uint32_t currentFrame = 0;
+		uint64_t frameNumber = 0;
+		uint64_t submittedFrameNumber = 0;
 		uint32_t imageIndex = 0;
+		std::deque<std::pair<uint64_t, std::function<void()>>> deferredReleases;	// Oldest first, with the frame number each waits on
 
 		VkInstance instance = VK_NULL_HANDLE;
 		VkSurfaceKHR surface = VK_NULL_HANDLE;
 		VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceFeatures enabledFeatures {};
 		VkDevice device = VK_NULL_HANDLE;
 		VkQueue graphicsQueue = VK_NULL_HANDLE;
 		VkQueue presentQueue = VK_NULL_HANDLE;
+		VkQueue transferQueue = VK_NULL_HANDLE;
+		uint32_t graphicsQueueFamily = 0;
+		uint32_t transferQueueFamily = 0;
+		VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 		VkAllocationCallbacks* allocationCallbacks = nullptr;
 		VkDebugUtilsMessengerEXT debugMessenger = VK_NULL_HANDLE;
         VmaAllocator allocator = nullptr;
 		
 		SwapchainProperties swapchainProperties;
 		VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+		std::vector<VkImage> swapchainImages;
 		std::vector<VkImageView> swapchainImageViews;
+		VkFormat swapchainFormat = VK_FORMAT_UNDEFINED;
 		std::vector<VkSemaphore> submitSemaphores;
 		std::vector<FrameData> frameDatas;
+		VkSemaphore graphicsTimeline = VK_NULL_HANDLE;
 
 		VkCommandPool commandPool = VK_NULL_HANDLE;
 		std::vector<VkCommandBuffer> commandBuffers;
 		VkCommandBuffer tempCommandBuffer = VK_NULL_HANDLE;
 		VkFence tempCommandBufferFence = VK_NULL_HANDLE;
+		std::vector<std::vector<RecordingSlot>> recordingSlots;	// [frame][slot]
+		inline static thread_local VkCommandBuffer recordingCommandBuffer = VK_NULL_HANDLE;
+		Ref<VulkanRenderData> activeRenderData;
+		VkFramebuffer activeFramebuffer = VK_NULL_HANDLE;	// Stays null under dynamic rendering
+		uint32_t activeFramebufferIndex = 0;
+		bool activeSecondaryContents = false;
+		VulkanStagingRing stagingRing;
+		VulkanBindlessHeap bindlessHeap;
+		Scope<ThreadPool> pipelineCompiler;
+		bool bindlessSupported = false;
+		bool dynamicRenderingEnabled = false;
 
 		uint8_t renderDataCounter;
 		std::unordered_map<uint8_t, Ref<VulkanRenderData>> renderDatas;
@@ -0,0 +1,93 @@
+#include "renderer/vulkan/VulkanDescriptorAllocator.hpp"
+#include "renderer/vulkan/VulkanContext.hpp"
+#include "renderer/vulkan/VulkanDebug.hpp"
+#include "Log.hpp"
+#include <algorithm>
+
+namespace mist {
+	static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+	// Descriptors per set of each type, scaled by the pool's set count
+	static const std::pair<VkDescriptorType, float> POOL_RATIOS[] = {
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0.5f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 0.5f },
+		{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.5f }
+	};
+
+	VulkanDescriptorAllocator::VulkanDescriptorAllocator(uint32_t initialSetsPerPool)
+		: initialSetsPerPool(initialSetsPerPool), setsPerPool(initialSetsPerPool) {}
+
+	VkDescriptorSet VulkanDescriptorAllocator::Allocate(VkDescriptorSetLayout layout) {
+		VulkanContext& context = VulkanContext::GetContext();
+		VkDescriptorPool pool = GetPool();
+
+		VkDescriptorSetAllocateInfo allocationInfo {};
+		allocationInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocationInfo.descriptorPool = pool;
+		allocationInfo.descriptorSetCount = 1;
+		allocationInfo.pSetLayouts = &layout;
+
+		VkDescriptorSet descriptorSet;
+		VkResult result = vkAllocateDescriptorSets(context.GetDevice(), &allocationInfo, &descriptorSet);
+		if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+			// Retire the pool until the next reset, a fresh one is always large enough for a single set
+			readyPools.pop_back();
+			fullPools.push_back(pool);
+
+			allocationInfo.descriptorPool = GetPool();
+			result = vkAllocateDescriptorSets(context.GetDevice(), &allocationInfo, &descriptorSet);
+		}
+
+		CheckVkResult(result);
+		return descriptorSet;
+	}
+
+	void VulkanDescriptorAllocator::Cleanup() {
+		VulkanContext& context = VulkanContext::GetContext();
+		for (VkDescriptorPool pool : readyPools)
+			vkDestroyDescriptorPool(context.GetDevice(), pool, context.GetAllocationCallbacks());
+
+		for (VkDescriptorPool pool : fullPools)
+			vkDestroyDescriptorPool(context.GetDevice(), pool, context.GetAllocationCallbacks());
+
+		readyPools.clear();
+		fullPools.clear();
+		setsPerPool = initialSetsPerPool;
+	}
+
+	VkDescriptorPool VulkanDescriptorAllocator::GetPool() {
+		if (!readyPools.empty())
+			return readyPools.back();
+
+		// Each new pool doubles so a growing scene needs log(n) pools rather than n / 100
+		VkDescriptorPool pool = CreatePool(setsPerPool);
+		setsPerPool = std::min(setsPerPool * 2, MAX_SETS_PER_POOL);
+		readyPools.push_back(pool);
+		return pool;
+	}
+
+	VkDescriptorPool VulkanDescriptorAllocator::CreatePool(const uint32_t setCount) {
+		std::vector<VkDescriptorPoolSize> poolSizes;
+		for (const std::pair<VkDescriptorType, float>& ratio : POOL_RATIOS)
+			poolSizes.push_back({ ratio.first, std::max(1u, static_cast<uint32_t>(ratio.second * setCount)) });
+
+		VulkanContext& context = VulkanContext::GetContext();
+		VkDescriptorPoolCreateInfo info = {};
+		info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		info.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		info.pPoolSizes = poolSizes.data();
+		info.maxSets = setCount;
+		info.flags = 0;	// Sets are never freed individually
+
+		VkDescriptorPool pool;
+		CheckVkResult(vkCreateDescriptorPool(context.GetDevice(), &info, context.GetAllocationCallbacks(), &pool));
+		MIST_INFO("Created new descriptor pool for " + std::to_string(setCount) + " sets");
+		return pool;
+	}
+}
\ No newline at end of file
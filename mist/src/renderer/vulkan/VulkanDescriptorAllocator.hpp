@@ -0,0 +1,24 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace mist {
+	// Hands out descriptor sets from a list of pools without per set frees. Allocation only ever tries the
+	// newest pool, once that runs out it is retired and a larger one takes its place, so the cost stays flat
+	// however many sets exist. Sets live until Cleanup destroys the pools
+	class VulkanDescriptorAllocator {
+	public:
+		VulkanDescriptorAllocator(uint32_t initialSetsPerPool = 64);
+
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+		void Cleanup();
+	private:
+		VkDescriptorPool GetPool();
+		VkDescriptorPool CreatePool(const uint32_t setCount);
+
+		std::vector<VkDescriptorPool> readyPools;
+		std::vector<VkDescriptorPool> fullPools;
+		uint32_t initialSetsPerPool;
+		uint32_t setsPerPool;
+	};
+}
\ No newline at end of file
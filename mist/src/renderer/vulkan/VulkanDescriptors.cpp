@@ -1,148 +1,146 @@
 #include "VulkanDescriptors.hpp"
 #include "renderer/vulkan/VulkanDebug.hpp"
 #include "renderer/vulkan/VulkanContext.hpp"
+#include "data/RenderTypes.hpp"
 #include "Debug.hpp"
+#include <algorithm>
 #include <imgui_impl_vulkan.h>
 
 namespace mist {
-	void VulkanDescriptor::CreateDescriptorPool() {
-		// Initial pool sizes
-		std::vector<VkDescriptorPoolSize> poolSize = {
-			{ VK_DESCRIPTOR_TYPE_SAMPLER, 100 },
-			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 100 },
-			{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 100 },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 100 },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 100 },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 100 },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 100 },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 100 },
-			{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 100 },
-			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 100 },
-			{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 100 }
-		};
+	static constexpr uint32_t INSTANCE_DATA_BINDING = 2;
+
+	struct FrameResource {
+		const char* name;
+		uint32_t binding;
+		VkDescriptorType type;
+		VkShaderStageFlags stages;
+		uint32_t size;	// Range bound for uniform blocks
+	};
+
+	// Fixed so every pipeline layout has an identical frame set layout, shaders may use any subset of it
+	static const FrameResource FRAME_RESOURCES[] = {
+		{ "CameraData", 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(CameraData) },
+		{ "DirectionalLightData", 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, sizeof(DirectionalLightData) },
+		{ "InstanceData", INSTANCE_DATA_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0 },
+	};
+
+	// Source for uniform blocks nothing wrote this frame, such as a scene without a light
+	static const uint8_t EMPTY_UNIFORM_DATA[256] = {};
+
+	std::vector<VkDescriptorSetLayout> VulkanDescriptor::GetPipelineSetLayouts(const VulkanShader* shader) {
+		VulkanBindlessHeap& bindlessHeap = VulkanContext::GetContext().GetBindlessHeap();
+		bool usesBindless = false;
 
-		VulkanContext& context = VulkanContext::GetContext();
-		VkDescriptorPoolCreateInfo info = {};
-		info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		info.poolSizeCount = static_cast<uint32_t>(poolSize.size());
-		info.pPoolSizes = poolSize.data();
-		info.maxSets = 100;
-		info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-
-		VkDescriptorPool pool;
-		CheckVkResult(vkCreateDescriptorPool(context.GetDevice(), &info, context.GetAllocationCallbacks(), &pool));
-		pools.push_back(pool);
-		
-		MIST_INFO("Created new descriptor pool");
+		for (const auto& res : shader->GetUboResources()) {
+			if (res.second.set == MATERIAL_DESCRIPTOR_SET) {
+				MIST_ASSERT(bindlessHeap.IsCreated(), shader->GetName() + " uses the bindless heap which this device does not support");
+				MIST_ASSERT(res.second.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && res.second.binding == VulkanBindlessHeap::STORAGE_BUFFER_BINDING, std::string("Bindless resource ") + res.first + " must be a storage buffer array at binding " + std::to_string(VulkanBindlessHeap::STORAGE_BUFFER_BINDING));
+				usesBindless = true;
+				continue;
+			}
+
+			MIST_ASSERT(res.second.set == FRAME_DESCRIPTOR_SET, std::string("Unsupported descriptor set ") + std::to_string(res.second.set) + " in " + shader->GetName());
+
+			const FrameResource* frameResource = nullptr;
+			for (const FrameResource& resource : FRAME_RESOURCES) {
+				if (res.first == resource.name)
+					frameResource = &resource;
+			}
+
+			MIST_ASSERT(frameResource != nullptr, std::string("Unknown frame resource ") + res.first + " in " + shader->GetName());
+			MIST_ASSERT(frameResource->binding == res.second.binding, std::string("Frame resource ") + res.first + " must use binding " + std::to_string(frameResource->binding));
+			MIST_ASSERT((res.second.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) == (frameResource->type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER), std::string("Frame resource ") + res.first + " has the wrong descriptor type");
+		}
+
+		for (const auto& res : shader->GetSampledImageResources()) {
+			MIST_ASSERT(bindlessHeap.IsCreated(), shader->GetName() + " samples images which are only supported through the bindless heap");
+			MIST_ASSERT(res.second.set == MATERIAL_DESCRIPTOR_SET && res.second.type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE && res.second.binding == VulkanBindlessHeap::SAMPLED_IMAGE_BINDING, std::string("Image ") + res.first + " must be a texture array at set 1 binding " + std::to_string(VulkanBindlessHeap::SAMPLED_IMAGE_BINDING));
+			usesBindless = true;
+		}
+
+		if (usesBindless)
+			return { GetFrameSetLayout(), bindlessHeap.GetLayout() };
+
+		return { GetFrameSetLayout() };
 	}
 
-	VkDescriptorSetLayout VulkanDescriptor::CreateDescriptorSetLayout(const VulkanShader* shader) {
-		std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
-		VulkanContext& context = VulkanContext::GetContext();
+	VkDescriptorSetLayout VulkanDescriptor::GetFrameSetLayout() {
+		if (frameSetLayout != VK_NULL_HANDLE)
+			return frameSetLayout;
 
-		for (const auto& res : shader->GetUboResources()) {
-			uniformBufferNames[{shader->GetName(), res.second.binding}] = res.first;
+		VulkanContext& context = VulkanContext::GetContext();
+		std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+		frameUniforms.clear();
 
-			MIST_ASSERT(res.second.count > 0, "Invalid descriptor set layout count");
-			MIST_ASSERT(res.second.flags != 0, "Invalid descriptor set layout flags");
-			
+		for (const FrameResource& resource : FRAME_RESOURCES) {
 			VkDescriptorSetLayoutBinding layoutBinding{};
-			layoutBinding.binding = res.second.binding;
-			layoutBinding.descriptorType = res.second.type;
-			layoutBinding.descriptorCount = res.second.count;
-			layoutBinding.stageFlags = res.second.flags;
+			layoutBinding.binding = resource.binding;
+			layoutBinding.descriptorType = resource.type;
+			layoutBinding.descriptorCount = 1;
+			layoutBinding.stageFlags = resource.stages;
 			layoutBinding.pImmutableSamplers = nullptr;
 			layoutBindings.push_back(layoutBinding);
+
+			MIST_ASSERT(resource.size <= sizeof(EMPTY_UNIFORM_DATA), "Frame uniform block larger than the empty fallback data");
+			if (resource.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
+				frameUniforms.push_back({ resource.binding, GetUniformHandle(resource.name), resource.size });
 		}
 
-        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		// Dynamic offsets are consumed in binding order
+		std::sort(frameUniforms.begin(), frameUniforms.end(), [](const DynamicUniformBinding& a, const DynamicUniformBinding& b) { return a.binding < b.binding; });
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 		layoutInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
 		layoutInfo.pBindings = layoutBindings.data();
-		
-		VkDescriptorSetLayout layout;
-        CheckVkResult(vkCreateDescriptorSetLayout(context.GetDevice(), &layoutInfo, context.GetAllocationCallbacks(), &layout));
-		MIST_INFO(std::string("Created new descriptor set layout for: ") + shader->GetName());
 
-		descriptorSetLayoutBindings[shader->GetName()] = std::move(layoutBindings);
-		descriptorSetLayouts[shader->GetName()] = std::move(layout);
-		return layout;
+		CheckVkResult(vkCreateDescriptorSetLayout(context.GetDevice(), &layoutInfo, context.GetAllocationCallbacks(), &frameSetLayout));
+		MIST_INFO("Created frame descriptor set layout");
+		return frameSetLayout;
 	}
 
-	VkDescriptorSet& VulkanDescriptor::CreateDescriptorSet(const uint8_t frameIndex, const MeshRenderer& meshRenderer) {
-		VkDescriptorSet descriptorSet;
-		VulkanContext& context = VulkanContext::GetContext();
+	void VulkanDescriptor::ReplaceFrameSet() {
+		// The current set may be bound in commands recorded this frame or still in flight, so it is never rewritten.
+		// The next bind allocates one pointing at the new buffers, the old one stays in its pool until Cleanup but
+		// buffers double as they grow so only a handful are ever left behind
+		frameSet = VK_NULL_HANDLE;
+	}
 
-		DescriptorSetKey key{};
-		key.layout = GetDescriptorSetLayout(meshRenderer.shaderName);
-		key.vertexBuffer = std::static_pointer_cast<VulkanVertexBuffer>(meshRenderer.vBuffer)->GetBuffer();
-		key.indexBuffer = std::static_pointer_cast<VulkanIndexBuffer>(meshRenderer.iBuffer)->GetBuffer();
-
-		// Try to place in existing pool
-		for (size_t i = 0; i < pools.size(); ++i) {
-			VkDescriptorSetAllocateInfo allocationInfo {};
-			allocationInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-			allocationInfo.descriptorPool = pools[i];
-			allocationInfo.descriptorSetCount = 1;
-			allocationInfo.pSetLayouts = &GetDescriptorSetLayout(meshRenderer.shaderName);
-
-			VkResult result = vkAllocateDescriptorSets(context.GetDevice(), &allocationInfo, &descriptorSet);
-
-			switch(result) {
-			case VK_SUCCESS:
-				MIST_INFO("Allocated descriptor set to existing pool");
-				key.poolIndex = i;
-				descriptorSets[key] = descriptorSet;
-				UpdateDescriptorSetsWithUniformBuffers(frameIndex, meshRenderer);
-				return descriptorSets[key];
-			case VK_ERROR_FRAGMENTED_POOL:
-			case VK_ERROR_OUT_OF_POOL_MEMORY:
-				continue;
-			default:
-				CheckVkResult(result);
-			};
-		}
+	VkDescriptorSet VulkanDescriptor::GetFrameSet(const uint8_t frameIndex) {
+		if (frameSet != VK_NULL_HANDLE)
+			return frameSet;
 
-		CreateDescriptorPool();
+		frameSet = setAllocator.Allocate(GetFrameSetLayout());
 
-		key.poolIndex = pools.size() - 1;
-		
-		VkDescriptorSetAllocateInfo alloctionInfo {};
-		alloctionInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		alloctionInfo.descriptorPool = GetDescriptorPool((int)pools.size() - 1);
-		alloctionInfo.descriptorSetCount = 1;
-		alloctionInfo.pSetLayouts = &GetDescriptorSetLayout(meshRenderer.shaderName);
-
-		CheckVkResult(vkAllocateDescriptorSets(context.GetDevice(), &alloctionInfo, &descriptorSet));
-		MIST_INFO("Allocated descriptor set to new pool");
-
-		descriptorSets[key] = descriptorSet;
-		UpdateDescriptorSetsWithUniformBuffers(frameIndex, meshRenderer);
-		return descriptorSets[key];
+		if (!instanceBuffer.IsCreated())
+			instanceBuffer.Reserve(frameIndex, 0);
+		WriteInstanceDescriptor();
+
+		if (!uniformArena.IsCreated())
+			uniformArena.Reserve(frameIndex, 0);
+		for (const DynamicUniformBinding& uniform : frameUniforms)
+			WriteUniformDescriptor(uniform);
+
+		return frameSet;
 	}
 
 	void VulkanDescriptor::Cleanup() {
 		VulkanContext& context = VulkanContext::GetContext();
-		for (std::pair<std::string, VkDescriptorSetLayout> layout : descriptorSetLayouts) {
-			vkDestroyDescriptorSetLayout(context.GetDevice(), layout.second, context.GetAllocationCallbacks());
+		if (frameSetLayout != VK_NULL_HANDLE) {
+			vkDestroyDescriptorSetLayout(context.GetDevice(), frameSetLayout, context.GetAllocationCallbacks());
+			frameSetLayout = VK_NULL_HANDLE;
 		}
-		descriptorSetLayouts.clear();
-		
-		for (auto& set : descriptorSets) {
-			vkFreeDescriptorSets(context.GetDevice(), pools[set.first.poolIndex], 1, &set.second);
-		}
-		descriptorSets.clear();
+		frameSet = VK_NULL_HANDLE;	// Freed with its pool
+		preparedSet = VK_NULL_HANDLE;
+		frameUniforms.clear();
 
-		for (std::pair<const std::pair<uint8_t, std::string>, mist::UniformBuffer>& ubo : uniformBuffers) {
-			ubo.second.Clear();
-		}
-		uniformBuffers.clear();
-		uniformBufferNames.clear();
+		uniformArena.Clear();
+		uniformOffsets.clear();
+		uniformFrame = UINT64_MAX;
 
-		for (VkDescriptorPool& pool : pools) {
-			vkDestroyDescriptorPool(context.GetDevice(), pool, context.GetAllocationCallbacks());
-		}
-		pools.clear();
+		instanceBuffer.Clear();
+
+		setAllocator.Cleanup();
 
 		if (imguiPool != VK_NULL_HANDLE)
 			vkDestroyDescriptorPool(context.GetDevice(), imguiPool, context.GetAllocationCallbacks());
@@ -171,46 +169,112 @@ namespace mist {
 		return imguiPool;
 	}
 
-	VkDescriptorSetLayout& VulkanDescriptor::GetDescriptorSetLayout(const std::string& name) {
-		MIST_ASSERT(Exists(name), "Descriptor set layout not found"); 
-		return descriptorSetLayouts[name];
+	void VulkanDescriptor::BindFrameSet(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, const uint8_t frameIndex) {
+		PrepareFrameSet(frameIndex);
+		BindPreparedFrameSet(commandBuffer, pipelineLayout);
+	}
+
+	void VulkanDescriptor::PrepareFrameSet(const uint8_t frameIndex) {
+		// Blocks nothing wrote this frame get empty data so the shared set can always be bound
+		std::vector<uint32_t>& offsets = GetUniformOffsets(frameIndex);
+		for (const DynamicUniformBinding& uniform : frameUniforms) {
+			if (uniform.handle >= offsets.size() || offsets[uniform.handle] == UINT32_MAX)
+				WriteUniformData(frameIndex, uniform.handle, EMPTY_UNIFORM_DATA, uniform.size);
+		}
+
+		// Collected after the writes above as they can grow the arena and replace the set
+		preparedSet = GetFrameSet(frameIndex);
+		dynamicOffsets.clear();
+		for (const DynamicUniformBinding& uniform : frameUniforms)
+			dynamicOffsets.push_back(uniformArena.GetFrameOffset(frameIndex) + offsets[uniform.handle]);
 	}
 
-	VkDescriptorSet& VulkanDescriptor::GetDescriptorSet(const MeshRenderer& meshRenderer) {
-		DescriptorSetKey key{};
-		key.layout = GetDescriptorSetLayout(meshRenderer.shaderName);
-		key.vertexBuffer = std::static_pointer_cast<VulkanVertexBuffer>(meshRenderer.vBuffer)->GetBuffer();
-		key.indexBuffer = std::static_pointer_cast<VulkanIndexBuffer>(meshRenderer.iBuffer)->GetBuffer();
+	void VulkanDescriptor::BindPreparedFrameSet(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const {
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, FRAME_DESCRIPTOR_SET, 1, &preparedSet, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+	}
 
-		auto it = descriptorSets.find(key);
-		if (it != descriptorSets.end())
+	UniformHandle VulkanDescriptor::GetUniformHandle(const std::string& name) {
+		auto it = uniformHandles.find(name);
+		if (it != uniformHandles.end())
 			return it->second;
 
+		const UniformHandle handle = static_cast<UniformHandle>(uniformHandles.size());
+		uniformHandles.emplace(name, handle);
+		return handle;
+	}
+
+	std::vector<uint32_t>& VulkanDescriptor::GetUniformOffsets(const uint8_t frameIndex) {
+		if (uniformOffsets.size() <= frameIndex)
+			uniformOffsets.resize(frameIndex + 1);
+
+		// Offsets written the last time this frame index was used point at memory that is about to be reused. Keyed on
+		// the frame number as a render data skipped for whole cycles of frame indices would otherwise keep them
+		std::vector<uint32_t>& offsets = uniformOffsets[frameIndex];
+		const uint64_t frameNumber = VulkanContext::GetContext().GetFrameNumber();
+		if (uniformFrame != frameNumber) {
+			uniformFrame = frameNumber;
+			std::fill(offsets.begin(), offsets.end(), UINT32_MAX);
+		}
+
+		if (offsets.size() < uniformHandles.size())
+			offsets.resize(uniformHandles.size(), UINT32_MAX);
+
+		return offsets;
+	}
+
+	void VulkanDescriptor::WriteUniformData(const uint8_t frameIndex, const UniformHandle handle, const void* data, const uint32_t size) {
+		std::vector<uint32_t>& offsets = GetUniformOffsets(frameIndex);
+
+		if (uniformArena.Reserve(frameIndex, size))
+			ReplaceFrameSet();
+
+		offsets[handle] = uniformArena.Write(frameIndex, data, size);
+	}
+
+	void VulkanDescriptor::WriteUniformDescriptor(const DynamicUniformBinding& uniform) {
 		VulkanContext& context = VulkanContext::GetContext();
-		return CreateDescriptorSet(context.GetCurrentFrameIndex(), meshRenderer);
+
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = uniformArena.GetBuffer();
+		bufferInfo.offset = 0;
+		bufferInfo.range = uniform.size;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = frameSet;
+		descriptorWrite.dstBinding = uniform.binding;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(context.GetDevice(), 1, &descriptorWrite, 0, nullptr);
+	}
+
+	uint32_t VulkanDescriptor::WriteInstanceData(const uint32_t frameIndex, const glm::mat4* modelMatrices, const uint32_t count) {
+		if (instanceBuffer.Reserve(frameIndex, count))
+			ReplaceFrameSet();
+
+		return instanceBuffer.Write(frameIndex, modelMatrices, count);
 	}
 
-	void VulkanDescriptor::UpdateDescriptorSetsWithUniformBuffers(const uint8_t frameIndex, const MeshRenderer& meshRenderer) {
+	void VulkanDescriptor::WriteInstanceDescriptor() {
 		VulkanContext& context = VulkanContext::GetContext();
-		for (const VkDescriptorSetLayoutBinding& binding : descriptorSetLayoutBindings[meshRenderer.shaderName]) {
-			UniformBuffer& buffer = uniformBuffers[{ frameIndex, uniformBufferNames[{meshRenderer.shaderName, binding.binding}] }];
-			VkDescriptorSet descriptor = GetDescriptorSet(meshRenderer);	// Get here incase we require to create the descriptor set incase we skip over due to the uniform buffer not being ready yet
-
-			VkDescriptorBufferInfo bufferInfo{};
-			bufferInfo.buffer = buffer.GetBuffer();
-			bufferInfo.offset = 0;
-			bufferInfo.range = buffer.GetSize();
-
-			VkWriteDescriptorSet descriptorWrite{};
-			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrite.dstSet = descriptor;
-			descriptorWrite.dstBinding = binding.binding;
-			descriptorWrite.dstArrayElement = 0;
-			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrite.descriptorCount = 1;
-			descriptorWrite.pBufferInfo = &bufferInfo;
-
-			vkUpdateDescriptorSets(context.GetDevice(), 1, &descriptorWrite, 0, nullptr);
-		}
+
+		VkDescriptorBufferInfo bufferInfo{};
+		bufferInfo.buffer = instanceBuffer.GetBuffer();
+		bufferInfo.offset = 0;
+		bufferInfo.range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet descriptorWrite{};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = frameSet;
+		descriptorWrite.dstBinding = INSTANCE_DATA_BINDING;
+		descriptorWrite.dstArrayElement = 0;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(context.GetDevice(), 1, &descriptorWrite, 0, nullptr);
 	}
 }
\ No newline at end of file
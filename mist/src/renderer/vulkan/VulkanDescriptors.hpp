@@ -3,99 +3,80 @@
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include "Core.hpp"
+#include "Math.hpp"
 #include "renderer/vulkan/VulkanShader.hpp"
-#include "components/MeshRenderer.hpp"
 #include "renderer/vulkan/VulkanBuffer.hpp"
+#include "renderer/vulkan/VulkanDescriptorAllocator.hpp"
 
 namespace mist {
-	struct DescriptorSetKey {
-		size_t poolIndex;
-		VkDescriptorSetLayout layout;
-		VkBuffer vertexBuffer;
-		VkBuffer indexBuffer;
-
-		bool operator==(const DescriptorSetKey& other) const {
-			return poolIndex == other.poolIndex &&
-				layout == other.layout &&
-				vertexBuffer == other.vertexBuffer &&
-				indexBuffer == other.indexBuffer;
-		}
-	};
-
-	struct UniformBufferNameHash {
-		size_t operator()(const std::pair<std::string, uint32_t>& p) const {
-			size_t h1 = std::hash<std::string>{}(p.first);
-			size_t h2 = std::hash<uint32_t>{}(p.second);
-			return h1 ^ (h2 << 1);
-		}
+	// Descriptor sets are split by how often what they point at changes. Per draw data is not a set at all,
+	// draws index the frame set's instance buffer through firstInstance
+	enum DescriptorSetFrequency : uint32_t {
+		FRAME_DESCRIPTOR_SET = 0,		// Camera, light and instance data, one set shared by every draw
+		MATERIAL_DESCRIPTOR_SET = 1,	// The bindless heap for shaders that declare it, see VulkanBindlessHeap
 	};
 
-	struct PairHash {
-    template <typename T1, typename T2>
-    std::size_t operator()(const std::pair<T1, T2>& p) const {
-        auto h1 = std::hash<T1>{}(p.first);
-        auto h2 = std::hash<T2>{}(p.second);
-        return h1 ^ (h2 << 1);
-    }
-};
-}
+	using UniformHandle = uint32_t;
 
-namespace std {
-	template<>
-	struct hash<mist::DescriptorSetKey> {
-		size_t operator()(const mist::DescriptorSetKey& key) const {
-			size_t h1 = hash<VkDescriptorSetLayout>{}(key.layout);
-			size_t h2 = hash<VkBuffer>{}(key.vertexBuffer);
-			size_t h3 = hash<VkBuffer>{}(key.indexBuffer);
-			return h1 ^ (h2 << 1) ^ (h3 << 2);
-		}
+	struct DynamicUniformBinding {
+		uint32_t binding;
+		UniformHandle handle;
+		uint32_t size;
 	};
-}
 
-namespace mist {
 	class VulkanDescriptor {
 	public:
 		VulkanDescriptor() {}
 		~VulkanDescriptor() {}
 
-		VkDescriptorSetLayout CreateDescriptorSetLayout(const VulkanShader* shader);
-		void CreateDescriptorPool();
-		VkDescriptorSet& CreateDescriptorSet(const uint8_t frameIndex, const MeshRenderer& meshRenderer);
+		// Checks the shader only declares frame and bindless resources where the engine expects them and returns the
+		// set layouts for its pipeline layout. Every shader shares them so bound sets survive pipeline changes
+		std::vector<VkDescriptorSetLayout> GetPipelineSetLayouts(const VulkanShader* shader);
 		
 		void Cleanup();
 		
 		VkDescriptorPool& GetImGuiDescriptorPool(); 
-		
-		inline const VkDescriptorPool& GetDescriptorPool(const int index) const { return pools[index]; }
-		inline const std::vector<VkDescriptorPool>& GetDescriptorPools() const { return pools; }
-		
-		VkDescriptorSetLayout& GetDescriptorSetLayout(const std::string& name);
-		VkDescriptorSet& GetDescriptorSet(const MeshRenderer& meshRenderer);
-		
-		void UpdateDescriptorSetsWithUniformBuffers(const uint8_t frameIndex, const MeshRenderer& meshRenderer);
-		void UpdateDescriptorSetsWithUniformBuffer(const std::string& name);
+
+		// Binds the frame set with this frame's uniform offsets
+		void BindFrameSet(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, const uint8_t frameIndex);
+		// Does the writes BindFrameSet would, so recording workers can then bind with BindPreparedFrameSet which only reads
+		void PrepareFrameSet(const uint8_t frameIndex);
+		void BindPreparedFrameSet(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const;
+
+		// Copies model matrices into this frame's region of the instance buffer, returns the firstInstance to draw them with
+		uint32_t WriteInstanceData(const uint32_t frameIndex, const glm::mat4* modelMatrices, const uint32_t count);
+
+		// Handles stay valid across Cleanup so they can be resolved once up front instead of hashing names per update
+		UniformHandle GetUniformHandle(const std::string& name);
 		
 		template<typename T>
-		void UpdateUniformBuffer(const std::pair<uint8_t, std::string>& bufferPair, T& data) {
-			if (uniformBuffers.find(bufferPair) != uniformBuffers.end()) {
-				uniformBuffers[bufferPair].SetData(sizeof(T), &data);
-			} else {
-				uniformBuffers.emplace(
-					std::piecewise_construct,
-					std::forward_as_tuple(bufferPair), 
-					std::forward_as_tuple(sizeof(T), &data)
-				);
-			}
+		void UpdateUniformBuffer(const uint8_t frameIndex, const UniformHandle handle, const T& data) {
+			WriteUniformData(frameIndex, handle, &data, sizeof(T));
 		}
 	private:
-		bool Exists(const std::string& name) const { return descriptorSetLayouts.find(name) != descriptorSetLayouts.end(); }
+		VkDescriptorSetLayout GetFrameSetLayout();
+		VkDescriptorSet GetFrameSet(const uint8_t frameIndex);
+		void ReplaceFrameSet();
+		std::vector<uint32_t>& GetUniformOffsets(const uint8_t frameIndex);
+		void WriteInstanceDescriptor();
+		void WriteUniformDescriptor(const DynamicUniformBinding& uniform);
+		void WriteUniformData(const uint8_t frameIndex, const UniformHandle handle, const void* data, const uint32_t size);
 
 		VkDescriptorPool imguiPool = VK_NULL_HANDLE;
-		std::vector<VkDescriptorPool> pools;
-		std::unordered_map<std::string, VkDescriptorSetLayout> descriptorSetLayouts;
-		std::unordered_map<std::string, std::vector<VkDescriptorSetLayoutBinding>> descriptorSetLayoutBindings;
-		std::unordered_map<DescriptorSetKey, VkDescriptorSet> descriptorSets;
-		std::unordered_map<std::pair<uint8_t, std::string>, UniformBuffer, PairHash, std::equal_to<std::pair<uint8_t, std::string>>> uniformBuffers;
-		std::unordered_map<std::pair<std::string, uint32_t>, std::string, UniformBufferNameHash> uniformBufferNames;	// {shader name, binding} = uniformbuffer name
+		VulkanDescriptorAllocator setAllocator;
+
+		VkDescriptorSetLayout frameSetLayout = VK_NULL_HANDLE;
+		VkDescriptorSet frameSet = VK_NULL_HANDLE;
+		std::vector<DynamicUniformBinding> frameUniforms;	// Sorted by binding, the order dynamic offsets are consumed in
+
+		FrameRegionBuffer instanceBuffer { VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, sizeof(glm::mat4), 1024 };
+
+		UniformArena uniformArena { 16 * 1024 };
+		std::unordered_map<std::string, UniformHandle> uniformHandles;
+		std::vector<std::vector<uint32_t>> uniformOffsets;	// [frame][handle] = offset within the arena's frame region written this frame
+		uint64_t uniformFrame = UINT64_MAX;	// Frame number the offsets were written in
+		VkDescriptorSet preparedSet = VK_NULL_HANDLE;
+		std::vector<uint32_t> dynamicOffsets;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "renderer/vulkan/VulkanGeometryPool.hpp"
+#include "renderer/vulkan/VulkanBuffer.hpp"
+#include "renderer/vulkan/VulkanContext.hpp"
+#include "Debug.hpp"
+#include "Log.hpp"
+#include <algorithm>
+
+namespace mist {
+	static constexpr VkBufferUsageFlags VERTEX_POOL_USAGE = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	static constexpr VkBufferUsageFlags INDEX_POOL_USAGE = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+
+	VulkanGeometryPool::VulkanGeometryPool(const uint32_t vertexCapacity, const uint32_t indexCapacity) : vertexAllocator(vertexCapacity), indexAllocator(indexCapacity) {
+		VmaAllocationInfo info {};
+		CreateBuffer(sizeof(Vertex) * vertexCapacity, VERTEX_POOL_USAGE, vertexBuffer, vertexAlloc, VMA_MEMORY_USAGE_GPU_ONLY, 0, info);
+		CreateBuffer(sizeof(uint32_t) * indexCapacity, INDEX_POOL_USAGE, indexBuffer, indexAlloc, VMA_MEMORY_USAGE_GPU_ONLY, 0, info);
+		MIST_INFO("Created geometry pool");
+	}
+
+	VulkanGeometryPool::~VulkanGeometryPool() {
+		Clear();
+	}
+
+	GeometryRange VulkanGeometryPool::Upload(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+		GeometryRange range;
+		range.vertexCount = static_cast<uint32_t>(vertices.size());
+		range.indexCount = static_cast<uint32_t>(indices.size());
+		RecycleRetired(VulkanContext::GetContext().GetCompletedFrameNumber());
+		range.vertexOffset = Allocate(vertexAllocator, vertexBuffer, vertexAlloc, VERTEX_POOL_USAGE, sizeof(Vertex), range.vertexCount);
+		range.firstIndex = Allocate(indexAllocator, indexBuffer, indexAlloc, INDEX_POOL_USAGE, sizeof(uint32_t), range.indexCount);
+
+		if (range.vertexCount > 0)
+			SetBufferData(vertices.data(), sizeof(Vertex) * range.vertexCount, vertexBuffer, sizeof(Vertex) * range.vertexOffset);
+		if (range.indexCount > 0)
+			SetBufferData(indices.data(), sizeof(uint32_t) * range.indexCount, indexBuffer, sizeof(uint32_t) * range.firstIndex);
+
+		return range;
+	}
+
+	void VulkanGeometryPool::Free(const GeometryRange& range) {
+		retiredRanges.push_back({ VulkanContext::GetContext().GetFrameNumber(), range });
+	}
+
+	void VulkanGeometryPool::RecycleRetired(const uint64_t completedFrame) {
+		while (!retiredRanges.empty() && retiredRanges.front().frameNumber <= completedFrame) {
+			const GeometryRange& range = retiredRanges.front().range;
+			vertexAllocator.Free(range.vertexOffset, range.vertexCount);
+			indexAllocator.Free(range.firstIndex, range.indexCount);
+			retiredRanges.pop_front();
+		}
+	}
+
+	void VulkanGeometryPool::Bind() const {
+		VulkanContext& context = VulkanContext::GetContext();
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(context.GetCurrentFrameCommandBuffer(), 0, 1, &vertexBuffer, offsets);
+		vkCmdBindIndexBuffer(context.GetCurrentFrameCommandBuffer(), indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	void VulkanGeometryPool::Clear() {
+		VulkanContext& context = VulkanContext::GetContext();
+		retiredRanges.clear();
+
+		if (vertexBuffer != VK_NULL_HANDLE) {
+			vmaDestroyBuffer(context.GetAllocator(), vertexBuffer, vertexAlloc);
+			vertexBuffer = VK_NULL_HANDLE;
+		}
+
+		if (indexBuffer != VK_NULL_HANDLE) {
+			vmaDestroyBuffer(context.GetAllocator(), indexBuffer, indexAlloc);
+			indexBuffer = VK_NULL_HANDLE;
+		}
+
+		MIST_INFO("Destroyed geometry pool");
+	}
+
+	uint32_t VulkanGeometryPool::Allocate(RangeAllocator& allocator, VkBuffer& buffer, VmaAllocation& alloc, const VkBufferUsageFlags usage, const VkDeviceSize elementSize, const uint32_t count) {
+		if (count == 0)
+			return 0;
+
+		uint32_t offset = allocator.Allocate(count);
+		if (offset != RangeAllocator::INVALID_OFFSET)
+			return offset;
+
+		VulkanContext& context = VulkanContext::GetContext();
+		const uint32_t oldCapacity = allocator.GetCapacity();
+		const uint32_t newCapacity = std::max(oldCapacity * 2, oldCapacity + count);
+
+		// Staged copies into the old buffer have to land before it is copied, and draws still in flight read it
+		context.GetStagingRing().Flush();
+		vkDeviceWaitIdle(context.GetDevice());
+
+		// Every submitted frame has finished, only ranges retired this frame may still be drawn by what is being recorded.
+		// That may free enough to skip growing
+		const uint64_t frameNumber = context.GetFrameNumber();
+		RecycleRetired(frameNumber > 0 ? frameNumber - 1 : 0);
+		offset = allocator.Allocate(count);
+		if (offset != RangeAllocator::INVALID_OFFSET)
+			return offset;
+
+		VkBuffer newBuffer;
+		VmaAllocation newAlloc;
+		VmaAllocationInfo info {};
+		CreateBuffer(elementSize * newCapacity, usage, newBuffer, newAlloc, VMA_MEMORY_USAGE_GPU_ONLY, 0, info);
+		CopyBuffer(buffer, newBuffer, elementSize * oldCapacity);
+
+		// Draws recorded earlier this frame bound the old buffer
+		context.DeferRelease([vmaAllocator = context.GetAllocator(), buffer, alloc]() { vmaDestroyBuffer(vmaAllocator, buffer, alloc); });
+		buffer = newBuffer;
+		alloc = newAlloc;
+
+		allocator.Grow(newCapacity);
+		offset = allocator.Allocate(count);
+		MIST_ASSERT(offset != RangeAllocator::INVALID_OFFSET, "Geometry pool failed to grow");
+		MIST_INFO("Grew geometry pool buffer");
+		return offset;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include <deque>
+#include "renderer/GeometryPool.hpp"
+#include "renderer/RangeAllocator.hpp"
+
+namespace mist {
+	class VulkanGeometryPool : public GeometryPool {
+	public:
+		VulkanGeometryPool(const uint32_t vertexCapacity = 65536, const uint32_t indexCapacity = 262144);
+		~VulkanGeometryPool();
+
+		virtual GeometryRange Upload(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) override;
+		// The range is only handed out again once frames that may still draw from it have finished
+		virtual void Free(const GeometryRange& range) override;
+		virtual void Bind() const override;
+		virtual void Clear() override;
+
+		inline const VkBuffer GetVertexBuffer() const { return vertexBuffer; }
+		inline const VkBuffer GetIndexBuffer() const { return indexBuffer; }
+	private:
+		struct RetiredRange {
+			uint64_t frameNumber;	// Last frame that could have drawn it
+			GeometryRange range;
+		};
+
+		void RecycleRetired(const uint64_t completedFrame);
+		// Allocates count elements, growing the buffer and copying its contents across when full
+		uint32_t Allocate(RangeAllocator& allocator, VkBuffer& buffer, VmaAllocation& alloc, const VkBufferUsageFlags usage, const VkDeviceSize elementSize, const uint32_t count);
+
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VmaAllocation vertexAlloc;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		VmaAllocation indexAlloc;
+		RangeAllocator vertexAllocator;
+		RangeAllocator indexAllocator;
+		std::deque<RetiredRange> retiredRanges;	// Oldest first
+	};
+}
\ No newline at end of file
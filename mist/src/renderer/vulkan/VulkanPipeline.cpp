@@ -2,6 +2,7 @@
 #include "renderer/vulkan/VulkanContext.hpp"
 #include "VulkanDebug.hpp"
 #include <set>
+#include <cstddef>
 
 namespace mist {
 	void VulkanPipeline::Cleanup() {
@@ -11,20 +12,101 @@ namespace mist {
 			vkDestroyPipeline(context.GetDevice(), pipeline.second, context.GetAllocationCallbacks());
 		}
 		pipelines.clear();
+
+		// Builds still in flight must land before their layout and render pass are destroyed
+		for (std::pair<const std::string, std::future<VkPipeline>>& pending : pendingPipelines) {
+			VkPipeline pipeline = pending.second.get();
+			if (pipeline != VK_NULL_HANDLE)
+				vkDestroyPipeline(context.GetDevice(), pipeline, context.GetAllocationCallbacks());
+		}
+		pendingPipelines.clear();
 		
 		for (std::pair<const std::string, VkPipelineLayout>& layout : pipelineLayouts) {
 			vkDestroyPipelineLayout(context.GetDevice(), layout.second, context.GetAllocationCallbacks());
 		}
 		pipelineLayouts.clear();
+		bindlessPipelines.clear();
+	}
+
+	void VulkanPipeline::PublishReadyPipelines() {
+		for (auto pending = pendingPipelines.begin(); pending != pendingPipelines.end();) {
+			if (pending->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				++pending;
+				continue;
+			}
+
+			pipelines[pending->first] = pending->second.get();
+			pending = pendingPipelines.erase(pending);
+		}
+	}
+
+	void VulkanPipeline::RemovePipeline(const std::string& name) {
+		VulkanContext& context = VulkanContext::GetContext();
+
+		auto pending = pendingPipelines.find(name);
+		if (pending != pendingPipelines.end()) {
+			VkPipeline pipeline = pending->second.get();
+			if (pipeline != VK_NULL_HANDLE)
+				vkDestroyPipeline(context.GetDevice(), pipeline, context.GetAllocationCallbacks());
+			pendingPipelines.erase(pending);
+		}
+
+		auto pipeline = pipelines.find(name);
+		if (pipeline != pipelines.end()) {
+			vkDestroyPipeline(context.GetDevice(), pipeline->second, context.GetAllocationCallbacks());
+			pipelines.erase(pipeline);
+		}
+
+		auto layout = pipelineLayouts.find(name);
+		if (layout != pipelineLayouts.end()) {
+			vkDestroyPipelineLayout(context.GetDevice(), layout->second, context.GetAllocationCallbacks());
+			pipelineLayouts.erase(layout);
+		}
+
+		bindlessPipelines.erase(name);
 	}
 
-	void VulkanPipeline::CreateGraphicsPipeline(const VulkanShader* shader, const VkRenderPass& renderPass, const uint32_t colorAttachmentCount, VulkanDescriptor& descriptors) {
+	void VulkanPipeline::CreateGraphicsPipeline(const VulkanShader* shader, const VulkanPipelineTarget& target, VulkanDescriptor& descriptors) {
 		// going to have to generate all the configurations before they are used so at game launch or creating a cache file where all the shaders and variants are stored after compilation
 		// Hold onto the pipeline in a unorderedmap/dictionary so the pipelines can be loaded when needed
 		// read through this more https://zeux.io/2020/02/27/writing-an-efficient-vulkan-renderer/
 
 		VulkanContext& context = VulkanContext::GetContext();
 
+		std::vector<VkDescriptorSetLayout> setLayouts = descriptors.GetPipelineSetLayouts(shader);
+
+		VkPipelineLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		layoutInfo.pSetLayouts = setLayouts.data();
+		if (setLayouts.size() > MATERIAL_DESCRIPTOR_SET)
+			bindlessPipelines.insert(shader->GetName());
+
+		std::vector<VkPushConstantRange> pushConstantData;
+		for (const auto& res : shader->GetPushConstantResources()) {
+			VkPushConstantRange range{};
+			range.offset = res.second.offset;
+			range.size = res.second.size;
+			range.stageFlags = res.second.flags;
+			pushConstantData.push_back(range);
+		}
+		layoutInfo.pPushConstantRanges = pushConstantData.data();
+		layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantData.size());
+
+		VkPipelineLayout pipelineLayout;
+		CheckVkResult(vkCreatePipelineLayout(context.GetDevice(), &layoutInfo, context.GetAllocationCallbacks(), &pipelineLayout));
+		pipelineLayouts[shader->GetName()] = pipelineLayout;
+
+		// The layout is needed right away to bind descriptors, the pipeline builds on the compile workers and is
+		// picked up by PublishReadyPipelines at the start of a later frame
+		pendingPipelines[shader->GetName()] = context.GetPipelineCompiler().Submit([shader, pipelineLayout, target]() {
+			return BuildGraphicsPipeline(shader, pipelineLayout, target);
+		});
+	}
+
+	VkPipeline VulkanPipeline::BuildGraphicsPipeline(const VulkanShader* shader, const VkPipelineLayout pipelineLayout, const VulkanPipelineTarget& target) {
+		VulkanContext& context = VulkanContext::GetContext();
+
 		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
 		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -70,6 +152,7 @@ namespace mist {
 		depthStencil.back = {};
 
 		// 1 ColorBlendAttachmentState per attachment
+		const uint32_t colorAttachmentCount = static_cast<uint32_t>(target.colorFormats.size());
 		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachmentStates(colorAttachmentCount);
 		for (VkPipelineColorBlendAttachmentState& state : colorBlendAttachmentStates) {
 			state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
@@ -103,97 +186,56 @@ namespace mist {
 		dynamicState.dynamicStateCount = 2;
 		dynamicState.pDynamicStates = dynamicStates;
 
-		VkDescriptorSetLayout layout = descriptors.CreateDescriptorSetLayout(shader);
+		// Entries for constants a stage does not declare are ignored, so every stage gets the full set
+		const std::vector<SpecializationValue>& specializationValues = shader->GetSpecializationValues();
+		std::vector<VkSpecializationMapEntry> specializationEntries;
+		for (size_t i = 0; i < specializationValues.size(); ++i) {
+			VkSpecializationMapEntry entry{};
+			entry.constantID = specializationValues[i].constantID;
+			entry.offset = static_cast<uint32_t>(i * sizeof(SpecializationValue) + offsetof(SpecializationValue, value));
+			entry.size = sizeof(VkBool32);
+			specializationEntries.push_back(entry);
+		}
 
-		VkPipelineLayoutCreateInfo layoutInfo{};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		layoutInfo.setLayoutCount = 1;
-		layoutInfo.pSetLayouts = &layout;
+		VkSpecializationInfo specializationInfo{};
+		specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+		specializationInfo.pMapEntries = specializationEntries.data();
+		specializationInfo.dataSize = specializationValues.size() * sizeof(SpecializationValue);
+		specializationInfo.pData = specializationValues.data();
 
-		std::vector<VkPushConstantRange> pushConstantData;
-		for (const auto& res : shader->GetPushConstantResources()) {
-			VkPushConstantRange range{};
-			range.offset = res.second.offset;
-			range.size = res.second.size;
-			range.stageFlags = res.second.flags;
-			pushConstantData.push_back(range);
+		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+		for (const ShaderStageModule& stage : shader->GetStageModules()) {
+			VkPipelineShaderStageCreateInfo shaderStageInfo{};
+			shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			shaderStageInfo.stage = stage.stage;
+			shaderStageInfo.module = stage.module->GetModule();
+			shaderStageInfo.pName = "main";
+			shaderStageInfo.pSpecializationInfo = specializationEntries.empty() ? nullptr : &specializationInfo;
+			shaderStages.push_back(shaderStageInfo);
 		}
-		layoutInfo.pPushConstantRanges = pushConstantData.data();
-		layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantData.size());
-
-		VkPipelineLayout pipelineLayout;
-		CheckVkResult(vkCreatePipelineLayout(context.GetDevice(), &layoutInfo, context.GetAllocationCallbacks(), &pipelineLayout));
-		pipelineLayouts[shader->GetName()] = pipelineLayout;
 
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptons;
-		std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
-		std::set<VkShaderStageFlagBits> setStages;
 		std::set<uint32_t> setBindings;
 		for (const auto& res : shader->GetInputResources()) {
-			if (res.second.flags & VK_SHADER_STAGE_VERTEX_BIT) {
-				if (!setStages.contains(VK_SHADER_STAGE_VERTEX_BIT)) {
-					VkPipelineShaderStageCreateInfo shaderStageInfo{};
-					shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-					shaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-					shaderStageInfo.module = res.second.shaderModule;
-					shaderStageInfo.pName = "main";
-					shaderStages.push_back(shaderStageInfo);
-					setStages.insert(VK_SHADER_STAGE_VERTEX_BIT);
-				}
-
-				if (!setBindings.contains(res.second.binding)) {
-					VkVertexInputBindingDescription binding;
-					binding.binding = res.second.binding;
-					binding.stride = res.second.stride;
-					binding.inputRate = res.second.inputRate;
-					bindingDescriptions.push_back(binding);
-					setBindings.insert(res.second.binding);
-				}
-
-				VkVertexInputAttributeDescription attrib;
-				attrib.binding = res.second.binding;
-				attrib.location = res.second.location;
-				attrib.format = res.second.format;
-				attrib.offset = res.second.offset;
-				attributeDescriptons.push_back(attrib);
-			}
+			if (!(res.second.flags & VK_SHADER_STAGE_VERTEX_BIT))
+				continue;
 
-			if (res.second.flags & VK_SHADER_STAGE_FRAGMENT_BIT) {
-				if (!setStages.contains(VK_SHADER_STAGE_FRAGMENT_BIT)) {
-					VkPipelineShaderStageCreateInfo shaderStageInfo{};
-					shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-					shaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-					shaderStageInfo.module = res.second.shaderModule;
-					shaderStageInfo.pName = "main";
-					shaderStages.push_back(shaderStageInfo);
-					setStages.insert(VK_SHADER_STAGE_FRAGMENT_BIT);
-				}
-			}
-			
-			if (res.second.flags & VK_SHADER_STAGE_GEOMETRY_BIT) {
-				if (!setStages.contains(VK_SHADER_STAGE_GEOMETRY_BIT)) {
-					VkPipelineShaderStageCreateInfo shaderStageInfo{};
-					shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-					shaderStageInfo.stage = VK_SHADER_STAGE_GEOMETRY_BIT;
-					shaderStageInfo.module = res.second.shaderModule;
-					shaderStageInfo.pName = "main";
-					shaderStages.push_back(shaderStageInfo);
-					setStages.insert(VK_SHADER_STAGE_GEOMETRY_BIT);
-				}
-			}
-			
-			if (res.second.flags & VK_SHADER_STAGE_COMPUTE_BIT) {
-				if (!setStages.contains(VK_SHADER_STAGE_COMPUTE_BIT)) {
-					VkPipelineShaderStageCreateInfo shaderStageInfo{};
-					shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-					shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-					shaderStageInfo.module = res.second.shaderModule;
-					shaderStageInfo.pName = "main";
-					shaderStages.push_back(shaderStageInfo);
-					setStages.insert(VK_SHADER_STAGE_COMPUTE_BIT);
-				}
+			if (!setBindings.contains(res.second.binding)) {
+				VkVertexInputBindingDescription binding;
+				binding.binding = res.second.binding;
+				binding.stride = res.second.stride;
+				binding.inputRate = res.second.inputRate;
+				bindingDescriptions.push_back(binding);
+				setBindings.insert(res.second.binding);
 			}
+
+			VkVertexInputAttributeDescription attrib;
+			attrib.binding = res.second.binding;
+			attrib.location = res.second.location;
+			attrib.format = res.second.format;
+			attrib.offset = res.second.offset;
+			attributeDescriptons.push_back(attrib);
 		}
 
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
@@ -203,8 +245,17 @@ namespace mist {
 		vertexInputInfo.vertexAttributeDescriptionCount = (uint32_t)attributeDescriptons.size();
 		vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptons.data();
 
+		// Without a render pass the pipeline only needs to know the formats it will be drawing into
+		VkPipelineRenderingCreateInfo renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+		renderingInfo.colorAttachmentCount = colorAttachmentCount;
+		renderingInfo.pColorAttachmentFormats = target.colorFormats.data();
+		renderingInfo.depthAttachmentFormat = target.depthFormat;
+		renderingInfo.stencilAttachmentFormat = target.stencilFormat;
+
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = target.renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr;
 		pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
 		pipelineInfo.pStages = shaderStages.data();
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -216,14 +267,13 @@ namespace mist {
 		pipelineInfo.pColorBlendState = &colorBlending;
 		pipelineInfo.pDynamicState = &dynamicState;
 		pipelineInfo.layout = pipelineLayout;
-		pipelineInfo.renderPass = renderPass;
+		pipelineInfo.renderPass = target.renderPass;
 		pipelineInfo.subpass = 0;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		VkPipeline graphicsPipeline;
-		CheckVkResult(vkCreateGraphicsPipelines(context.GetDevice(), nullptr, 1, &pipelineInfo, context.GetAllocationCallbacks(), &graphicsPipeline));
-	
-		pipelines[shader->GetName()] = graphicsPipeline;
-	}
-}
+		VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+		CheckVkResult(vkCreateGraphicsPipelines(context.GetDevice(), context.GetPipelineCache(), 1, &pipelineInfo, context.GetAllocationCallbacks(), &graphicsPipeline));
 
+		return graphicsPipeline;
+	}
+}
\ No newline at end of file
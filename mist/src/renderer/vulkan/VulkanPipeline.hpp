@@ -1,23 +1,52 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <future>
 #include "renderer/vulkan/VulkanShader.hpp"
 #include "renderer/vulkan/VulkanDescriptors.hpp"
 
 namespace mist {
+	// What a pipeline is built against, a null render pass builds it for dynamic rendering with these formats
+	struct VulkanPipelineTarget {
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		std::vector<VkFormat> colorFormats;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+		VkFormat stencilFormat = VK_FORMAT_UNDEFINED;
+	};
+
 	class VulkanPipeline {
 	public:
 		VulkanPipeline() {}
 		~VulkanPipeline() {}
 
 		void Cleanup();
-		void CreateGraphicsPipeline(const VulkanShader* shaderResources, const VkRenderPass& renderPass, const uint32_t colorAttachmentCount, VulkanDescriptor& descriptors);
+		// Creates the layout now and queues the pipeline build, the shader must outlive the build
+		void CreateGraphicsPipeline(const VulkanShader* shaderResources, const VulkanPipelineTarget& target, VulkanDescriptor& descriptors);
+		// Called at the frame boundary so a pipeline never appears partway through recording
+		void PublishReadyPipelines();
+		// Drops the pipeline and layout built for a shader so its next bind rebuilds them, the GPU must be done with them
+		void RemovePipeline(const std::string& name);
 
-		bool HasPipeline(const std::string name) { return pipelines.contains(name); }		
-		VkPipeline& GetGraphicsPipeline(const std::string name) { return pipelines[name]; }
-		VkPipelineLayout& GetGraphicsPipelineLayout(const std::string name) { return pipelineLayouts[name]; }
+		bool HasPipeline(const std::string name) { return pipelines.contains(name); }
+		bool IsPipelinePending(const std::string& name) const { return pendingPipelines.contains(name); }
+		// Lookups never insert so recording workers can call them alongside each other
+		VkPipeline GetGraphicsPipeline(const std::string& name) const {
+			auto pipeline = pipelines.find(name);
+			return pipeline != pipelines.end() ? pipeline->second : VK_NULL_HANDLE;
+		}
+		VkPipelineLayout GetGraphicsPipelineLayout(const std::string& name) const {
+			auto layout = pipelineLayouts.find(name);
+			return layout != pipelineLayouts.end() ? layout->second : VK_NULL_HANDLE;
+		}
+		bool UsesBindless(const std::string& name) const { return bindlessPipelines.contains(name); }
 	private:
+		static VkPipeline BuildGraphicsPipeline(const VulkanShader* shader, const VkPipelineLayout pipelineLayout, const VulkanPipelineTarget& target);
+
 		std::unordered_map<std::string, VkPipelineLayout> pipelineLayouts;
 		std::unordered_map<std::string, VkPipeline> pipelines;
+		std::unordered_set<std::string> bindlessPipelines;
+		std::unordered_map<std::string, std::future<VkPipeline>> pendingPipelines;
 	};
 }
\ No newline at end of file
@@ -1,8 +1,8 @@
 #include "VulkanRenderAPI.hpp"
 #include "renderer/vulkan/VulkanContext.hpp"
 #include "data/RenderTypes.hpp"
-#include "Debug.hpp"
 #include "Application.hpp"
+#include "Debug.hpp"
 
 namespace mist {
 	void VulkanRenderAPI::Initialize() {
@@ -29,9 +29,9 @@ namespace mist {
 		context.EndFrame();
 	}
 
-	void VulkanRenderAPI::BeginRenderPass(const uint8_t renderDataID) {
+	void VulkanRenderAPI::BeginRenderPass(const uint8_t renderDataID, const bool parallelRecording) {
 		VulkanContext& context = VulkanContext::GetContext();
-		context.BeginRenderPass(renderDataID);
+		context.BeginRenderPass(renderDataID, parallelRecording);
 	}
 
 	void VulkanRenderAPI::EndRenderPass() {
@@ -39,40 +39,129 @@ namespace mist {
 		context.EndRenderPass();
 	}
 
-	void VulkanRenderAPI::UpdateDirectionalLight(const uint8_t renderDataID, const DirectionalLight& light) {
-		DirectionalLightData lightData;
-		lightData.u_LightDir = light.GetTransform().Forward();
-		lightData.u_LightColor = light.lightColor;
+	void VulkanRenderAPI::RecordParallel(const uint8_t renderDataID, const uint32_t jobCount, const std::function<void(const uint32_t job)>& record) {
+		VulkanContext& context = VulkanContext::GetContext();
+		if (!context.IsRenderPassSecondary()) {
+			for (uint32_t job = 0; job < jobCount; ++job)
+				record(job);
+			return;
+		}
+
+		// Workers only read the frame set, anything it still needs written this frame happens here first
+		Ref<VulkanRenderData> data = context.GetRenderData(renderDataID);
+		data->descriptors.PrepareFrameSet(context.GetCurrentFrameIndex());
+		context.ReserveRecordingSlots(jobCount);
+
+		std::vector<VkCommandBuffer> secondaryBuffers(jobCount);
+		std::vector<std::future<void>> jobs;
+		jobs.reserve(jobCount);
+		ThreadPool* threadPool = Application::Get().GetThreadPool();
+		for (uint32_t job = 1; job < jobCount; ++job) {
+			jobs.push_back(threadPool->Submit([&context, &secondaryBuffers, &record, job]() {
+				secondaryBuffers[job] = context.BeginSecondaryCommandBuffer(job);
+				record(job);
+				context.EndSecondaryCommandBuffer();
+			}));
+		}
+
+		// The calling thread takes the first job rather than waiting idle
+		if (jobCount > 0) {
+			secondaryBuffers[0] = context.BeginSecondaryCommandBuffer(0);
+			record(0);
+			context.EndSecondaryCommandBuffer();
+		}
+
+		for (std::future<void>& job : jobs)
+			job.get();
 
+		// Played back in job order so draws land in the same order they would inline
+		context.ExecuteSecondaryCommandBuffers(secondaryBuffers);
+	}
+
+	void VulkanRenderAPI::UpdateDirectionalLight(const uint8_t renderDataID, const Transform& transform, const DirectionalLight& light, const bool changed) {
 		VulkanContext& context = VulkanContext::GetContext();
 		Ref<VulkanRenderData> data = context.GetRenderData(renderDataID);
-		data->descriptors.UpdateUniformBuffer({ context.GetCurrentFrameIndex(), "DirectionalLightData" }, lightData);
+
+		// The arena is rewritten every frame so the data is kept here and only rebuilt on change
+		if (changed || !data->hasLightData) {
+			data->lightData.u_LightDir = transform.Forward();
+			data->lightData.u_LightColor = light.lightColor;
+			data->hasLightData = true;
+		}
+
+		data->descriptors.UpdateUniformBuffer(context.GetCurrentFrameIndex(), data->lightUniform, data->lightData);
 	}
 	
-	void VulkanRenderAPI::UpdateCamera(const uint8_t renderDataID, const Camera& camera) {
+	void VulkanRenderAPI::UpdateCamera(const uint8_t renderDataID, const Transform& transform, const Camera& camera) {
 		CameraData camData;
-		camData.u_ViewProjectionMatrix = camera.GetViewProjectionMatrix();
+		camData.u_ViewProjectionMatrix = camera.GetViewProjectionMatrix(transform);
 		
 		VulkanContext& context = VulkanContext::GetContext();
 		Ref<VulkanRenderData> data = context.GetRenderData(renderDataID);
-		data->descriptors.UpdateUniformBuffer({ context.GetCurrentFrameIndex(), "CameraData" }, camData);
+		data->descriptors.UpdateUniformBuffer(context.GetCurrentFrameIndex(), data->cameraUniform, camData);
+	}
+
+	uint32_t VulkanRenderAPI::UploadInstances(const uint8_t renderDataID, const std::vector<glm::mat4>& modelMatrices) {
+		VulkanContext& context = VulkanContext::GetContext();
+		Ref<VulkanRenderData> data = context.GetRenderData(renderDataID);
+		return data->descriptors.WriteInstanceData(context.GetCurrentFrameIndex(), modelMatrices.data(), static_cast<uint32_t>(modelMatrices.size()));
 	}
 
 	void VulkanRenderAPI::BindMeshRenderer(const uint8_t renderDataID, const MeshRenderer& meshRenderer) {
 		VulkanContext& context = VulkanContext::GetContext();
 		Ref<VulkanRenderData> data = context.GetRenderData(renderDataID);
 
-		meshRenderer.vBuffer->Bind();
-		meshRenderer.iBuffer->Bind();
-		vkCmdBindDescriptorSets(context.GetCurrentFrameCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, data->pipeline.GetGraphicsPipelineLayout(meshRenderer.shaderName), 0, 1, &data->descriptors.GetDescriptorSet(meshRenderer), 0, nullptr);
-		
-		glm::mat4 matrix = meshRenderer.GetTransform().GetLocalToWorldMatrix();
-		Application::Get().GetShaderLibrary()->Get(meshRenderer.shaderName)->SetUniformData(renderDataID, "ModelMatrix", sizeof(matrix), &matrix);
+		// Variants have their own pipelines, which are keyed by the variant's name rather than the renderer's shaderName
+		const std::string& pipelineName = Application::Get().GetShaderLibrary()->Get(meshRenderer.shaderHandle)->GetName();
+		VkPipelineLayout pipelineLayout = data->pipeline.GetGraphicsPipelineLayout(pipelineName);
+		if (context.IsRecordingSecondary())
+			data->descriptors.BindPreparedFrameSet(context.GetCurrentFrameCommandBuffer(), pipelineLayout);
+		else
+			data->descriptors.BindFrameSet(context.GetCurrentFrameCommandBuffer(), pipelineLayout, context.GetCurrentFrameIndex());
+
+		if (data->pipeline.UsesBindless(pipelineName))
+			context.GetBindlessHeap().Bind(context.GetCurrentFrameCommandBuffer(), pipelineLayout, MATERIAL_DESCRIPTOR_SET);
+	}
+
+	void VulkanRenderAPI::Draw(const IndexedDrawCommand& command) {
+		VulkanContext& context = VulkanContext::GetContext();
+		vkCmdDrawIndexed(context.GetCurrentFrameCommandBuffer(), command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+	}
+
+	static_assert(sizeof(IndexedDrawCommand) == sizeof(VkDrawIndexedIndirectCommand), "IndexedDrawCommand must match VkDrawIndexedIndirectCommand");
+
+	uint32_t VulkanRenderAPI::UploadDrawCommands(const uint8_t renderDataID, const std::vector<IndexedDrawCommand>& commands) {
+		VulkanContext& context = VulkanContext::GetContext();
+		Ref<VulkanRenderData> data = context.GetRenderData(renderDataID);
+		const uint32_t count = static_cast<uint32_t>(commands.size());
+		data->indirectCommands.Reserve(context.GetCurrentFrameIndex(), count);
+		return data->indirectCommands.Write(context.GetCurrentFrameIndex(), commands.data(), count);
 	}
 
-	void VulkanRenderAPI::Draw(uint32_t indexCount) {
+	void VulkanRenderAPI::DrawIndirect(const uint8_t renderDataID, const uint32_t firstCommand, const uint32_t commandCount) {
 		VulkanContext& context = VulkanContext::GetContext();
-		vkCmdDrawIndexed(context.GetCurrentFrameCommandBuffer(), indexCount, 1, 0, 0, 0);
+		Ref<VulkanRenderData> data = context.GetRenderData(renderDataID);
+		VkCommandBuffer commandBuffer = context.GetCurrentFrameCommandBuffer();
+		const VkBuffer buffer = data->indirectCommands.GetBuffer();
+		const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		const VkDeviceSize offset = static_cast<VkDeviceSize>(firstCommand) * stride;
+
+		if (context.GetEnabledFeatures().multiDrawIndirect) {
+			vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset, commandCount, stride);
+			return;
+		}
+
+		// Without multi draw each indirect call can only read one command
+		for (uint32_t i = 0; i < commandCount; ++i)
+			vkCmdDrawIndexedIndirect(commandBuffer, buffer, offset + static_cast<VkDeviceSize>(i) * stride, 1, stride);
+	}
+
+	RenderAPI::DrawMode VulkanRenderAPI::GetDrawMode() {
+		// Batches after the first start past instance 0, which indirect commands only allow with this feature
+		if (drawMode == RenderAPI::DrawMode::Indirect && !VulkanContext::GetContext().GetEnabledFeatures().drawIndirectFirstInstance)
+			return RenderAPI::DrawMode::Direct;
+
+		return drawMode;
 	}
 	
 	void VulkanRenderAPI::WaitForIdle() {
@@ -14,19 +14,27 @@ namespace mist {
 		virtual void WaitForIdle() override;
 		virtual void BeginFrame() override;
 		virtual void EndFrame() override;
-		virtual void BeginRenderPass(const uint8_t renderDataID) override;
+		virtual void BeginRenderPass(const uint8_t renderDataID, const bool parallelRecording = false) override;
+		virtual void RecordParallel(const uint8_t renderDataID, const uint32_t jobCount, const std::function<void(const uint32_t job)>& record) override;
 		virtual void EndRenderPass() override;
-		virtual void UpdateDirectionalLight(const uint8_t renderDataID, const DirectionalLight& light) override;
-		virtual void UpdateCamera(const uint8_t renderDataID, const Camera& camera) override;
+		virtual void UpdateDirectionalLight(const uint8_t renderDataID, const Transform& transform, const DirectionalLight& light, const bool changed) override;
+		virtual void UpdateCamera(const uint8_t renderDataID, const Transform& transform, const Camera& camera) override;
+		virtual uint32_t UploadInstances(const uint8_t renderDataID, const std::vector<glm::mat4>& modelMatrices) override;
 		virtual void BindMeshRenderer(const uint8_t renderDataID, const MeshRenderer& meshRenderer) override;
-		virtual void Draw(uint32_t indexCount) override;
+		virtual void Draw(const IndexedDrawCommand& command) override;
+		virtual uint32_t UploadDrawCommands(const uint8_t renderDataID, const std::vector<IndexedDrawCommand>& commands) override;
+		virtual void DrawIndirect(const uint8_t renderDataID, const uint32_t firstCommand, const uint32_t commandCount) override;
 
 		virtual RenderAPI::API GetAPI() override { return RenderAPI::API::Vulkan; }
 
 		virtual void SetVsyncMode(RenderAPI::VSYNC newMode) override { vsync = newMode; }
 		virtual RenderAPI::VSYNC GetVsyncMode() override { return vsync; }
+
+		virtual void SetDrawMode(RenderAPI::DrawMode newMode) override { drawMode = newMode; }
+		virtual RenderAPI::DrawMode GetDrawMode() override;
 	private:
 		glm::vec4 clearColor = glm::vec4(0,0,0,1);   // RGBA
 		RenderAPI::VSYNC vsync = RenderAPI::VSYNC::Off;
+		RenderAPI::DrawMode drawMode = RenderAPI::DrawMode::Direct;
 	};
 }
\ No newline at end of file
@@ -38,7 +38,7 @@ namespace mist {
 		return attachment;
 	}
 
-	void CreateRenderpass(const VkDevice device, const VkAllocationCallbacks* allocationCallbacks, const FramebufferProperties& properties, uint32_t& colorAttachmentCount, VkRenderPass& renderPass) {
+	void CreateRenderpass(const VkDevice device, const VkAllocationCallbacks* allocationCallbacks, const FramebufferProperties& properties, VkRenderPass& renderPass) {
 		if (renderPass != VK_NULL_HANDLE)
 			vkDestroyRenderPass(device, renderPass, allocationCallbacks);
 		
@@ -66,11 +66,9 @@ namespace mist {
 			}
 		}
 
-		colorAttachmentCount = static_cast<uint32_t>(colorAttachmentRefs.size());
-
 		VkSubpassDescription subpassInfo {};
 		subpassInfo.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpassInfo.colorAttachmentCount = colorAttachmentCount;
+		subpassInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachmentRefs.size());
 		subpassInfo.pColorAttachments = colorAttachmentRefs.data();
 		subpassInfo.pDepthStencilAttachment = hasDepthAttachment ? &depthAttachmentRef : nullptr;
 
@@ -94,6 +92,31 @@ namespace mist {
 		CheckVkResult(vkCreateRenderPass(device, &renderpassInfo, allocationCallbacks, &renderPass));
 	}
 
+	VkImageMemoryBarrier CreateAttachmentBarrier(const VkImage image, const VkImageAspectFlags aspect, const VkImageLayout oldLayout, const VkImageLayout newLayout, const VkAccessFlags srcAccess, const VkAccessFlags dstAccess) {
+		VkImageMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { aspect, 0, 1, 0, 1 };
+		return barrier;
+	}
+
+	VkRenderingAttachmentInfo CreateRenderingAttachment(const VkImageView view, const VkImageLayout layout, const VkAttachmentStoreOp storeOp, const VkClearValue& clearValue) {
+		VkRenderingAttachmentInfo attachment {};
+		attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+		attachment.imageView = view;
+		attachment.imageLayout = layout;
+		attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachment.storeOp = storeOp;
+		attachment.clearValue = clearValue;
+		return attachment;
+	}
+
 	void VulkanRenderData::ClearAndResizeFramebufferAttachments(const uint32_t count) {
 		for (std::vector<FramebufferAttachment>& attachments : framebufferAttachments) {
 			for (FramebufferAttachment& attachment : attachments) {
@@ -123,7 +146,10 @@ namespace mist {
 		vmaDestroyImage(context.GetAllocator(), image, imageAlloc);
 	}
 	
-	VulkanRenderData::VulkanRenderData(const uint8_t ID) : RenderData(ID) {}
+	VulkanRenderData::VulkanRenderData(const uint8_t ID) : RenderData(ID) {
+		cameraUniform = descriptors.GetUniformHandle("CameraData");
+		lightUniform = descriptors.GetUniformHandle("DirectionalLightData");
+	}
 	
 	void VulkanRenderData::Resize(const uint32_t width, const uint32_t height) {
 		VulkanContext& context = VulkanContext::GetContext();
@@ -138,6 +164,7 @@ namespace mist {
 
 		descriptors.Cleanup();
 		pipeline.Cleanup();
+		indirectCommands.Clear();
 
 		for (VkFramebuffer& framebuffer : framebuffers)
 			vkDestroyFramebuffer(context.GetDevice(), framebuffer, context.GetAllocationCallbacks());
@@ -159,6 +186,17 @@ namespace mist {
 		framebufferProperties = properties;
 		SetViewportAndScissor(properties.width, properties.height);
 
+		const std::vector<VkFormat> previousColorFormats = colorFormats;
+		const VkFormat previousDepthFormat = depthFormat;
+		SetAttachmentFormats(properties);
+
+		// Dynamic rendering pipelines only depend on the formats so a resize leaves them and their layouts alone.
+		// Otherwise they go first, a build still running on the compiler pool may be using the render pass about to be replaced
+		if (!context.IsDynamicRenderingEnabled() || colorFormats != previousColorFormats || depthFormat != previousDepthFormat) {
+			descriptors.Cleanup();
+			pipeline.Cleanup();
+		}
+
 		switch(properties.type) {
 		case FramebufferType::SWAPCHAIN:
 			CreateSwapchainFramebuffers(properties);
@@ -167,9 +205,106 @@ namespace mist {
 			CreateFramebuffers(properties);
 			break;
 		}
+	}
 
-		descriptors.Cleanup();
-		pipeline.Cleanup();
+	void VulkanRenderData::SetAttachmentFormats(const FramebufferProperties& properties) {
+		VulkanContext& context = VulkanContext::GetContext();
+		colorFormats.clear();
+		depthFormat = VK_FORMAT_UNDEFINED;
+		stencilFormat = VK_FORMAT_UNDEFINED;
+
+		// Matches the order attachments are handed to vkCmdBeginRendering, where the swapchain image comes first
+		if (properties.type == FramebufferType::SWAPCHAIN)
+			colorFormats.push_back(context.GetSwapchainFormat());
+
+		bool skippedSwapchainColor = false;
+		for (const FramebufferTextureProperties& attachment : properties.attachments) {
+			const VkFormat format = VulkanHelper::GetVkFormat(attachment.textureFormat);
+			if (VulkanHelper::IsDepthFormat(attachment.textureFormat)) {
+				depthFormat = format;
+				if (VulkanHelper::IsDepthStencilFormat(attachment.textureFormat))
+					stencilFormat = format;
+			} else if (properties.type == FramebufferType::SWAPCHAIN && !skippedSwapchainColor) {
+				skippedSwapchainColor = true;
+			} else {
+				colorFormats.push_back(format);
+			}
+		}
+	}
+
+	void VulkanRenderData::BeginRendering(const VkCommandBuffer commandBuffer, const uint32_t index, const VkClearValue& clearColor, const VkClearValue& clearDepth, const bool secondaryContents) {
+		VulkanContext& context = VulkanContext::GetContext();
+		std::vector<VkImageMemoryBarrier> barriers;
+		std::vector<VkRenderingAttachmentInfo> colorAttachments;
+		VkRenderingAttachmentInfo depthAttachment {};
+		bool hasDepth = false;
+		bool hasStencil = false;
+
+		// Every attachment is cleared so they start from undefined, waiting on whatever last read or wrote them
+		VkPipelineStageFlags srcStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		VkPipelineStageFlags dstStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		if (framebufferProperties.type == FramebufferType::SWAPCHAIN) {
+			barriers.push_back(CreateAttachmentBarrier(context.GetSwapchainImage(index), VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT));
+			colorAttachments.push_back(CreateRenderingAttachment(context.GetSwapchainImageView(index), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_STORE_OP_STORE, clearColor));
+		}
+
+		for (FramebufferAttachment& attachment : framebufferAttachments[index]) {
+			if (attachment.isDepth) {
+				const VkImageAspectFlags aspect = attachment.hasStencil ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+				barriers.push_back(CreateAttachmentBarrier(attachment.image, aspect, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+					VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT));
+				srcStages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+				dstStages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+				// Depth is only needed within the pass, same as the render pass path's DONT_CARE store
+				depthAttachment = CreateRenderingAttachment(attachment.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_STORE_OP_DONT_CARE, clearDepth);
+				hasDepth = true;
+				hasStencil = attachment.hasStencil;
+				continue;
+			}
+
+			// Offscreen color was last sampled by whatever displayed it
+			barriers.push_back(CreateAttachmentBarrier(attachment.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT));
+			srcStages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			colorAttachments.push_back(CreateRenderingAttachment(attachment.view, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_STORE_OP_STORE, clearColor));
+		}
+
+		vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+		VkRenderingInfo renderingInfo {};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+		renderingInfo.flags = secondaryContents ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+		renderingInfo.renderArea = scissor;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+		renderingInfo.pColorAttachments = colorAttachments.data();
+		renderingInfo.pDepthAttachment = hasDepth ? &depthAttachment : nullptr;
+		renderingInfo.pStencilAttachment = hasStencil ? &depthAttachment : nullptr;
+		vkCmdBeginRendering(commandBuffer, &renderingInfo);
+	}
+
+	void VulkanRenderData::EndRendering(const VkCommandBuffer commandBuffer, const uint32_t index) {
+		VulkanContext& context = VulkanContext::GetContext();
+		vkCmdEndRendering(commandBuffer);
+
+		// Leaves color in the same final layouts the render pass path does, depth already is in its own
+		std::vector<VkImageMemoryBarrier> barriers;
+		VkPipelineStageFlags dstStages = 0;
+		if (framebufferProperties.type == FramebufferType::SWAPCHAIN) {
+			barriers.push_back(CreateAttachmentBarrier(context.GetSwapchainImage(index), VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0));
+			dstStages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		}
+
+		for (FramebufferAttachment& attachment : framebufferAttachments[index]) {
+			if (attachment.isDepth)
+				continue;
+
+			barriers.push_back(CreateAttachmentBarrier(attachment.image, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+			dstStages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		}
+
+		if (!barriers.empty())
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, dstStages, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
 	}
 
 	void VulkanRenderData::CreateAttachmentImage(const FramebufferProperties& properties, const FramebufferTextureFormat& attachmentFormat, const size_t imageIndex, const size_t attachmentIndex) {
@@ -219,7 +354,9 @@ namespace mist {
 
 		CheckVkResult(vkCreateImageView(context.GetDevice(), &imageViewInfo, context.GetAllocationCallbacks(), &framebufferAttachments[imageIndex][attachmentIndex].view));
 
+		framebufferAttachments[imageIndex][attachmentIndex].format = imageInfo.format;
 		framebufferAttachments[imageIndex][attachmentIndex].isDepth = isDepthFormat;
+		framebufferAttachments[imageIndex][attachmentIndex].hasStencil = isDepthStencilFormat;
 	}
 
 	void VulkanRenderData::CreateSwapchainFramebuffers(const FramebufferProperties& properties) {
@@ -249,7 +386,11 @@ namespace mist {
 			}
 		}
 
-		CreateRenderpass(context.GetDevice(), context.GetAllocationCallbacks(), properties, colorAttachmentCount, renderPass);
+		// Dynamic rendering begins straight on the image views so only the images are ever rebuilt
+		if (context.IsDynamicRenderingEnabled())
+			return;
+
+		CreateRenderpass(context.GetDevice(), context.GetAllocationCallbacks(), properties, renderPass);
 
 		ClearAndResizeFramebuffers(context.GetSwapchainImageCount());
 		for (size_t i = 0; i < context.GetSwapchainImageCount(); ++i) {
@@ -287,7 +428,11 @@ namespace mist {
 			}
 		}
 
-		CreateRenderpass(context.GetDevice(), context.GetAllocationCallbacks(), properties, colorAttachmentCount, renderPass);
+		// Dynamic rendering begins straight on the image views so only the images are ever rebuilt
+		if (context.IsDynamicRenderingEnabled())
+			return;
+
+		CreateRenderpass(context.GetDevice(), context.GetAllocationCallbacks(), properties, renderPass);
 
 		ClearAndResizeFramebuffers(framebufferCount);		
 		for (size_t i = 0; i < framebufferCount; ++i) {
@@ -3,6 +3,7 @@
 #include "renderer/Framebuffer.hpp"
 #include "renderer/vulkan/VulkanPipeline.hpp"
 #include "renderer/vulkan/VulkanDescriptors.hpp"
+#include "data/RenderTypes.hpp"
 
 // TODO: Add additional FramebufferType of PING PONG which would allow for creation of two sets of framebuffers that will be switched between
 
@@ -11,7 +12,9 @@ namespace mist {
 		VkImage image;
 		VkImageView view;
 		VmaAllocation imageAlloc;
+		VkFormat format;
 		bool isDepth;
+		bool hasStencil;
 
 		void Cleanup();
 	};
@@ -26,17 +29,27 @@ namespace mist {
 		void CreateRenderData(FramebufferProperties& properties);
 		void Cleanup();
 		
-		inline void CreateGraphicsPipeline(const VulkanShader* shader) { pipeline.CreateGraphicsPipeline(shader, renderPass, colorAttachmentCount, descriptors); }
+		inline void CreateGraphicsPipeline(const VulkanShader* shader) { pipeline.CreateGraphicsPipeline(shader, { renderPass, colorFormats, depthFormat, stencilFormat }, descriptors); }
+		// Dynamic rendering counterparts of a render pass begin and end, the layout transitions the pass did are barriers here
+		void BeginRendering(const VkCommandBuffer commandBuffer, const uint32_t index, const VkClearValue& clearColor, const VkClearValue& clearDepth, const bool secondaryContents);
+		void EndRendering(const VkCommandBuffer commandBuffer, const uint32_t index);
 		inline VkImageView GetFirstFramebufferImageView() { return framebufferAttachments[0][0].view; }
 		VkImageLayout GetFirstFramebufferImageLayout();
 		
 		VulkanPipeline pipeline;
 		VulkanDescriptor descriptors;
 		
-		VkRenderPass renderPass = VK_NULL_HANDLE;
+		VkRenderPass renderPass = VK_NULL_HANDLE;	// Never created under dynamic rendering
 		VkViewport viewport;
 		VkRect2D scissor;
-		uint32_t colorAttachmentCount = 0;
+		std::vector<VkFormat> colorFormats;	// In the order the pipelines write them, the swapchain image first
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+		VkFormat stencilFormat = VK_FORMAT_UNDEFINED;
+		UniformHandle cameraUniform;
+		UniformHandle lightUniform;
+		DirectionalLightData lightData {};	// Rebuilt on change, pushed to the uniform arena every frame
+		bool hasLightData = false;
+		FrameRegionBuffer indirectCommands { VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, sizeof(VkDrawIndexedIndirectCommand), 256 };
 		std::vector<std::vector<FramebufferAttachment>> framebufferAttachments;
 		std::vector<VkFramebuffer> framebuffers;
 	private:
@@ -44,6 +57,7 @@ namespace mist {
 		void CreateFramebuffers(const FramebufferProperties& properties);
 		void ClearAndResizeFramebufferAttachments(const uint32_t count);
 		void ClearAndResizeFramebuffers(const uint32_t count);
+		void SetAttachmentFormats(const FramebufferProperties& properties);
 		void CreateAttachmentImage(const FramebufferProperties& properties, const FramebufferTextureFormat& attachmentFormat, const size_t imageIndex, const size_t attachmentIndex);
 		void SetViewportAndScissor(const uint32_t width, const uint32_t height);
 	};
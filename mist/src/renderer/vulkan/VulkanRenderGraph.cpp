@@ -0,0 +1,382 @@
+#include "renderer/vulkan/VulkanRenderGraph.hpp"
+#include <algorithm>
+#include "renderer/vulkan/VulkanContext.hpp"
+#include "renderer/vulkan/VulkanHelper.hpp"
+#include "renderer/vulkan/VulkanDebug.hpp"
+#include "Application.hpp"
+#include "Debug.hpp"
+
+namespace mist {
+	struct VulkanAccessInfo {
+		VkImageLayout layout;
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+	};
+
+	static VulkanAccessInfo GetAccessInfo(const RenderGraphAccess access) {
+		switch (access) {
+		case RenderGraphAccess::ColorAttachment:
+			return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+		case RenderGraphAccess::DepthAttachment:
+			return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+		case RenderGraphAccess::ShaderRead:
+			return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+		case RenderGraphAccess::None:
+		default:
+			return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0 };
+		}
+	}
+
+	static VkImageAspectFlags GetAspectMask(const FramebufferTextureFormat format) {
+		if (VulkanHelper::IsDepthStencilFormat(format))
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+
+		if (VulkanHelper::IsDepthFormat(format))
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+
+	VulkanRenderGraph::~VulkanRenderGraph() {
+		Cleanup();
+	}
+
+	void VulkanRenderGraph::Execute() {
+		if (!compiled)
+			Compile();
+
+		VulkanContext& context = VulkanContext::GetContext();
+		for (uint32_t i = 0; i < passes.size(); ++i) {
+			const PassNode& pass = passes[i];
+			if (pass.culled)
+				continue;
+
+			VkCommandBuffer commandBuffer = context.GetCurrentFrameCommandBuffer();
+			RecordBarriers(commandBuffer, pass);
+
+			if (pass.renderData != nullptr) {
+				context.BeginRenderPass(pass.renderData->GetRenderDataID(), pass.parallelRecording);
+				if (pass.execute)
+					pass.execute();
+				context.EndRenderPass();
+				continue;
+			}
+
+			if (pass.writes.empty()) {
+				if (pass.execute)
+					pass.execute();
+				continue;
+			}
+
+			const PassTarget& target = passTargets[i];
+			if (context.IsDynamicRenderingEnabled()) {
+				VkRenderingInfo renderingInfo {};
+				renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+				renderingInfo.renderArea = { { 0, 0 }, target.extent };
+				renderingInfo.layerCount = 1;
+				renderingInfo.colorAttachmentCount = static_cast<uint32_t>(target.colorAttachments.size());
+				renderingInfo.pColorAttachments = target.colorAttachments.data();
+				renderingInfo.pDepthAttachment = target.hasDepthAttachment ? &target.depthAttachment : nullptr;
+				vkCmdBeginRendering(commandBuffer, &renderingInfo);
+			} else {
+				VkRenderPassBeginInfo renderPassInfo {};
+				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				renderPassInfo.renderPass = target.renderPass;
+				renderPassInfo.framebuffer = target.framebuffer;
+				renderPassInfo.renderArea.offset = { 0, 0 };
+				renderPassInfo.renderArea.extent = target.extent;
+				renderPassInfo.clearValueCount = static_cast<uint32_t>(target.clearValues.size());
+				renderPassInfo.pClearValues = target.clearValues.data();
+				vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			}
+
+			const VkViewport viewport = { 0, 0, static_cast<float>(target.extent.width), static_cast<float>(target.extent.height), 0.0f, 1.0f };
+			const VkRect2D scissor = { { 0, 0 }, target.extent };
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+			if (pass.execute)
+				pass.execute();
+
+			if (context.IsDynamicRenderingEnabled())
+				vkCmdEndRendering(commandBuffer);
+			else
+				vkCmdEndRenderPass(commandBuffer);
+		}
+	}
+
+	void VulkanRenderGraph::OnCompile() {
+		Cleanup();
+		CreateTransients();
+
+		passTargets.assign(passes.size(), {});
+		for (uint32_t i = 0; i < passes.size(); ++i) {
+			if (!passes[i].culled && passes[i].renderData == nullptr && !passes[i].writes.empty())
+				CreatePassTarget(i);
+		}
+	}
+
+	void VulkanRenderGraph::CreateTransients() {
+		VulkanContext& context = VulkanContext::GetContext();
+		transients.assign(textures.size(), {});
+
+		// Images are created without memory so their requirements can decide which of them share a block
+		std::vector<RenderGraphMemoryRequirements> requirements(textures.size());
+		std::vector<VkDeviceSize> alignments(textures.size(), 1);
+		for (RenderGraphTexture i = 0; i < textures.size(); ++i) {
+			const TextureNode& texture = textures[i];
+			if (texture.IsImported() || !texture.IsUsed())
+				continue;
+
+			VkImageCreateInfo imageInfo {};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent = { texture.desc.width, texture.desc.height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = VulkanHelper::GetVkFormat(texture.desc.format);
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = (VulkanHelper::IsDepthFormat(texture.desc.format) ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT) | VK_IMAGE_USAGE_SAMPLED_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			CheckVkResult(vkCreateImage(context.GetDevice(), &imageInfo, context.GetAllocationCallbacks(), &transients[i].image));
+
+			VkMemoryRequirements memoryRequirements;
+			vkGetImageMemoryRequirements(context.GetDevice(), transients[i].image, &memoryRequirements);
+			requirements[i] = { memoryRequirements.size, memoryRequirements.memoryTypeBits };
+			alignments[i] = memoryRequirements.alignment;
+		}
+
+		const RenderGraphAliasing aliasing = AssignAliases(requirements);
+
+		std::vector<VkMemoryRequirements> blockRequirements(aliasing.blocks.size());
+		for (size_t block = 0; block < aliasing.blocks.size(); ++block) {
+			blockRequirements[block].size = aliasing.blocks[block].size;
+			blockRequirements[block].memoryTypeBits = aliasing.blocks[block].compatibleMask;
+			blockRequirements[block].alignment = 1;
+		}
+
+		for (RenderGraphTexture i = 0; i < textures.size(); ++i) {
+			const uint32_t block = aliasing.textureBlocks[i];
+			if (block != RenderGraphAliasing::INVALID_BLOCK)
+				blockRequirements[block].alignment = std::max(blockRequirements[block].alignment, alignments[i]);
+		}
+
+		VmaAllocationCreateInfo allocInfo {};
+		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+		memoryBlocks.assign(aliasing.blocks.size(), nullptr);
+		for (size_t block = 0; block < aliasing.blocks.size(); ++block)
+			CheckVkResult(vmaAllocateMemory(context.GetAllocator(), &blockRequirements[block], &allocInfo, &memoryBlocks[block], nullptr));
+
+		size_t transientCount = 0;
+		for (RenderGraphTexture i = 0; i < textures.size(); ++i) {
+			const uint32_t block = aliasing.textureBlocks[i];
+			if (block == RenderGraphAliasing::INVALID_BLOCK)
+				continue;
+
+			// Every image sits at the start of its block, the barrier on its first use discards what was there before
+			CheckVkResult(vmaBindImageMemory(context.GetAllocator(), memoryBlocks[block], transients[i].image));
+
+			VkImageViewCreateInfo viewInfo {};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = transients[i].image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = VulkanHelper::GetVkFormat(textures[i].desc.format);
+			viewInfo.subresourceRange.aspectMask = GetAspectMask(textures[i].desc.format);
+			viewInfo.subresourceRange.baseMipLevel = 0;
+			viewInfo.subresourceRange.levelCount = 1;
+			viewInfo.subresourceRange.baseArrayLayer = 0;
+			viewInfo.subresourceRange.layerCount = 1;
+			CheckVkResult(vkCreateImageView(context.GetDevice(), &viewInfo, context.GetAllocationCallbacks(), &transients[i].view));
+			++transientCount;
+		}
+
+		if (transientCount > 0)
+			MIST_INFO("Render graph placed {0} transient textures in {1} memory blocks", transientCount, memoryBlocks.size());
+	}
+
+	void VulkanRenderGraph::CreatePassTarget(const uint32_t pass) {
+		VulkanContext& context = VulkanContext::GetContext();
+		const PassNode& node = passes[pass];
+		PassTarget& target = passTargets[pass];
+
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorAttachmentRefs;
+		std::vector<VkImageView> views;
+		VkAttachmentReference depthAttachmentRef {};
+		bool hasDepthAttachment = false;
+
+		const glm::vec4 color = Application::Get().GetRenderAPI()->GetClearColor();
+		target.extent = { textures[node.writes[0].texture].desc.width, textures[node.writes[0].texture].desc.height };
+
+		for (const TextureAccess& write : node.writes) {
+			const TextureNode& texture = textures[write.texture];
+			const VkImageLayout layout = GetAccessInfo(write.access).layout;
+			MIST_ASSERT(texture.desc.width == target.extent.width && texture.desc.height == target.extent.height, std::string("Attachments of render graph pass ") + node.name + " differ in size");
+
+			// Barriers move attachments into and out of the pass's layout, so the render pass itself never transitions
+			VkAttachmentDescription attachment {};
+			attachment.format = VulkanHelper::GetVkFormat(texture.desc.format);
+			attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+			attachment.loadOp = write.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+			// Nothing after this pass reads it so the results never need writing back
+			attachment.storeOp = texture.lastPass == pass ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+
+			VkRenderingAttachmentInfo renderingAttachment {};
+			renderingAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+			renderingAttachment.imageView = transients[write.texture].view;
+			renderingAttachment.imageLayout = layout;
+			renderingAttachment.loadOp = attachment.loadOp;
+			renderingAttachment.storeOp = attachment.storeOp;
+			attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			attachment.initialLayout = layout;
+			attachment.finalLayout = layout;
+
+			VkAttachmentReference ref {};
+			ref.attachment = static_cast<uint32_t>(attachments.size());
+			ref.layout = layout;
+
+			VkClearValue clearValue {};
+			if (write.access == RenderGraphAccess::DepthAttachment) {
+				clearValue.depthStencil = { 1.0, 0 };
+				depthAttachmentRef = ref;
+				hasDepthAttachment = true;
+				renderingAttachment.clearValue = clearValue;
+				target.depthAttachment = renderingAttachment;
+				target.hasDepthAttachment = true;
+			} else {
+				clearValue.color = { color.r, color.g, color.b, color.a };
+				colorAttachmentRefs.push_back(ref);
+				renderingAttachment.clearValue = clearValue;
+				target.colorAttachments.push_back(renderingAttachment);
+			}
+
+			attachments.push_back(attachment);
+			views.push_back(transients[write.texture].view);
+			target.clearValues.push_back(clearValue);
+		}
+
+		// Dynamic rendering begins on the views directly, no render pass objects to build
+		if (context.IsDynamicRenderingEnabled())
+			return;
+
+		VkSubpassDescription subpassInfo {};
+		subpassInfo.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpassInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachmentRefs.size());
+		subpassInfo.pColorAttachments = colorAttachmentRefs.data();
+		subpassInfo.pDepthStencilAttachment = hasDepthAttachment ? &depthAttachmentRef : nullptr;
+
+		VkRenderPassCreateInfo renderPassInfo {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpassInfo;
+		CheckVkResult(vkCreateRenderPass(context.GetDevice(), &renderPassInfo, context.GetAllocationCallbacks(), &target.renderPass));
+
+		VkFramebufferCreateInfo framebufferInfo {};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = target.renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		framebufferInfo.pAttachments = views.data();
+		framebufferInfo.width = target.extent.width;
+		framebufferInfo.height = target.extent.height;
+		framebufferInfo.layers = 1;
+		CheckVkResult(vkCreateFramebuffer(context.GetDevice(), &framebufferInfo, context.GetAllocationCallbacks(), &target.framebuffer));
+	}
+
+	void VulkanRenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const PassNode& pass) const {
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+		VkMemoryBarrier memoryBarrier {};
+		memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		bool hasMemoryBarrier = false;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+
+		for (const RenderGraphBarrier& barrier : pass.barriers) {
+			const TextureNode& texture = textures[barrier.texture];
+			const VulkanAccessInfo before = GetAccessInfo(barrier.before);
+			const VulkanAccessInfo after = GetAccessInfo(barrier.after);
+
+			if (texture.IsImported()) {
+				// Render data passes move their attachments between layouts themselves, only the ordering is left
+				if (barrier.before == RenderGraphAccess::None)
+					continue;
+
+				memoryBarrier.srcAccessMask |= before.access;
+				memoryBarrier.dstAccessMask |= after.access;
+				srcStages |= before.stages;
+				dstStages |= after.stages;
+				hasMemoryBarrier = true;
+				continue;
+			}
+
+			VkImageMemoryBarrier imageBarrier {};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.oldLayout = before.layout;
+			imageBarrier.newLayout = after.layout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = transients[barrier.texture].image;
+			imageBarrier.subresourceRange = { GetAspectMask(texture.desc.format), 0, 1, 0, 1 };
+			imageBarrier.dstAccessMask = after.access;
+			dstStages |= after.stages;
+
+			if (barrier.before == RenderGraphAccess::None) {
+				// The memory may still be in use by a texture this one aliases, so everything before has to finish
+				imageBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+				srcStages |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+			} else {
+				imageBarrier.srcAccessMask = before.access;
+				srcStages |= before.stages;
+			}
+
+			imageBarriers.push_back(imageBarrier);
+		}
+
+		if (!hasMemoryBarrier && imageBarriers.empty())
+			return;
+
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			srcStages,
+			dstStages,
+			0,
+			hasMemoryBarrier ? 1 : 0, &memoryBarrier,
+			0, nullptr,
+			static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data()
+		);
+	}
+
+	void VulkanRenderGraph::Cleanup() {
+		if (transients.empty() && memoryBlocks.empty() && passTargets.empty())
+			return;
+
+		// Recompiles are rare, waiting is simpler than deferring the destruction past every frame in flight
+		VulkanContext& context = VulkanContext::GetContext();
+		vkDeviceWaitIdle(context.GetDevice());
+
+		for (PassTarget& target : passTargets) {
+			if (target.framebuffer != VK_NULL_HANDLE)
+				vkDestroyFramebuffer(context.GetDevice(), target.framebuffer, context.GetAllocationCallbacks());
+			if (target.renderPass != VK_NULL_HANDLE)
+				vkDestroyRenderPass(context.GetDevice(), target.renderPass, context.GetAllocationCallbacks());
+		}
+		passTargets.clear();
+
+		for (TransientImage& transient : transients) {
+			if (transient.view != VK_NULL_HANDLE)
+				vkDestroyImageView(context.GetDevice(), transient.view, context.GetAllocationCallbacks());
+			if (transient.image != VK_NULL_HANDLE)
+				vkDestroyImage(context.GetDevice(), transient.image, context.GetAllocationCallbacks());
+		}
+		transients.clear();
+
+		for (VmaAllocation block : memoryBlocks)
+			vmaFreeMemory(context.GetAllocator(), block);
+		memoryBlocks.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include "renderer/RenderGraph.hpp"
+
+namespace mist {
+	class VulkanRenderGraph : public RenderGraph {
+	public:
+		VulkanRenderGraph() {}
+		~VulkanRenderGraph();
+
+		virtual void Execute() override;
+
+		VkImageView GetTextureView(const RenderGraphTexture texture) const { return transients[texture].view; }
+	protected:
+		virtual void OnCompile() override;
+	private:
+		struct TransientImage {
+			VkImage image = VK_NULL_HANDLE;
+			VkImageView view = VK_NULL_HANDLE;
+		};
+
+		// Attachments for a pass whose attachments are all transient, the render pass and framebuffer are left null under dynamic rendering
+		struct PassTarget {
+			VkRenderPass renderPass = VK_NULL_HANDLE;
+			VkFramebuffer framebuffer = VK_NULL_HANDLE;
+			VkExtent2D extent {};
+			std::vector<VkClearValue> clearValues;
+			std::vector<VkRenderingAttachmentInfo> colorAttachments;
+			VkRenderingAttachmentInfo depthAttachment {};
+			bool hasDepthAttachment = false;
+		};
+
+		void CreateTransients();
+		void CreatePassTarget(const uint32_t pass);
+		void Cleanup();
+		void RecordBarriers(VkCommandBuffer commandBuffer, const PassNode& pass) const;
+
+		std::vector<TransientImage> transients;	// [texture], left empty for imported textures
+		std::vector<VmaAllocation> memoryBlocks;
+		std::vector<PassTarget> passTargets;	// [pass]
+	};
+}
\ No newline at end of file
@@ -1,157 +1,47 @@
 #include "VulkanShader.hpp"
-#include <glslang/SPIRV/GlslangToSpv.h>
-#include <spirv_cross/spirv_hlsl.hpp>
 #include <filesystem>
+#include <format>
+#include <mutex>
 #include "renderer/vulkan/VulkanContext.hpp"
 #include "Debug.hpp"
 #include "VulkanDebug.hpp"
-#include "PlatformUtils.hpp"
 
 namespace mist {
-	static TBuiltInResource GetDefaultResources() {
-		TBuiltInResource resources = {};
-		resources.maxLights = 32;
-		resources.maxClipPlanes = 6;
-		resources.maxTextureUnits = 32;
-		resources.maxTextureCoords = 32;
-		resources.maxVertexAttribs = 64;
-		resources.maxVertexUniformComponents = 4096;
-		resources.maxVaryingFloats = 64;
-		resources.maxVertexTextureImageUnits = 32;
-		resources.maxCombinedTextureImageUnits = 80;
-		resources.maxTextureImageUnits = 32;
-		resources.maxFragmentUniformComponents = 4096;
-		resources.maxDrawBuffers = 32;
-		resources.maxVertexUniformVectors = 128;
-		resources.maxVaryingVectors = 8;
-		resources.maxFragmentUniformVectors = 16;
-		resources.maxVertexOutputVectors = 16;
-		resources.maxFragmentInputVectors = 15;
-		resources.minProgramTexelOffset = -8;
-		resources.maxProgramTexelOffset = 7;
-		resources.maxClipDistances = 8;
-		resources.maxComputeWorkGroupCountX = 65535;
-		resources.maxComputeWorkGroupCountY = 65535;
-		resources.maxComputeWorkGroupCountZ = 65535;
-		resources.maxComputeWorkGroupSizeX = 1024;
-		resources.maxComputeWorkGroupSizeY = 1024;
-		resources.maxComputeWorkGroupSizeZ = 64;
-		resources.maxComputeUniformComponents = 1024;
-		resources.maxComputeTextureImageUnits = 16;
-		resources.maxComputeImageUniforms = 8;
-		resources.maxComputeAtomicCounters = 8;
-		resources.maxComputeAtomicCounterBuffers = 1;
-		resources.maxVaryingComponents = 60;
-		resources.maxVertexOutputComponents = 64;
-		resources.maxGeometryInputComponents = 64;
-		resources.maxGeometryOutputComponents = 128;
-		resources.maxFragmentInputComponents = 128;
-		resources.maxImageUnits = 8;
-		resources.maxCombinedImageUnitsAndFragmentOutputs = 8;
-		resources.maxCombinedShaderOutputResources = 8;
-		resources.maxImageSamples = 0;
-		resources.maxVertexImageUniforms = 0;
-		resources.maxTessControlImageUniforms = 0;
-		resources.maxTessEvaluationImageUniforms = 0;
-		resources.maxGeometryImageUniforms = 0;
-		resources.maxFragmentImageUniforms = 8;
-		resources.maxCombinedImageUniforms = 8;
-		resources.maxGeometryTextureImageUnits = 16;
-		resources.maxGeometryOutputVertices = 256;
-		resources.maxGeometryTotalOutputComponents = 1024;
-		resources.maxGeometryUniformComponents = 1024;
-		resources.maxGeometryVaryingComponents = 64;
-		resources.maxTessControlInputComponents = 128;
-		resources.maxTessControlOutputComponents = 128;
-		resources.maxTessControlTextureImageUnits = 16;
-		resources.maxTessControlUniformComponents = 1024;
-		resources.maxTessControlTotalOutputComponents = 4096;
-		resources.maxTessEvaluationInputComponents = 128;
-		resources.maxTessEvaluationOutputComponents = 128;
-		resources.maxTessEvaluationTextureImageUnits = 16;
-		resources.maxTessEvaluationUniformComponents = 1024;
-		resources.maxTessPatchComponents = 120;
-		resources.maxPatchVertices = 32;
-		resources.maxTessGenLevel = 64;
-		resources.maxViewports = 16;
-		resources.maxVertexAtomicCounters = 0;
-		resources.maxTessControlAtomicCounters = 0;
-		resources.maxTessEvaluationAtomicCounters = 0;
-		resources.maxGeometryAtomicCounters = 0;
-		resources.maxFragmentAtomicCounters = 8;
-		resources.maxCombinedAtomicCounters = 8;
-		resources.maxAtomicCounterBindings = 1;
-		resources.maxVertexAtomicCounterBuffers = 0;
-		resources.maxTessControlAtomicCounterBuffers = 0;
-		resources.maxTessEvaluationAtomicCounterBuffers = 0;
-		resources.maxGeometryAtomicCounterBuffers = 0;
-		resources.maxFragmentAtomicCounterBuffers = 1;
-		resources.maxCombinedAtomicCounterBuffers = 1;
-		resources.maxAtomicCounterBufferSize = 16384;
-		resources.maxTransformFeedbackBuffers = 4;
-		resources.maxTransformFeedbackInterleavedComponents = 64;
-		resources.maxCullDistances = 8;
-		resources.maxCombinedClipAndCullDistances = 8;
-		resources.maxSamples = 4;
-		resources.limits.nonInductiveForLoops = 1;
-		resources.limits.whileLoops = 1;
-		resources.limits.doWhileLoops = 1;
-		resources.limits.generalUniformIndexing = 1;
-		resources.limits.generalAttributeMatrixVectorIndexing = 1;
-		resources.limits.generalVaryingIndexing = 1;
-		resources.limits.generalSamplerIndexing = 1;
-		resources.limits.generalVariableIndexing = 1;
-		resources.limits.generalConstantMatrixVectorIndexing = 1;
-
-		return resources;
+	// Keyed by SPIR-V hash so variants that leave a stage untouched share its module. Reloads create modules
+	// on worker threads so lookups are locked
+	static std::unordered_map<uint64_t, std::weak_ptr<VulkanShaderModule>> sharedModules;
+	static std::mutex sharedModulesMutex;
+
+	// Drops the entries whose module went with its last user, called whenever a shader lets go of its modules
+	static void PruneSharedModules() {
+		std::lock_guard<std::mutex> lock(sharedModulesMutex);
+		std::erase_if(sharedModules, [](const std::pair<const uint64_t, std::weak_ptr<VulkanShaderModule>>& entry) { return entry.second.expired(); });
 	}
 
-	static EShLanguage ShaderTypeFromString(const std::string& type) {
-		if (type == "vertex" || type == "vert") return EShLangVertex;
-		if (type == "fragment" || type == "frag" || type == "pixel") return EShLangFragment;
-		if (type == "compute" || type == "comp") return EShLangCompute;
-		if (type == "geometry" || type == "geo") return EShLangGeometry;
+	VulkanShaderModule::VulkanShaderModule(const std::vector<uint32_t>& spirv) {
+		VkShaderModuleCreateInfo info{};
+		info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		info.codeSize = spirv.size() * sizeof(uint32_t);
+		info.pCode = spirv.data();
 
-		MIST_ASSERT(false, "Unknown shader type, defaulting to vertex");
-		return EShLangVertex;
+		VulkanContext& context = VulkanContext::GetContext();
+		CheckVkResult(vkCreateShaderModule(context.GetDevice(), &info, context.GetAllocationCallbacks(), &module));
 	}
 
-	static VkShaderStageFlagBits EShLanguageToVkStageFlags(EShLanguage stage) {
-		switch (stage) {
-		case EShLangVertex:         return VK_SHADER_STAGE_VERTEX_BIT;
-		case EShLangTessControl:    return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
-		case EShLangTessEvaluation: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
-		case EShLangGeometry:       return VK_SHADER_STAGE_GEOMETRY_BIT;
-		case EShLangFragment:       return VK_SHADER_STAGE_FRAGMENT_BIT;
-		case EShLangCompute:        return VK_SHADER_STAGE_COMPUTE_BIT;
-		case EShLangRayGen:         return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
-		case EShLangIntersect:      return VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
-		case EShLangAnyHit:         return VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
-		case EShLangClosestHit:     return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
-		case EShLangMiss:           return VK_SHADER_STAGE_MISS_BIT_KHR;
-		case EShLangCallable:       return VK_SHADER_STAGE_CALLABLE_BIT_KHR;
-		case EShLangTask:           return VK_SHADER_STAGE_TASK_BIT_EXT;
-		case EShLangMesh:           return VK_SHADER_STAGE_MESH_BIT_EXT;
-		default:
-			MIST_ASSERT(false, "Can not convert EShLanguage enum to Vulkan shader stage");
-			return VK_SHADER_STAGE_ALL;
-		}
+	VulkanShaderModule::~VulkanShaderModule() {
+		VulkanContext& context = VulkanContext::GetContext();
+		vkDestroyShaderModule(context.GetDevice(), module, context.GetAllocationCallbacks());
 	}
 
-	VulkanShader::VulkanShader(const std::string& path) {
+	VulkanShader::VulkanShader(const std::string& path) : sourcePath(path) {
 		shaderName = std::filesystem::path(path).stem().string();
-		std::string src = Utils::ReadFile(path);
-		std::unordered_map<EShLanguage, std::string> shaderSources = PreProcess(src);
 
-		glslang::InitializeProcess();
-		for (std::pair<EShLanguage, std::string> src : shaderSources) {
-			std::vector<uint32_t> spirv = ConvertGLSLToSPIRV(src.second, src.first);
-			Compile(spirv, src.first);
+		ShaderBinary binary;
+		if (!VulkanShaderCompiler::LoadOrCompile(path, "", binary)) {
+			MIST_ERROR("Failed to compile shader: {0}", path);
+			return;
 		}
-		glslang::FinalizeProcess();
-
-		//VulkanContext& context = VulkanContext::GetContext();
-		//context.pipeline.CreateGraphicsPipeline(this);
+		CreateModules(binary);
 
 		MIST_INFO(std::string("Loaded shader and created graphics pipeline for: ") + shaderName);
 	}
@@ -161,281 +51,175 @@ namespace mist {
 		shaderSources[EShLangVertex] = vertexSrc;
 		shaderSources[EShLangFragment] = fragmentSrc;
 
-		glslang::InitializeProcess();
-		for (std::pair<EShLanguage, std::string> src : shaderSources) {
-			std::vector<uint32_t> spirv = ConvertGLSLToSPIRV(src.second, src.first);
-			Compile(spirv, src.first);
+		// Inline sources have no file to key a cache entry on so they always compile
+		ShaderBinary binary;
+		if (!VulkanShaderCompiler::Compile(shaderSources, "", binary)) {
+			MIST_ERROR("Failed to compile shader: {0}", name);
+			return;
 		}
-		glslang::FinalizeProcess();
-
-		//VulkanContext& context = VulkanContext::GetContext();
-		//context.pipeline.CreateGraphicsPipeline(this);
+		CreateModules(binary);
 
 		MIST_INFO(std::string("Loaded shader and created graphics pipeline for: ") + name);
 	}
 
-	VulkanShader::~VulkanShader() {
-		Clear();
-	}
-
-	void VulkanShader::Clear() {
-		VulkanContext& context = VulkanContext::GetContext();
-		for (std::pair<std::string, InputShaderResource> pair : shaderInputs) {
-			vkDestroyShaderModule(context.GetDevice(), pair.second.shaderModule, context.GetAllocationCallbacks());
-		}
-
-		for (std::pair<std::string, UBOShaderResource> pair : shaderUbos) {
-			vkDestroyShaderModule(context.GetDevice(), pair.second.shaderModule, context.GetAllocationCallbacks());
-		}
-		
-		for (std::pair<std::string, SampledImageShaderResources> pair : shaderSampledImages) {
-			vkDestroyShaderModule(context.GetDevice(), pair.second.shaderModule, context.GetAllocationCallbacks());
-		}
+	VulkanShader::VulkanShader(const std::string& path, ShaderBinary& binary) : sourcePath(path) {
+		shaderName = std::filesystem::path(path).stem().string();
+		CreateModules(binary);
 	}
 
-	std::unordered_map<EShLanguage, std::string> VulkanShader::PreProcess(const std::string& src) {
-		std::unordered_map<EShLanguage, std::string> shaderSources;
-
-		const char* typeToken = "#type";
-		size_t typeTokenLength = strlen(typeToken);
-		size_t pos = src.find(typeToken, 0);
-		while (pos != std::string::npos) {
-			size_t eol = src.find_first_of("\r\n", pos);
-			MIST_ASSERT(eol != std::string::npos, "Syntax Error.");
+	VulkanShader::VulkanShader(const VulkanShader& base, const ShaderVariantKey key) : sourcePath(base.sourcePath), variantKey(key) {
+		shaderName = std::format("{0}#{1:x}", base.shaderName, key);
 
-			size_t begin = pos + typeTokenLength + 1;
-			std::string type = src.substr(begin, eol - begin);
-
-			size_t nextLinePos = src.find_first_not_of("\r\n", eol);
-			pos = src.find(typeToken, nextLinePos);
-			shaderSources[ShaderTypeFromString(type)] = src.substr(nextLinePos, pos - (nextLinePos == std::string::npos ? src.size() - 1 : nextLinePos));
+		const ShaderVariantKey defineKey = key & ~base.specializationMask;
+		if (defineKey == 0) {
+			// Only specialization constants change so the base's modules and reflection are reused as they are
+			keywords = base.keywords;
+			stageModules = base.stageModules;
+			shaderInputs = base.shaderInputs;
+			shaderUbos = base.shaderUbos;
+			shaderPushConstants = base.shaderPushConstants;
+			shaderSampledImages = base.shaderSampledImages;
+			ApplyKeywords(base.shaderSpecializationConstants);
+			return;
 		}
 
-		return shaderSources;
-	}
-
-	std::vector<uint32_t> VulkanShader::ConvertGLSLToSPIRV(const std::string& src, EShLanguage stage) {
-		const char* shaderStrings[1];
-		shaderStrings[0] = src.c_str();
-
-		glslang::TShader shader(stage);
-		shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 130);
-		shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_3);
-		shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_3);
-
-		shader.setStrings(shaderStrings, 1);
-
-		TBuiltInResource resources = GetDefaultResources();
-		EShMessages messages = EShMsgDefault;
-
-		if (!shader.parse(&resources, 100, false, messages)) {
-			MIST_ASSERT(false, std::string("Failed to parse GLSL: ") + shader.getInfoLog());
-			return {};
+		// Variants with the same defines share a cache file, so differing only in specialization bits never recompiles
+		for (size_t i = 0; i < base.keywords.size(); ++i) {
+			if (defineKey & (1ull << i))
+				defines += "#define " + base.keywords[i] + " 1\n";
 		}
 
-		glslang::TProgram program;
-		program.addShader(&shader);
-
-		if (!program.link(messages)) {
-			MIST_ASSERT(false, std::string("Failed to parse GLSL: ") + shader.getInfoLog());
-			return {};
+		ShaderBinary binary;
+		if (!VulkanShaderCompiler::LoadOrCompile(sourcePath, defines, binary)) {
+			MIST_ERROR("Failed to compile variant: {0}", shaderName);
+			return;
 		}
+		CreateModules(binary);
+	}
 
-		std::vector<uint32_t> spirv;
-		glslang::GlslangToSpv(*program.getIntermediate(stage), spirv);
-
-		return spirv;
+	Ref<Shader> VulkanShader::CreateVariant(const ShaderVariantKey key) const {
+		return CreateRef<VulkanShader>(*this, key);
 	}
 
-	uint32_t VulkanShader::CalculateSize(const spirv_cross::Compiler& compiler, const spirv_cross::SPIRType& type) {
-		uint32_t size = 0;
-
-		switch (type.basetype) {
-		case spirv_cross::SPIRType::Boolean:
-			size = sizeof(bool);
-			break;
-		case spirv_cross::SPIRType::Char:
-		case spirv_cross::SPIRType::SByte:
-		case spirv_cross::SPIRType::UByte:
-			size = sizeof(char);
-			break;
-		case spirv_cross::SPIRType::UShort:
-		case spirv_cross::SPIRType::Short:
-			size = sizeof(short);
-			break;
-		case spirv_cross::SPIRType::UInt:
-		case spirv_cross::SPIRType::Int:
-			size = sizeof(int);
-			break;
-		case spirv_cross::SPIRType::UInt64:
-		case spirv_cross::SPIRType::Int64:
-			size = sizeof(int64_t);
-			break;
-		case spirv_cross::SPIRType::AtomicCounter:
-			size = sizeof(uint32_t);
-			break;
-		case spirv_cross::SPIRType::Half:
-			size = sizeof(uint16_t);
-		case spirv_cross::SPIRType::Float:
-			size = sizeof(float);
-			break;
-		case spirv_cross::SPIRType::Double:
-			size = sizeof(double);
-			break;
-		case spirv_cross::SPIRType::Struct:
-			for (const auto& member : type.member_types) {
-				const spirv_cross::SPIRType& memberType = compiler.get_type(member);
-				size += CalculateSize(compiler, memberType);
-			}
-			break;
-		default:
-			MIST_ERROR("Unsupported type");
-		}
+	Ref<Shader> VulkanShader::Recompile() const {
+		if (sourcePath.empty())
+			return nullptr;
 
-		if (type.vecsize > 1)
-			size *= type.vecsize;
-		if (type.columns > 1)
-			size *= type.columns;
+		ShaderBinary binary;
+		if (!VulkanShaderCompiler::LoadOrCompile(sourcePath, defines, binary))
+			return nullptr;
 
-		return size;
+		return CreateRef<VulkanShader>(sourcePath, binary);
 	}
 
-	VkFormat VulkanShader::GetDescriptionFormat(const spirv_cross::Compiler& compiler, const spirv_cross::SPIRType type) {
-		if (type.basetype == spirv_cross::SPIRType::Float) {
-			if (type.vecsize == 1) return VK_FORMAT_R32_SFLOAT;
-			if (type.vecsize == 2) return VK_FORMAT_R32G32_SFLOAT;
-			if (type.vecsize == 3) return VK_FORMAT_R32G32B32_SFLOAT;
-			if (type.vecsize == 4) return VK_FORMAT_R32G32B32A32_SFLOAT;
-		}
+	void VulkanShader::ReplaceWith(Shader& reloaded) {
+		VulkanShader& shader = static_cast<VulkanShader&>(reloaded);
+		VulkanContext& context = VulkanContext::GetContext();
 
-		if (type.basetype == spirv_cross::SPIRType::Int) {
-			if (type.vecsize == 1) return VK_FORMAT_R32_SINT;
-			if (type.vecsize == 2) return VK_FORMAT_R32G32_SINT;
-			if (type.vecsize == 3) return VK_FORMAT_R32G32B32_SINT;
-			if (type.vecsize == 4) return VK_FORMAT_R32G32B32A32_SINT;
-		}
+		// Pipelines from the old code may still be in flight, reloads are rare enough to just wait them out
+		vkDeviceWaitIdle(context.GetDevice());
+		for (std::pair<const uint8_t, Ref<VulkanRenderData>>& data : context.GetRenderDatas())
+			data.second->pipeline.RemovePipeline(shaderName);
+
+		// Only the code and reflection move over, the name and variant identity stay with this shader
+		keywords = std::move(shader.keywords);
+		stageModules = std::move(shader.stageModules);
+		shaderInputs = std::move(shader.shaderInputs);
+		shaderUbos = std::move(shader.shaderUbos);
+		shaderPushConstants = std::move(shader.shaderPushConstants);
+		shaderSampledImages = std::move(shader.shaderSampledImages);
+		ApplyKeywords(shader.shaderSpecializationConstants);
+		PruneSharedModules();
+	}
 
-		if (type.basetype == spirv_cross::SPIRType::UInt) {
-			if (type.vecsize == 1) return VK_FORMAT_R32_UINT;
-			if (type.vecsize == 2) return VK_FORMAT_R32G32_UINT;
-			if (type.vecsize == 3) return VK_FORMAT_R32G32B32_UINT;
-			if (type.vecsize == 4) return VK_FORMAT_R32G32B32A32_UINT;
-		}
+	std::vector<Ref<Shader>> VulkanShader::CreateBatch(const std::vector<std::string>& paths, ThreadPool& threadPool) {
+		std::vector<std::optional<ShaderBinary>> binaries = VulkanShaderCompiler::LoadOrCompileBatch(paths, "", threadPool);
 
-		if (type.basetype == spirv_cross::SPIRType::Boolean) return VK_FORMAT_R32_SINT;
+		// Modules are created back on the calling thread, compiling is the part worth spreading out
+		std::vector<Ref<Shader>> shaders(paths.size());
+		for (size_t i = 0; i < paths.size(); ++i) {
+			if (!binaries[i].has_value()) {
+				MIST_ERROR("Failed to compile shader: {0}", paths[i]);
+				continue;
+			}
 
-		if (type.basetype == spirv_cross::SPIRType::Struct) {
-			if (type.member_types.empty()) return VK_FORMAT_UNDEFINED;
-			return GetDescriptionFormat(compiler, compiler.get_type(type.member_types[0]));
+			shaders[i] = CreateRef<VulkanShader>(paths[i], *binaries[i]);
 		}
 
-		MIST_WARN("Couldnt get description format");
-		return VK_FORMAT_R32_SFLOAT;
+		MIST_INFO("Loaded {0} shaders", paths.size());
+		return shaders;
 	}
 
-	VkShaderModule VulkanShader::CreateShaderModule(const std::vector<uint32_t>& spirv) {
-		VkShaderModuleCreateInfo info{};
-		info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		info.codeSize = spirv.size() * sizeof(uint32_t);
-		info.pCode = spirv.data();
+	VulkanShader::~VulkanShader() {
+		Clear();
+	}
 
-		VulkanContext& context = VulkanContext::GetContext();
-		VkShaderModule module;
-		CheckVkResult(vkCreateShaderModule(context.GetDevice(), &info, context.GetAllocationCallbacks(), &module));
-		return module;
+	void VulkanShader::Clear() {
+		// Modules are released with their last variant
+		stageModules.clear();
+		PruneSharedModules();
 	}
 
-	void VulkanShader::Compile(const std::vector<uint32_t>& spirv, EShLanguage stage) {
-		spirv_cross::CompilerGLSL compiler(spirv);
-		spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+	void VulkanShader::CreateModules(ShaderBinary& binary) {
+		for (const ShaderStageBinary& stage : binary.stages) {
+			const uint64_t hash = VulkanShaderCompiler::HashSpirv(stage.spirv);
+			std::lock_guard<std::mutex> lock(sharedModulesMutex);
+			Ref<VulkanShaderModule> module = sharedModules[hash].lock();
+			if (module == nullptr) {
+				module = CreateRef<VulkanShaderModule>(stage.spirv);
+				sharedModules[hash] = module;
+			}
 
-		uint32_t inputStride = 0;
-		for (const spirv_cross::Resource& res : resources.stage_inputs) {
-			inputStride += CalculateSize(compiler, compiler.get_type(res.type_id));
+			stageModules.push_back({ stage.stage, module });
 		}
 
-		for (const spirv_cross::Resource& inputs : resources.stage_inputs) {
-			InputShaderResource res;
-			res.binding = compiler.get_decoration(inputs.id, spv::DecorationBinding);
-			res.location = compiler.get_decoration(inputs.id, spv::DecorationLocation);
-			res.format = GetDescriptionFormat(compiler, compiler.get_type(inputs.type_id));
-			res.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-			res.flags = EShLanguageToVkStageFlags(stage);
-			res.shaderModule = CreateShaderModule(spirv);
-			
-			uint32_t offset = 0;
-			for (const spirv_cross::Resource& i : resources.stage_inputs) {
-				if (compiler.get_decoration(i.id, spv::DecorationLocation) < res.location)
-					offset += CalculateSize(compiler, compiler.get_type(i.type_id));
-			}
+		shaderInputs = std::move(binary.inputs);
+		shaderUbos = std::move(binary.ubos);
+		shaderPushConstants = std::move(binary.pushConstants);
+		shaderSampledImages = std::move(binary.sampledImages);
+		keywords = std::move(binary.keywords);
+		ApplyKeywords(binary.specializationConstants);
+	}
 
-			res.offset = offset;
-			res.stride = inputStride;
+	void VulkanShader::ApplyKeywords(const std::unordered_map<std::string, SpecializationConstantResource>& constants) {
+		shaderSpecializationConstants = constants;
+		variantMask = keywords.size() >= 64 ? ~0ull : (1ull << keywords.size()) - 1;
+		specializationMask = 0;
+		specializationValues.clear();
 
-			shaderInputs[inputs.name] = res;
-		}
+		for (size_t i = 0; i < keywords.size(); ++i) {
+			auto constant = constants.find(keywords[i]);
+			if (constant == constants.end())
+				continue;
 
-		for (const spirv_cross::Resource& ubo : resources.uniform_buffers) {
-			UBOShaderResource res;
-			res.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			res.binding = compiler.get_decoration(ubo.id, spv::DecorationBinding);
-			res.offset = compiler.get_decoration(ubo.id, spv::DecorationOffset);
-			res.count = 1;
-			res.flags = EShLanguageToVkStageFlags(stage);
-			res.shaderModule = CreateShaderModule(spirv);
-
-			uint32_t size = 0;
-			const spirv_cross::SPIRType& type = compiler.get_type(ubo.base_type_id);
-			for (uint32_t i = 0; i < type.member_types.size(); ++i) {
-				const spirv_cross::SPIRType& memberType = compiler.get_type(type.member_types[i]);
-				uint32_t memberSize = CalculateSize(compiler, memberType);
-				uint32_t offset = (uint32_t)compiler.get_member_decoration(ubo.base_type_id, i, spv::DecorationOffset);
-				size = std::max(size, offset + memberSize);
-			}
-			res.size = size;
-			
-			shaderUbos[ubo.name] = res;
-		}
-
-		for (const spirv_cross::Resource& pushConstant : resources.push_constant_buffers) {
-			for (spirv_cross::BufferRange& bufferRange : compiler.get_active_buffer_ranges(pushConstant.id)) {
-				std::string name = compiler.get_member_name(pushConstant.base_type_id, bufferRange.index);
-				if (shaderPushConstants.contains(name)) {
-					shaderPushConstants[name].flags |=  EShLanguageToVkStageFlags(stage);
-					continue;
-				}
-
-				PushConstantResource res;
-				res.offset = bufferRange.offset;
-				res.size = bufferRange.range;
-				res.flags = EShLanguageToVkStageFlags(stage);
-				shaderPushConstants[name] = res;
-			}
-		}
-		
-		for (const spirv_cross::Resource& sampled : resources.sampled_images) {
-			SampledImageShaderResources res;
-			res.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-			res.binding = compiler.get_decoration(sampled.id, spv::DecorationBinding);
-			res.count = 1;
-			res.flags = EShLanguageToVkStageFlags(stage);
-			res.shaderModule = CreateShaderModule(spirv);
-		
-			shaderSampledImages[sampled.name] = res;
+			specializationMask |= 1ull << i;
+			specializationValues.push_back({ constant->second.constantID, (variantKey & (1ull << i)) ? VK_TRUE : VK_FALSE });
 		}
 	}
 
-	void VulkanShader::Bind(const uint8_t renderDataId) const {
+	bool VulkanShader::Prepare(const uint8_t renderDataId) const {
 		VulkanContext& context = VulkanContext::GetContext();
 		Ref<VulkanRenderData> data = context.GetRenderData(renderDataId);
-		if (!data->pipeline.HasPipeline(shaderName))
+		if (data->pipeline.HasPipeline(shaderName))
+			return true;
+
+		if (!data->pipeline.IsPipelinePending(shaderName))
 			data->CreateGraphicsPipeline(this);
+		return false;
+	}
+
+	bool VulkanShader::Bind(const uint8_t renderDataId) const {
+		if (!Prepare(renderDataId))
+			return false;
 
+		VulkanContext& context = VulkanContext::GetContext();
+		Ref<VulkanRenderData> data = context.GetRenderData(renderDataId);
 		vkCmdBindPipeline(
 			context.GetCurrentFrameCommandBuffer(),
 			VK_PIPELINE_BIND_POINT_GRAPHICS, 	// TODO: make a way to detect correct bind point, will probably just have to hold a reference if cant defer
 			data->pipeline.GetGraphicsPipeline(shaderName)
 		);
+		return true;
 	}
 
 	void VulkanShader::Unbind(const uint8_t renderDataId) const {}
@@ -1,49 +1,41 @@
 #pragma once
 #include <vulkan/vulkan.h>
-#include <glslang/Public/ShaderLang.h>
-#include <spirv_cross/spirv_cross.hpp>
 #include "renderer/Shader.hpp"
+#include "renderer/vulkan/VulkanShaderCompiler.hpp"
 
 namespace mist {
-	struct InputShaderResource {
-		uint32_t binding;
-		uint32_t location;
-		uint32_t offset;
-		uint32_t stride;
-		VkFormat format;
-		VkVertexInputRate inputRate;
-		VkShaderStageFlags flags;
-		VkShaderModule shaderModule;
-	};
+	// Shared by every variant whose stage compiles to the same SPIR-V
+	class VulkanShaderModule {
+	public:
+		VulkanShaderModule(const std::vector<uint32_t>& spirv);
+		~VulkanShaderModule();
 
-	struct UBOShaderResource {
-        VkDescriptorType type;
-        uint32_t binding;
-        uint32_t offset;
-        uint32_t size;
-        uint32_t count;
-        VkShaderStageFlags flags;
-        VkShaderModule shaderModule;
-    };
+		VulkanShaderModule(const VulkanShaderModule&) = delete;
+		VulkanShaderModule& operator=(const VulkanShaderModule&) = delete;
+
+		inline const VkShaderModule GetModule() const { return module; }
+	private:
+		VkShaderModule module = VK_NULL_HANDLE;
+	};
 
-	struct PushConstantResource {
-		uint32_t offset;
-		uint32_t size;
-		VkShaderStageFlags flags;
+	struct ShaderStageModule {
+		VkShaderStageFlagBits stage;
+		Ref<VulkanShaderModule> module;
 	};
 
-	struct SampledImageShaderResources {
-		VkDescriptorType type;
-		uint32_t binding;
-		uint32_t count;
-		VkShaderStageFlags flags;
-        VkShaderModule shaderModule;
+	struct SpecializationValue {
+		uint32_t constantID;
+		VkBool32 value;
 	};
 
 	class VulkanShader : public Shader {
 	public:
 		VulkanShader(const std::string& path);
 		VulkanShader(const std::string& name, const std::string& vertexSrc, const std::string& fragmentSrc);
+		VulkanShader(const std::string& path, ShaderBinary& binary);
+		// Keywords backed by a specialization constant of the same name reuse the base's SPIR-V,
+		// the rest are compiled in as defines
+		VulkanShader(const VulkanShader& base, const ShaderVariantKey key);
 		virtual ~VulkanShader();
 
 		VulkanShader(const VulkanShader& other) = delete;
@@ -51,29 +43,49 @@ namespace mist {
 
 		virtual void Clear() override;
 
-		virtual void Bind(const uint8_t renderDataId) const override;
+		virtual bool Prepare(const uint8_t renderDataId) const override;
+		virtual bool Bind(const uint8_t renderDataId) const override;
 		virtual void Unbind(const uint8_t renderDataId) const override;
 
 		virtual void SetUniformData(const uint8_t renderDataId, const std::string& name, const int size, const void* data) override;
 
 		virtual const std::string& GetName() const override { return shaderName; }
+		virtual const std::string& GetSourcePath() const override { return sourcePath; }
+
+		virtual ShaderVariantKey GetVariantMask() const override { return variantMask; }
+		virtual ShaderVariantKey GetVariantKey() const override { return variantKey; }
+		virtual Ref<Shader> CreateVariant(const ShaderVariantKey key) const override;
+
+		virtual Ref<Shader> Recompile() const override;
+		virtual void ReplaceWith(Shader& reloaded) override;
+
+		static std::vector<Ref<Shader>> CreateBatch(const std::vector<std::string>& paths, ThreadPool& threadPool);
 		
+		// One module per stage, shared by every pipeline built from this shader
+		const std::vector<ShaderStageModule>& GetStageModules() const { return stageModules; }
 		const std::unordered_map<std::string, InputShaderResource>& GetInputResources() const { return shaderInputs; }
 		const std::unordered_map<std::string, UBOShaderResource>& GetUboResources() const { return shaderUbos; }
 		const std::unordered_map<std::string, PushConstantResource>& GetPushConstantResources() const { return shaderPushConstants; }
 		const std::unordered_map<std::string, SampledImageShaderResources>& GetSampledImageResources() const { return shaderSampledImages; }
+		// One value per keyword backed by a specialization constant, applied to every stage at pipeline creation
+		const std::vector<SpecializationValue>& GetSpecializationValues() const { return specializationValues; }
 	private:
-		std::vector<uint32_t> ConvertGLSLToSPIRV(const std::string& src, EShLanguage stage);
-		std::unordered_map<EShLanguage, std::string> PreProcess(const std::string& src);
-		uint32_t CalculateSize(const spirv_cross::Compiler& compiler, const spirv_cross::SPIRType& type);
-		VkFormat GetDescriptionFormat(const spirv_cross::Compiler& compiler, const spirv_cross::SPIRType type);
-		VkShaderModule CreateShaderModule(const std::vector<uint32_t>& spirv);
-		void Compile(const std::vector<uint32_t>& spirv, EShLanguage stage);
+		void CreateModules(ShaderBinary& binary);
+		void ApplyKeywords(const std::unordered_map<std::string, SpecializationConstantResource>& constants);
 
 		std::string shaderName;
+		std::string sourcePath;	// Empty for inline sources, which can not have variants or reload
+		std::string defines;
+		std::vector<std::string> keywords;
+		ShaderVariantKey variantMask = 0;
+		ShaderVariantKey specializationMask = 0;
+		ShaderVariantKey variantKey = 0;
+		std::vector<SpecializationValue> specializationValues;
+		std::vector<ShaderStageModule> stageModules;
 		std::unordered_map<std::string, InputShaderResource> shaderInputs;
 		std::unordered_map<std::string, UBOShaderResource> shaderUbos;
 		std::unordered_map<std::string, PushConstantResource> shaderPushConstants;
 		std::unordered_map<std::string, SampledImageShaderResources> shaderSampledImages;
+		std::unordered_map<std::string, SpecializationConstantResource> shaderSpecializationConstants;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,782 @@
+#include "VulkanShaderCompiler.hpp"
+#include <glslang/SPIRV/GlslangToSpv.h>
+#include <spirv_cross/spirv_glsl.hpp>
+#include <filesystem>
+#include <format>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <type_traits>
+#include "Debug.hpp"
+#include "PlatformUtils.hpp"
+
+namespace mist {
+	// Bump whenever the reflected data, its layout on disk or the glslang targets change
+	static constexpr uint32_t SHADER_CACHE_VERSION = 2;
+	static constexpr uint32_t SHADER_CACHE_MAGIC = 0x4353534D;	// MSSC
+	static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+	static uint64_t HashBytes(uint64_t hash, const void* data, const size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	// Length prefixed so neighbouring strings can not shift bytes between each other and collide
+	static uint64_t HashString(uint64_t hash, const std::string& str) {
+		const uint64_t length = str.size();
+		hash = HashBytes(hash, &length, sizeof(length));
+		return HashBytes(hash, str.data(), str.size());
+	}
+
+	// glslang keeps per thread state, so every thread that compiles initializes the process once and
+	// releases it when the thread exits
+	struct GlslangThreadScope {
+		GlslangThreadScope() { glslang::InitializeProcess(); }
+		~GlslangThreadScope() { glslang::FinalizeProcess(); }
+	};
+
+	static void InitializeGlslangThread() {
+		thread_local GlslangThreadScope scope;
+	}
+
+	class CacheWriter {
+	public:
+		template<typename T>
+		void Write(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be written to the shader cache");
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			data.insert(data.end(), bytes, bytes + sizeof(T));
+		}
+
+		void WriteString(const std::string& str) {
+			Write(static_cast<uint32_t>(str.size()));
+			data.insert(data.end(), str.begin(), str.end());
+		}
+
+		template<typename T>
+		void WriteMap(const std::unordered_map<std::string, T>& map) {
+			Write(static_cast<uint32_t>(map.size()));
+			for (const std::pair<const std::string, T>& pair : map) {
+				WriteString(pair.first);
+				Write(pair.second);
+			}
+		}
+
+		std::vector<uint8_t> data;
+	};
+
+	// Every read is bounds checked so a truncated or corrupt file just counts as a miss
+	class CacheReader {
+	public:
+		CacheReader(const std::vector<uint8_t>& data) : data(data) {}
+
+		template<typename T>
+		bool Read(T& value) {
+			static_assert(std::is_trivially_copyable_v<T>, "Only plain data can be read from the shader cache");
+			if (data.size() - cursor < sizeof(T))
+				return false;
+
+			memcpy(&value, data.data() + cursor, sizeof(T));
+			cursor += sizeof(T);
+			return true;
+		}
+
+		bool ReadString(std::string& str) {
+			uint32_t size;
+			if (!Read(size) || data.size() - cursor < size)
+				return false;
+
+			str.assign(reinterpret_cast<const char*>(data.data() + cursor), size);
+			cursor += size;
+			return true;
+		}
+
+		template<typename T>
+		bool ReadMap(std::unordered_map<std::string, T>& map) {
+			uint32_t count;
+			if (!Read(count))
+				return false;
+
+			for (uint32_t i = 0; i < count; ++i) {
+				std::string name;
+				T value;
+				if (!ReadString(name) || !Read(value))
+					return false;
+				map[name] = value;
+			}
+			return true;
+		}
+
+		bool ReadWords(std::vector<uint32_t>& words) {
+			uint32_t count;
+			if (!Read(count) || (data.size() - cursor) / sizeof(uint32_t) < count)
+				return false;
+
+			words.resize(count);
+			memcpy(words.data(), data.data() + cursor, count * sizeof(uint32_t));
+			cursor += count * sizeof(uint32_t);
+			return true;
+		}
+
+		inline bool AtEnd() const { return cursor == data.size(); }
+	private:
+		const std::vector<uint8_t>& data;
+		size_t cursor = 0;
+	};
+
+	static TBuiltInResource GetDefaultResources() {
+		TBuiltInResource resources = {};
+		resources.maxLights = 32;
+		resources.maxClipPlanes = 6;
+		resources.maxTextureUnits = 32;
+		resources.maxTextureCoords = 32;
+		resources.maxVertexAttribs = 64;
+		resources.maxVertexUniformComponents = 4096;
+		resources.maxVaryingFloats = 64;
+		resources.maxVertexTextureImageUnits = 32;
+		resources.maxCombinedTextureImageUnits = 80;
+		resources.maxTextureImageUnits = 32;
+		resources.maxFragmentUniformComponents = 4096;
+		resources.maxDrawBuffers = 32;
+		resources.maxVertexUniformVectors = 128;
+		resources.maxVaryingVectors = 8;
+		resources.maxFragmentUniformVectors = 16;
+		resources.maxVertexOutputVectors = 16;
+		resources.maxFragmentInputVectors = 15;
+		resources.minProgramTexelOffset = -8;
+		resources.maxProgramTexelOffset = 7;
+		resources.maxClipDistances = 8;
+		resources.maxComputeWorkGroupCountX = 65535;
+		resources.maxComputeWorkGroupCountY = 65535;
+		resources.maxComputeWorkGroupCountZ = 65535;
+		resources.maxComputeWorkGroupSizeX = 1024;
+		resources.maxComputeWorkGroupSizeY = 1024;
+		resources.maxComputeWorkGroupSizeZ = 64;
+		resources.maxComputeUniformComponents = 1024;
+		resources.maxComputeTextureImageUnits = 16;
+		resources.maxComputeImageUniforms = 8;
+		resources.maxComputeAtomicCounters = 8;
+		resources.maxComputeAtomicCounterBuffers = 1;
+		resources.maxVaryingComponents = 60;
+		resources.maxVertexOutputComponents = 64;
+		resources.maxGeometryInputComponents = 64;
+		resources.maxGeometryOutputComponents = 128;
+		resources.maxFragmentInputComponents = 128;
+		resources.maxImageUnits = 8;
+		resources.maxCombinedImageUnitsAndFragmentOutputs = 8;
+		resources.maxCombinedShaderOutputResources = 8;
+		resources.maxImageSamples = 0;
+		resources.maxVertexImageUniforms = 0;
+		resources.maxTessControlImageUniforms = 0;
+		resources.maxTessEvaluationImageUniforms = 0;
+		resources.maxGeometryImageUniforms = 0;
+		resources.maxFragmentImageUniforms = 8;
+		resources.maxCombinedImageUniforms = 8;
+		resources.maxGeometryTextureImageUnits = 16;
+		resources.maxGeometryOutputVertices = 256;
+		resources.maxGeometryTotalOutputComponents = 1024;
+		resources.maxGeometryUniformComponents = 1024;
+		resources.maxGeometryVaryingComponents = 64;
+		resources.maxTessControlInputComponents = 128;
+		resources.maxTessControlOutputComponents = 128;
+		resources.maxTessControlTextureImageUnits = 16;
+		resources.maxTessControlUniformComponents = 1024;
+		resources.maxTessControlTotalOutputComponents = 4096;
+		resources.maxTessEvaluationInputComponents = 128;
+		resources.maxTessEvaluationOutputComponents = 128;
+		resources.maxTessEvaluationTextureImageUnits = 16;
+		resources.maxTessEvaluationUniformComponents = 1024;
+		resources.maxTessPatchComponents = 120;
+		resources.maxPatchVertices = 32;
+		resources.maxTessGenLevel = 64;
+		resources.maxViewports = 16;
+		resources.maxVertexAtomicCounters = 0;
+		resources.maxTessControlAtomicCounters = 0;
+		resources.maxTessEvaluationAtomicCounters = 0;
+		resources.maxGeometryAtomicCounters = 0;
+		resources.maxFragmentAtomicCounters = 8;
+		resources.maxCombinedAtomicCounters = 8;
+		resources.maxAtomicCounterBindings = 1;
+		resources.maxVertexAtomicCounterBuffers = 0;
+		resources.maxTessControlAtomicCounterBuffers = 0;
+		resources.maxTessEvaluationAtomicCounterBuffers = 0;
+		resources.maxGeometryAtomicCounterBuffers = 0;
+		resources.maxFragmentAtomicCounterBuffers = 1;
+		resources.maxCombinedAtomicCounterBuffers = 1;
+		resources.maxAtomicCounterBufferSize = 16384;
+		resources.maxTransformFeedbackBuffers = 4;
+		resources.maxTransformFeedbackInterleavedComponents = 64;
+		resources.maxCullDistances = 8;
+		resources.maxCombinedClipAndCullDistances = 8;
+		resources.maxSamples = 4;
+		resources.limits.nonInductiveForLoops = 1;
+		resources.limits.whileLoops = 1;
+		resources.limits.doWhileLoops = 1;
+		resources.limits.generalUniformIndexing = 1;
+		resources.limits.generalAttributeMatrixVectorIndexing = 1;
+		resources.limits.generalVaryingIndexing = 1;
+		resources.limits.generalSamplerIndexing = 1;
+		resources.limits.generalVariableIndexing = 1;
+		resources.limits.generalConstantMatrixVectorIndexing = 1;
+
+		return resources;
+	}
+
+	static EShLanguage ShaderTypeFromString(const std::string& type) {
+		if (type == "vertex" || type == "vert") return EShLangVertex;
+		if (type == "fragment" || type == "frag" || type == "pixel") return EShLangFragment;
+		if (type == "compute" || type == "comp") return EShLangCompute;
+		if (type == "geometry" || type == "geo") return EShLangGeometry;
+
+		MIST_ASSERT(false, "Unknown shader type, defaulting to vertex");
+		return EShLangVertex;
+	}
+
+	static VkShaderStageFlagBits EShLanguageToVkStageFlags(EShLanguage stage) {
+		switch (stage) {
+		case EShLangVertex:         return VK_SHADER_STAGE_VERTEX_BIT;
+		case EShLangTessControl:    return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case EShLangTessEvaluation: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case EShLangGeometry:       return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case EShLangFragment:       return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case EShLangCompute:        return VK_SHADER_STAGE_COMPUTE_BIT;
+		case EShLangRayGen:         return VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+		case EShLangIntersect:      return VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
+		case EShLangAnyHit:         return VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+		case EShLangClosestHit:     return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+		case EShLangMiss:           return VK_SHADER_STAGE_MISS_BIT_KHR;
+		case EShLangCallable:       return VK_SHADER_STAGE_CALLABLE_BIT_KHR;
+		case EShLangTask:           return VK_SHADER_STAGE_TASK_BIT_EXT;
+		case EShLangMesh:           return VK_SHADER_STAGE_MESH_BIT_EXT;
+		default:
+			MIST_ASSERT(false, "Can not convert EShLanguage enum to Vulkan shader stage");
+			return VK_SHADER_STAGE_ALL;
+		}
+	}
+
+	bool VulkanShaderCompiler::LoadOrCompile(const std::string& path, const std::string& defines, ShaderBinary& binary) {
+		const std::string src = Utils::ReadFile(path);
+		if (src.empty())
+			return false;
+
+		const uint64_t hash = HashSource(src, defines);
+		const std::string cachePath = GetCachePath(path, defines);
+		if (!ReadCache(cachePath, hash, binary)) {
+			binary = ShaderBinary();
+			if (!Compile(PreProcess(src), defines, binary))
+				return false;
+
+			binary.hash = hash;
+			WriteCache(cachePath, binary);
+		}
+
+		binary.keywords = ParseKeywords(src);
+		return true;
+	}
+
+	std::vector<std::optional<ShaderBinary>> VulkanShaderCompiler::LoadOrCompileBatch(const std::vector<std::string>& paths, const std::string& defines, ThreadPool& threadPool) {
+		struct PendingShader {
+			std::string cachePath;
+			uint64_t hash = 0;
+			bool read = false;
+			bool cached = false;
+			ShaderBinary binary;
+			std::unordered_map<EShLanguage, std::string> sources;
+			std::vector<std::string> keywords;
+		};
+
+		// Reading and cache lookups go wide first, with a warm cache this is the whole load
+		std::vector<std::future<PendingShader>> reads;
+		reads.reserve(paths.size());
+		for (const std::string& path : paths) {
+			reads.push_back(threadPool.Submit([&path, &defines]() {
+				PendingShader pending;
+				const std::string src = Utils::ReadFile(path);
+				if (src.empty())
+					return pending;
+
+				pending.read = true;
+				pending.keywords = ParseKeywords(src);
+				pending.hash = HashSource(src, defines);
+				pending.cachePath = GetCachePath(path, defines);
+				pending.cached = ReadCache(pending.cachePath, pending.hash, pending.binary);
+				if (!pending.cached)
+					pending.sources = PreProcess(src);
+				return pending;
+			}));
+		}
+
+		std::vector<PendingShader> pendings;
+		pendings.reserve(paths.size());
+		for (std::future<PendingShader>& read : reads)
+			pendings.push_back(read.get());
+
+		// Then every stage of every missed shader compiles as its own task
+		std::vector<std::vector<std::future<std::optional<ShaderBinary>>>> stageResults(pendings.size());
+		for (size_t i = 0; i < pendings.size(); ++i) {
+			for (const std::pair<const EShLanguage, std::string>& src : pendings[i].sources) {
+				stageResults[i].push_back(threadPool.Submit([&src, &defines]() -> std::optional<ShaderBinary> {
+					ShaderBinary stage;
+					if (!CompileStage(src.second, defines, src.first, stage))
+						return std::nullopt;
+					return stage;
+				}));
+			}
+		}
+
+		std::vector<std::optional<ShaderBinary>> results(pendings.size());
+		for (size_t i = 0; i < pendings.size(); ++i) {
+			PendingShader& pending = pendings[i];
+			if (pending.cached) {
+				pending.binary.keywords = std::move(pending.keywords);
+				results[i] = std::move(pending.binary);
+				continue;
+			}
+
+			// Every future is drained even after a failure so no task outlives the sources it points at
+			bool compiled = pending.read;
+			ShaderBinary binary;
+			for (std::future<std::optional<ShaderBinary>>& stageResult : stageResults[i]) {
+				std::optional<ShaderBinary> stage = stageResult.get();
+				if (!stage.has_value()) {
+					compiled = false;
+					continue;
+				}
+				Merge(binary, *stage);
+			}
+
+			if (!compiled)
+				continue;
+
+			binary.hash = pending.hash;
+			WriteCache(pending.cachePath, binary);
+			binary.keywords = std::move(pending.keywords);
+			results[i] = std::move(binary);
+		}
+
+		return results;
+	}
+
+	bool VulkanShaderCompiler::Compile(const std::unordered_map<EShLanguage, std::string>& sources, const std::string& defines, ShaderBinary& binary) {
+		for (const std::pair<const EShLanguage, std::string>& src : sources) {
+			ShaderBinary stage;
+			if (!CompileStage(src.second, defines, src.first, stage))
+				return false;
+			Merge(binary, stage);
+		}
+
+		return true;
+	}
+
+	bool VulkanShaderCompiler::CompileStage(const std::string& src, const std::string& defines, EShLanguage stage, ShaderBinary& binary) {
+		std::vector<uint32_t> spirv = ConvertGLSLToSPIRV(src, defines, stage);
+		if (spirv.empty())
+			return false;
+
+		Reflect(spirv, stage, binary);
+		binary.stages.push_back({ EShLanguageToVkStageFlags(stage), std::move(spirv) });
+		return true;
+	}
+
+	void VulkanShaderCompiler::Merge(ShaderBinary& binary, ShaderBinary& stage) {
+		for (ShaderStageBinary& stageBinary : stage.stages)
+			binary.stages.push_back(std::move(stageBinary));
+
+		for (const std::pair<const std::string, InputShaderResource>& pair : stage.inputs)
+			binary.inputs[pair.first] = pair.second;
+
+		for (const std::pair<const std::string, UBOShaderResource>& pair : stage.ubos)
+			binary.ubos[pair.first] = pair.second;
+
+		for (const std::pair<const std::string, SampledImageShaderResources>& pair : stage.sampledImages)
+			binary.sampledImages[pair.first] = pair.second;
+
+		for (const std::pair<const std::string, PushConstantResource>& pair : stage.pushConstants) {
+			if (binary.pushConstants.contains(pair.first)) {
+				binary.pushConstants[pair.first].flags |= pair.second.flags;
+				continue;
+			}
+			binary.pushConstants[pair.first] = pair.second;
+		}
+
+		for (const std::pair<const std::string, SpecializationConstantResource>& pair : stage.specializationConstants) {
+			if (binary.specializationConstants.contains(pair.first)) {
+				binary.specializationConstants[pair.first].flags |= pair.second.flags;
+				continue;
+			}
+			binary.specializationConstants[pair.first] = pair.second;
+		}
+	}
+
+	uint64_t VulkanShaderCompiler::HashSource(const std::string& source, const std::string& defines) {
+		const glslang::Version version = glslang::GetVersion();
+		const int versionParts[] = { version.major, version.minor, version.patch };
+
+		uint64_t hash = FNV_OFFSET_BASIS;
+		hash = HashBytes(hash, &SHADER_CACHE_VERSION, sizeof(SHADER_CACHE_VERSION));
+		hash = HashBytes(hash, versionParts, sizeof(versionParts));
+		hash = HashString(hash, version.flavor != nullptr ? version.flavor : "");
+		hash = HashString(hash, defines);
+		return HashString(hash, source);
+	}
+
+	uint64_t VulkanShaderCompiler::HashSpirv(const std::vector<uint32_t>& spirv) {
+		return HashBytes(FNV_OFFSET_BASIS, spirv.data(), spirv.size() * sizeof(uint32_t));
+	}
+
+	std::string VulkanShaderCompiler::GetCachePath(const std::string& path, const std::string& defines) {
+		const std::filesystem::path shaderPath(path);
+		std::string fileName = shaderPath.stem().string();
+		if (!defines.empty())
+			fileName += std::format("_{:016x}", HashString(FNV_OFFSET_BASIS, defines));
+
+		return (shaderPath.parent_path() / "cache" / (fileName + ".spvcache")).string();
+	}
+
+	bool VulkanShaderCompiler::ReadCache(const std::string& cachePath, const uint64_t hash, ShaderBinary& binary) {
+		const std::vector<uint8_t> data = Utils::ReadBinaryFile(cachePath);
+		if (data.empty())
+			return false;
+
+		CacheReader reader(data);
+		uint32_t magic, version;
+		uint64_t cachedHash;
+		if (!reader.Read(magic) || !reader.Read(version) || !reader.Read(cachedHash))
+			return false;
+		if (magic != SHADER_CACHE_MAGIC || version != SHADER_CACHE_VERSION || cachedHash != hash)
+			return false;
+
+		ShaderBinary result;
+		result.hash = cachedHash;
+
+		uint32_t stageCount;
+		if (!reader.Read(stageCount))
+			return false;
+
+		result.stages.resize(stageCount);
+		for (ShaderStageBinary& stage : result.stages) {
+			if (!reader.Read(stage.stage) || !reader.ReadWords(stage.spirv))
+				return false;
+		}
+
+		if (!reader.ReadMap(result.inputs) || !reader.ReadMap(result.ubos) || !reader.ReadMap(result.pushConstants) || !reader.ReadMap(result.sampledImages))
+			return false;
+		if (!reader.ReadMap(result.specializationConstants))
+			return false;
+		if (!reader.AtEnd())
+			return false;
+
+		binary = std::move(result);
+		return true;
+	}
+
+	bool VulkanShaderCompiler::WriteCache(const std::string& cachePath, const ShaderBinary& binary) {
+		CacheWriter writer;
+		writer.Write(SHADER_CACHE_MAGIC);
+		writer.Write(SHADER_CACHE_VERSION);
+		writer.Write(binary.hash);
+
+		writer.Write(static_cast<uint32_t>(binary.stages.size()));
+		for (const ShaderStageBinary& stage : binary.stages) {
+			writer.Write(stage.stage);
+			writer.Write(static_cast<uint32_t>(stage.spirv.size()));
+			const uint8_t* words = reinterpret_cast<const uint8_t*>(stage.spirv.data());
+			writer.data.insert(writer.data.end(), words, words + stage.spirv.size() * sizeof(uint32_t));
+		}
+
+		writer.WriteMap(binary.inputs);
+		writer.WriteMap(binary.ubos);
+		writer.WriteMap(binary.pushConstants);
+		writer.WriteMap(binary.sampledImages);
+		writer.WriteMap(binary.specializationConstants);
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), error);
+		if (error) {
+			MIST_WARN("Failed to create shader cache folder for: {0}", cachePath);
+			return false;
+		}
+
+		return Utils::WriteBinaryFile(cachePath, writer.data.data(), writer.data.size());
+	}
+
+	std::unordered_map<EShLanguage, std::string> VulkanShaderCompiler::PreProcess(const std::string& src) {
+		std::unordered_map<EShLanguage, std::string> shaderSources;
+
+		const char* typeToken = "#type";
+		size_t typeTokenLength = strlen(typeToken);
+		size_t pos = src.find(typeToken, 0);
+		while (pos != std::string::npos) {
+			size_t eol = src.find_first_of("\r\n", pos);
+			MIST_ASSERT(eol != std::string::npos, "Syntax Error.");
+
+			size_t begin = pos + typeTokenLength + 1;
+			std::string type = src.substr(begin, eol - begin);
+
+			size_t nextLinePos = src.find_first_not_of("\r\n", eol);
+			pos = src.find(typeToken, nextLinePos);
+			shaderSources[ShaderTypeFromString(type)] = src.substr(nextLinePos, pos - (nextLinePos == std::string::npos ? src.size() - 1 : nextLinePos));
+		}
+
+		return shaderSources;
+	}
+
+	std::vector<std::string> VulkanShaderCompiler::ParseKeywords(const std::string& src) {
+		std::vector<std::string> keywords;
+
+		const char* keywordsToken = "#keywords";
+		const size_t pos = src.find(keywordsToken);
+		if (pos == std::string::npos || pos > src.find("#type"))
+			return keywords;
+
+		const size_t begin = pos + strlen(keywordsToken);
+		const size_t eol = src.find_first_of("\r\n", begin);
+		std::istringstream line(src.substr(begin, eol == std::string::npos ? std::string::npos : eol - begin));
+		std::string keyword;
+		while (line >> keyword)
+			keywords.push_back(keyword);
+
+		MIST_ASSERT(keywords.size() <= 64, "Shaders support up to 64 variant keywords");
+		return keywords;
+	}
+
+	std::vector<uint32_t> VulkanShaderCompiler::ConvertGLSLToSPIRV(const std::string& src, const std::string& defines, EShLanguage stage) {
+		InitializeGlslangThread();
+
+		const char* shaderStrings[1];
+		shaderStrings[0] = src.c_str();
+
+		glslang::TShader shader(stage);
+		shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 130);
+		shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_3);
+		shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_3);
+
+		shader.setStrings(shaderStrings, 1);
+		if (!defines.empty())
+			shader.setPreamble(defines.c_str());
+
+		TBuiltInResource resources = GetDefaultResources();
+		EShMessages messages = EShMsgDefault;
+
+		if (!shader.parse(&resources, 100, false, messages)) {
+			// A typo in a hot reloaded shader lands here on a pool thread, the caller keeps the previous version
+			MIST_ERROR("Failed to parse GLSL: {0}", shader.getInfoLog());
+			return {};
+		}
+
+		glslang::TProgram program;
+		program.addShader(&shader);
+
+		if (!program.link(messages)) {
+			MIST_ERROR("Failed to link GLSL: {0}", program.getInfoLog());
+			return {};
+		}
+
+		std::vector<uint32_t> spirv;
+		glslang::GlslangToSpv(*program.getIntermediate(stage), spirv);
+
+		return spirv;
+	}
+
+	uint32_t VulkanShaderCompiler::CalculateSize(const spirv_cross::Compiler& compiler, const spirv_cross::SPIRType& type) {
+		uint32_t size = 0;
+
+		switch (type.basetype) {
+		case spirv_cross::SPIRType::Boolean:
+			size = sizeof(bool);
+			break;
+		case spirv_cross::SPIRType::Char:
+		case spirv_cross::SPIRType::SByte:
+		case spirv_cross::SPIRType::UByte:
+			size = sizeof(char);
+			break;
+		case spirv_cross::SPIRType::UShort:
+		case spirv_cross::SPIRType::Short:
+			size = sizeof(short);
+			break;
+		case spirv_cross::SPIRType::UInt:
+		case spirv_cross::SPIRType::Int:
+			size = sizeof(int);
+			break;
+		case spirv_cross::SPIRType::UInt64:
+		case spirv_cross::SPIRType::Int64:
+			size = sizeof(int64_t);
+			break;
+		case spirv_cross::SPIRType::AtomicCounter:
+			size = sizeof(uint32_t);
+			break;
+		case spirv_cross::SPIRType::Half:
+			size = sizeof(uint16_t);
+		case spirv_cross::SPIRType::Float:
+			size = sizeof(float);
+			break;
+		case spirv_cross::SPIRType::Double:
+			size = sizeof(double);
+			break;
+		case spirv_cross::SPIRType::Struct:
+			for (const auto& member : type.member_types) {
+				const spirv_cross::SPIRType& memberType = compiler.get_type(member);
+				size += CalculateSize(compiler, memberType);
+			}
+			break;
+		default:
+			MIST_ERROR("Unsupported type");
+		}
+
+		if (type.vecsize > 1)
+			size *= type.vecsize;
+		if (type.columns > 1)
+			size *= type.columns;
+
+		return size;
+	}
+
+	VkFormat VulkanShaderCompiler::GetDescriptionFormat(const spirv_cross::Compiler& compiler, const spirv_cross::SPIRType type) {
+		if (type.basetype == spirv_cross::SPIRType::Float) {
+			if (type.vecsize == 1) return VK_FORMAT_R32_SFLOAT;
+			if (type.vecsize == 2) return VK_FORMAT_R32G32_SFLOAT;
+			if (type.vecsize == 3) return VK_FORMAT_R32G32B32_SFLOAT;
+			if (type.vecsize == 4) return VK_FORMAT_R32G32B32A32_SFLOAT;
+		}
+
+		if (type.basetype == spirv_cross::SPIRType::Int) {
+			if (type.vecsize == 1) return VK_FORMAT_R32_SINT;
+			if (type.vecsize == 2) return VK_FORMAT_R32G32_SINT;
+			if (type.vecsize == 3) return VK_FORMAT_R32G32B32_SINT;
+			if (type.vecsize == 4) return VK_FORMAT_R32G32B32A32_SINT;
+		}
+
+		if (type.basetype == spirv_cross::SPIRType::UInt) {
+			if (type.vecsize == 1) return VK_FORMAT_R32_UINT;
+			if (type.vecsize == 2) return VK_FORMAT_R32G32_UINT;
+			if (type.vecsize == 3) return VK_FORMAT_R32G32B32_UINT;
+			if (type.vecsize == 4) return VK_FORMAT_R32G32B32A32_UINT;
+		}
+
+		if (type.basetype == spirv_cross::SPIRType::Boolean) return VK_FORMAT_R32_SINT;
+
+		if (type.basetype == spirv_cross::SPIRType::Struct) {
+			if (type.member_types.empty()) return VK_FORMAT_UNDEFINED;
+			return GetDescriptionFormat(compiler, compiler.get_type(type.member_types[0]));
+		}
+
+		MIST_WARN("Couldnt get description format");
+		return VK_FORMAT_R32_SFLOAT;
+	}
+
+	void VulkanShaderCompiler::Reflect(const std::vector<uint32_t>& spirv, EShLanguage stage, ShaderBinary& binary) {
+		spirv_cross::CompilerGLSL compiler(spirv);
+		spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+		uint32_t inputStride = 0;
+		for (const spirv_cross::Resource& res : resources.stage_inputs) {
+			inputStride += CalculateSize(compiler, compiler.get_type(res.type_id));
+		}
+
+		for (const spirv_cross::Resource& inputs : resources.stage_inputs) {
+			InputShaderResource res;
+			res.binding = compiler.get_decoration(inputs.id, spv::DecorationBinding);
+			res.location = compiler.get_decoration(inputs.id, spv::DecorationLocation);
+			res.format = GetDescriptionFormat(compiler, compiler.get_type(inputs.type_id));
+			res.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+			res.flags = EShLanguageToVkStageFlags(stage);
+			
+			uint32_t offset = 0;
+			for (const spirv_cross::Resource& i : resources.stage_inputs) {
+				if (compiler.get_decoration(i.id, spv::DecorationLocation) < res.location)
+					offset += CalculateSize(compiler, compiler.get_type(i.type_id));
+			}
+
+			res.offset = offset;
+			res.stride = inputStride;
+
+			binary.inputs[inputs.name] = res;
+		}
+
+		for (const spirv_cross::Resource& ubo : resources.uniform_buffers) {
+			UBOShaderResource res;
+			res.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			res.set = compiler.get_decoration(ubo.id, spv::DecorationDescriptorSet);
+			res.binding = compiler.get_decoration(ubo.id, spv::DecorationBinding);
+			res.offset = compiler.get_decoration(ubo.id, spv::DecorationOffset);
+			res.count = 1;
+			res.flags = EShLanguageToVkStageFlags(stage);
+
+			uint32_t size = 0;
+			const spirv_cross::SPIRType& type = compiler.get_type(ubo.base_type_id);
+			for (uint32_t i = 0; i < type.member_types.size(); ++i) {
+				const spirv_cross::SPIRType& memberType = compiler.get_type(type.member_types[i]);
+				uint32_t memberSize = CalculateSize(compiler, memberType);
+				uint32_t offset = (uint32_t)compiler.get_member_decoration(ubo.base_type_id, i, spv::DecorationOffset);
+				size = std::max(size, offset + memberSize);
+			}
+			res.size = size;
+			
+			binary.ubos[ubo.name] = res;
+		}
+
+		for (const spirv_cross::Resource& ssbo : resources.storage_buffers) {
+			UBOShaderResource res;
+			res.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			res.set = compiler.get_decoration(ssbo.id, spv::DecorationDescriptorSet);
+			res.binding = compiler.get_decoration(ssbo.id, spv::DecorationBinding);
+			res.offset = 0;
+			res.size = 0;	// Storage buffers are runtime sized
+			res.count = 1;
+			res.flags = EShLanguageToVkStageFlags(stage);
+
+			binary.ubos[ssbo.name] = res;
+		}
+
+		for (const spirv_cross::Resource& pushConstant : resources.push_constant_buffers) {
+			for (spirv_cross::BufferRange& bufferRange : compiler.get_active_buffer_ranges(pushConstant.id)) {
+				std::string name = compiler.get_member_name(pushConstant.base_type_id, bufferRange.index);
+				if (binary.pushConstants.contains(name)) {
+					binary.pushConstants[name].flags |=  EShLanguageToVkStageFlags(stage);
+					continue;
+				}
+
+				PushConstantResource res;
+				res.offset = bufferRange.offset;
+				res.size = bufferRange.range;
+				res.flags = EShLanguageToVkStageFlags(stage);
+				binary.pushConstants[name] = res;
+			}
+		}
+		
+		for (const spirv_cross::Resource& sampled : resources.sampled_images) {
+			SampledImageShaderResources res;
+			res.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			res.set = compiler.get_decoration(sampled.id, spv::DecorationDescriptorSet);
+			res.binding = compiler.get_decoration(sampled.id, spv::DecorationBinding);
+			res.count = 1;
+			res.flags = EShLanguageToVkStageFlags(stage);
+		
+			binary.sampledImages[sampled.name] = res;
+		}
+
+		for (const spirv_cross::Resource& image : resources.separate_images) {
+			SampledImageShaderResources res;
+			res.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			res.set = compiler.get_decoration(image.id, spv::DecorationDescriptorSet);
+			res.binding = compiler.get_decoration(image.id, spv::DecorationBinding);
+			res.count = 1;
+			res.flags = EShLanguageToVkStageFlags(stage);
+		
+			binary.sampledImages[image.name] = res;
+		}
+
+		for (const spirv_cross::SpecializationConstant& constant : compiler.get_specialization_constants()) {
+			SpecializationConstantResource res;
+			res.constantID = constant.constant_id;
+			res.flags = EShLanguageToVkStageFlags(stage);
+
+			binary.specializationConstants[compiler.get_name(constant.id)] = res;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glslang/Public/ShaderLang.h>
+#include <spirv_cross/spirv_cross.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ThreadPool.hpp"
+
+namespace mist {
+	struct InputShaderResource {
+		uint32_t binding;
+		uint32_t location;
+		uint32_t offset;
+		uint32_t stride;
+		VkFormat format;
+		VkVertexInputRate inputRate;
+		VkShaderStageFlags flags;
+	};
+
+	struct UBOShaderResource {
+        VkDescriptorType type;
+        uint32_t set;
+        uint32_t binding;
+        uint32_t offset;
+        uint32_t size;
+        uint32_t count;
+        VkShaderStageFlags flags;
+    };
+
+	struct PushConstantResource {
+		uint32_t offset;
+		uint32_t size;
+		VkShaderStageFlags flags;
+	};
+
+	struct SampledImageShaderResources {
+		VkDescriptorType type;
+		uint32_t set;
+		uint32_t binding;
+		uint32_t count;
+		VkShaderStageFlags flags;
+	};
+
+	struct SpecializationConstantResource {
+		uint32_t constantID;
+		VkShaderStageFlags flags;
+	};
+
+	struct ShaderStageBinary {
+		VkShaderStageFlagBits stage;
+		std::vector<uint32_t> spirv;
+	};
+
+	// Everything a VulkanShader needs out of glslang and spirv-cross. Holds no device objects so it can be
+	// written to the cache and baked offline
+	struct ShaderBinary {
+		uint64_t hash = 0;
+		std::vector<ShaderStageBinary> stages;
+		std::unordered_map<std::string, InputShaderResource> inputs;
+		std::unordered_map<std::string, UBOShaderResource> ubos;
+		std::unordered_map<std::string, PushConstantResource> pushConstants;
+		std::unordered_map<std::string, SampledImageShaderResources> sampledImages;
+		std::unordered_map<std::string, SpecializationConstantResource> specializationConstants;
+		// Declared by the source's #keywords line rather than compiled so it is never cached
+		std::vector<std::string> keywords;
+	};
+
+	class VulkanShaderCompiler {
+	public:
+		// Reads the cached binary when its hash matches the source, otherwise compiles and rewrites the cache.
+		// Defines are glsl lines injected ahead of each stage's source
+		static bool LoadOrCompile(const std::string& path, const std::string& defines, ShaderBinary& binary);
+		// Loads every shader with each stage compiled as its own task on the pool, blocks until all are done.
+		// Failed shaders are left empty. Must not be called from a pool task, it waits on the pool
+		static std::vector<std::optional<ShaderBinary>> LoadOrCompileBatch(const std::vector<std::string>& paths, const std::string& defines, ThreadPool& threadPool);
+		static bool Compile(const std::unordered_map<EShLanguage, std::string>& sources, const std::string& defines, ShaderBinary& binary);
+		static std::unordered_map<EShLanguage, std::string> PreProcess(const std::string& src);
+		// Variant keywords from a "#keywords A B C" line ahead of the first #type, keyword i is bit i of a variant key
+		static std::vector<std::string> ParseKeywords(const std::string& src);
+
+		// FNV-1a over the source, defines, glslang version and cache format so a change to any of them misses
+		static uint64_t HashSource(const std::string& source, const std::string& defines);
+		// FNV-1a over the compiled words, identical binaries share one shader module
+		static uint64_t HashSpirv(const std::vector<uint32_t>& spirv);
+		// Kept in a cache folder beside the shader, variants with defines get their own file
+		static std::string GetCachePath(const std::string& path, const std::string& defines);
+		static bool ReadCache(const std::string& cachePath, const uint64_t hash, ShaderBinary& binary);
+		static bool WriteCache(const std::string& cachePath, const ShaderBinary& binary);
+	private:
+		static bool CompileStage(const std::string& src, const std::string& defines, EShLanguage stage, ShaderBinary& binary);
+		// Folds one stage's binary in, push constants shared between stages combine their stage flags
+		static void Merge(ShaderBinary& binary, ShaderBinary& stage);
+		static std::vector<uint32_t> ConvertGLSLToSPIRV(const std::string& src, const std::string& defines, EShLanguage stage);
+		static void Reflect(const std::vector<uint32_t>& spirv, EShLanguage stage, ShaderBinary& binary);
+		static uint32_t CalculateSize(const spirv_cross::Compiler& compiler, const spirv_cross::SPIRType& type);
+		static VkFormat GetDescriptionFormat(const spirv_cross::Compiler& compiler, const spirv_cross::SPIRType type);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,322 @@
+#include "renderer/vulkan/VulkanStagingRing.hpp"
+#include "renderer/vulkan/VulkanBuffer.hpp"
+#include "renderer/vulkan/VulkanContext.hpp"
+#include "renderer/vulkan/VulkanDebug.hpp"
+#include "Debug.hpp"
+#include "Log.hpp"
+#include <cstring>
+
+namespace mist {
+	static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+	static constexpr VkPipelineStageFlags UPLOAD_READ_STAGES = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	static constexpr VkAccessFlags UPLOAD_READ_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+	static VkSemaphore CreateTimeline() {
+		VulkanContext& context = VulkanContext::GetContext();
+
+		VkSemaphoreTypeCreateInfo typeInfo {};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo info {};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		info.pNext = &typeInfo;
+
+		VkSemaphore semaphore;
+		CheckVkResult(vkCreateSemaphore(context.GetDevice(), &info, context.GetAllocationCallbacks(), &semaphore));
+		return semaphore;
+	}
+
+	void VulkanStagingRing::Initialize(const VkDeviceSize size) {
+		VulkanContext& context = VulkanContext::GetContext();
+		ring.Reset(size);
+		timelineValue = 0;
+		dedicatedTransfer = context.HasDedicatedTransferQueue();
+
+		VmaAllocationInfo info {};
+		CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, buffer, alloc, VMA_MEMORY_USAGE_CPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, info);
+		mappedData = static_cast<uint8_t*>(info.pMappedData);
+
+		VkCommandPoolCreateInfo poolInfo {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		poolInfo.queueFamilyIndex = context.GetTransferQueueFamily();
+		CheckVkResult(vkCreateCommandPool(context.GetDevice(), &poolInfo, context.GetAllocationCallbacks(), &transferCommandPool));
+
+		slots.resize(context.MAX_FRAMES_IN_FLIGHT);
+		std::vector<VkCommandBuffer> commandBuffers(slots.size());
+
+		VkCommandBufferAllocateInfo allocInfo {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = transferCommandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+		CheckVkResult(vkAllocateCommandBuffers(context.GetDevice(), &allocInfo, commandBuffers.data()));
+
+		for (size_t i = 0; i < slots.size(); ++i)
+			slots[i].commandBuffer = commandBuffers[i];
+
+		transferTimeline = CreateTimeline();
+
+		if (dedicatedTransfer) {
+			allocInfo.commandPool = context.GetCommandPool();
+			CheckVkResult(vkAllocateCommandBuffers(context.GetDevice(), &allocInfo, commandBuffers.data()));
+
+			for (size_t i = 0; i < slots.size(); ++i)
+				slots[i].acquireCommandBuffer = commandBuffers[i];
+
+			acquireTimeline = CreateTimeline();
+		}
+
+		MIST_INFO("Created staging ring");
+	}
+
+	void VulkanStagingRing::Cleanup() {
+		VulkanContext& context = VulkanContext::GetContext();
+
+		for (UploadSlot& slot : slots) {
+			if (slot.submitted)
+				ReleaseSlot(slot);
+
+			for (std::pair<VkBuffer, VmaAllocation>& oversized : slot.oversizedBuffers)
+				vmaDestroyBuffer(context.GetAllocator(), oversized.first, oversized.second);
+		}
+		slots.clear();	// Acquire command buffers are freed with the context's command pool
+
+		if (transferCommandPool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(context.GetDevice(), transferCommandPool, context.GetAllocationCallbacks());
+			transferCommandPool = VK_NULL_HANDLE;
+		}
+
+		if (transferTimeline != VK_NULL_HANDLE) {
+			vkDestroySemaphore(context.GetDevice(), transferTimeline, context.GetAllocationCallbacks());
+			transferTimeline = VK_NULL_HANDLE;
+		}
+
+		if (acquireTimeline != VK_NULL_HANDLE) {
+			vkDestroySemaphore(context.GetDevice(), acquireTimeline, context.GetAllocationCallbacks());
+			acquireTimeline = VK_NULL_HANDLE;
+		}
+
+		if (buffer != VK_NULL_HANDLE) {
+			vmaDestroyBuffer(context.GetAllocator(), buffer, alloc);
+			buffer = VK_NULL_HANDLE;
+			mappedData = nullptr;
+		}
+
+		MIST_INFO("Destroyed staging ring");
+	}
+
+	void VulkanStagingRing::Upload(const uint32_t frameIndex, const void* data, const VkDeviceSize size, VkBuffer dst, const VkDeviceSize dstOffset) {
+		VulkanContext& context = VulkanContext::GetContext();
+		UploadSlot* slot = &BeginSlot(frameIndex);
+
+		VkBufferCopy copyRegion {};
+		copyRegion.dstOffset = dstOffset;
+		copyRegion.size = size;
+
+		// Too large to ever fit, give it its own staging buffer that lives until the slot is released
+		if (size > ring.GetCapacity() / 2) {
+			VkBuffer stagingBuffer;
+			VmaAllocation stagingAlloc;
+			VmaAllocationInfo info {};
+			CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingBuffer, stagingAlloc, VMA_MEMORY_USAGE_CPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, info);
+			memcpy(info.pMappedData, data, size);
+			vmaFlushAllocation(context.GetAllocator(), stagingAlloc, 0, size);
+
+			copyRegion.srcOffset = 0;
+			RecordCopy(*slot, stagingBuffer, dst, copyRegion);
+			slot->oversizedBuffers.push_back({ stagingBuffer, stagingAlloc });
+			return;
+		}
+
+		const VkDeviceSize alignedSize = (size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+		VkDeviceSize offset = ring.Allocate(alignedSize);
+		if (offset == RingAllocator::INVALID_OFFSET) {
+			// Every byte is still waiting on the GPU, drain it and start again from an empty ring
+			MIST_WARN("Staging ring full, waiting for uploads to finish");
+			Flush();
+			slot = &BeginSlot(frameIndex);
+			offset = ring.Allocate(alignedSize);
+			MIST_ASSERT(offset != RingAllocator::INVALID_OFFSET, "Staging ring allocation failed after flushing");
+		}
+
+		memcpy(mappedData + offset, data, size);
+		vmaFlushAllocation(context.GetAllocator(), alloc, offset, size);
+
+		copyRegion.srcOffset = offset;
+		RecordCopy(*slot, buffer, dst, copyRegion);
+	}
+
+	void VulkanStagingRing::Submit(const uint32_t frameIndex) {
+		UploadSlot& slot = slots[frameIndex];
+		if (!slot.recording)
+			return;
+
+		VulkanContext& context = VulkanContext::GetContext();
+
+		if (dedicatedTransfer) {
+			// Release half of the ownership transfer, the access masks only matter on the acquire side
+			for (VkBufferMemoryBarrier& barrier : slot.ownershipBarriers) {
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = 0;
+			}
+			vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, static_cast<uint32_t>(slot.ownershipBarriers.size()), slot.ownershipBarriers.data(), 0, nullptr);
+		} else {
+			// Same queue as the draws, make the copies visible to anything reading geometry or buffers later on it
+			VkMemoryBarrier barrier {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = UPLOAD_READ_ACCESS;
+			vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, UPLOAD_READ_STAGES, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+
+		CheckVkResult(vkEndCommandBuffer(slot.commandBuffer));
+
+		slot.timelineValue = ++timelineValue;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &slot.timelineValue;
+
+		VkSubmitInfo info {};
+		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		info.pNext = &timelineInfo;
+		info.commandBufferCount = 1;
+		info.pCommandBuffers = &slot.commandBuffer;
+		info.signalSemaphoreCount = 1;
+		info.pSignalSemaphores = &transferTimeline;
+
+		// The transfer queue is not ordered against the draws, so wait for every frame already submitted
+		// in case one still reads a range these copies overwrite
+		const VkSemaphore graphicsTimeline = context.GetGraphicsTimeline();
+		const uint64_t graphicsValue = context.GetSubmittedFrameNumber();
+		const VkPipelineStageFlags transferStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		if (dedicatedTransfer && graphicsValue > 0) {
+			timelineInfo.waitSemaphoreValueCount = 1;
+			timelineInfo.pWaitSemaphoreValues = &graphicsValue;
+			info.waitSemaphoreCount = 1;
+			info.pWaitSemaphores = &graphicsTimeline;
+			info.pWaitDstStageMask = &transferStage;
+		}
+		CheckVkResult(vkQueueSubmit(context.GetTransferQueue(), 1, &info, VK_NULL_HANDLE));
+
+		if (dedicatedTransfer) {
+			// Acquire half, waits for the copies then chains into every later read on the graphics queue
+			for (VkBufferMemoryBarrier& barrier : slot.ownershipBarriers) {
+				barrier.srcAccessMask = 0;
+				barrier.dstAccessMask = UPLOAD_READ_ACCESS;
+			}
+
+			CheckVkResult(vkResetCommandBuffer(slot.acquireCommandBuffer, 0));
+			VkCommandBufferBeginInfo beginInfo {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			CheckVkResult(vkBeginCommandBuffer(slot.acquireCommandBuffer, &beginInfo));
+			vkCmdPipelineBarrier(slot.acquireCommandBuffer, UPLOAD_READ_STAGES, UPLOAD_READ_STAGES, 0, 0, nullptr, static_cast<uint32_t>(slot.ownershipBarriers.size()), slot.ownershipBarriers.data(), 0, nullptr);
+			CheckVkResult(vkEndCommandBuffer(slot.acquireCommandBuffer));
+
+			timelineInfo.waitSemaphoreValueCount = 1;
+			timelineInfo.pWaitSemaphoreValues = &slot.timelineValue;
+
+			const VkPipelineStageFlags waitStage = UPLOAD_READ_STAGES;
+			info.waitSemaphoreCount = 1;
+			info.pWaitSemaphores = &transferTimeline;
+			info.pWaitDstStageMask = &waitStage;
+			info.pCommandBuffers = &slot.acquireCommandBuffer;
+			info.pSignalSemaphores = &acquireTimeline;
+			CheckVkResult(vkQueueSubmit(context.GetGraphicsQueue(), 1, &info, VK_NULL_HANDLE));
+		}
+
+		slot.ownershipBarriers.clear();
+		ring.Submit(slot.timelineValue);
+		slot.recording = false;
+		slot.submitted = true;
+	}
+
+	void VulkanStagingRing::Flush() {
+		for (uint32_t i = 0; i < slots.size(); ++i)
+			Submit(i);
+
+		// Values are handed out in submission order so reaching the newest covers every slot
+		WaitTimelines(timelineValue);
+
+		for (UploadSlot& slot : slots) {
+			if (slot.submitted)
+				ReleaseSlot(slot);
+		}
+
+		ring.Reset(ring.GetCapacity());
+	}
+
+	VulkanStagingRing::UploadSlot& VulkanStagingRing::BeginSlot(const uint32_t frameIndex) {
+		UploadSlot& slot = slots[frameIndex];
+		if (slot.recording)
+			return slot;
+
+		// Last used MAX_FRAMES_IN_FLIGHT frames ago, though a flush can leave other slots older than it
+		if (slot.submitted)
+			ReleaseSlot(slot);
+
+		CheckVkResult(vkResetCommandBuffer(slot.commandBuffer, 0));
+		VkCommandBufferBeginInfo info {};
+		info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		CheckVkResult(vkBeginCommandBuffer(slot.commandBuffer, &info));
+
+		// Same queue as the draws, submission order puts earlier frames in scope so an execution dependency
+		// keeps the copies from overwriting ranges they still read
+		if (!dedicatedTransfer)
+			vkCmdPipelineBarrier(slot.commandBuffer, UPLOAD_READ_STAGES, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+		slot.recording = true;
+		return slot;
+	}
+
+	void VulkanStagingRing::ReleaseSlot(UploadSlot& slot) {
+		VulkanContext& context = VulkanContext::GetContext();
+		WaitTimelines(slot.timelineValue);
+
+		for (std::pair<VkBuffer, VmaAllocation>& oversized : slot.oversizedBuffers)
+			vmaDestroyBuffer(context.GetAllocator(), oversized.first, oversized.second);
+		slot.oversizedBuffers.clear();
+
+		// Slots are released in whatever order they are reused, the ring only frees space in submission order
+		ring.Retire(slot.timelineValue);
+
+		slot.submitted = false;
+	}
+
+	void VulkanStagingRing::RecordCopy(UploadSlot& slot, VkBuffer src, VkBuffer dst, const VkBufferCopy& region) {
+		vkCmdCopyBuffer(slot.commandBuffer, src, dst, 1, &region);
+
+		if (!dedicatedTransfer)
+			return;
+
+		// Only the written range changes hands, the graphics family keeps the rest of the buffer
+		VulkanContext& context = VulkanContext::GetContext();
+		VkBufferMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = context.GetTransferQueueFamily();
+		barrier.dstQueueFamilyIndex = context.GetGraphicsQueueFamily();
+		barrier.buffer = dst;
+		barrier.offset = region.dstOffset;
+		barrier.size = region.size;
+		slot.ownershipBarriers.push_back(barrier);
+	}
+
+	void VulkanStagingRing::WaitTimelines(const uint64_t value) {
+		VulkanContext& context = VulkanContext::GetContext();
+		const VkSemaphore semaphores[] = { transferTimeline, acquireTimeline };
+		const uint64_t values[] = { value, value };
+
+		VkSemaphoreWaitInfo info {};
+		info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		info.semaphoreCount = dedicatedTransfer ? 2 : 1;
+		info.pSemaphores = semaphores;
+		info.pValues = values;
+		CheckVkResult(vkWaitSemaphores(context.GetDevice(), &info, UINT64_MAX));
+	}
+}
\ No newline at end of file
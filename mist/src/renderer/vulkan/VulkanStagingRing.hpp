@@ -0,0 +1,51 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+#include <vector>
+#include "renderer/RingAllocator.hpp"
+
+namespace mist {
+	// Persistently mapped staging memory used as a ring. Uploads are memcpy'd in and their copies recorded into
+	// one command buffer per frame in flight, which is submitted on the transfer queue ahead of that frame's draws.
+	// Every submit signals the next value of a timeline semaphore and ring space is reclaimed, oldest first, once it is reached.
+	// With a dedicated transfer family the written ranges are released to the graphics family and acquired by a
+	// small batch on the graphics queue, later graphics submits are ordered after it by the queue
+	class VulkanStagingRing {
+	public:
+		void Initialize(const VkDeviceSize size);
+		void Cleanup();
+
+		// Stages data and records a copy into dst on the upload command buffer of frameIndex
+		void Upload(const uint32_t frameIndex, const void* data, const VkDeviceSize size, VkBuffer dst, const VkDeviceSize dstOffset);
+		// Submits the uploads staged for frameIndex, must happen before the frame's own submit on the graphics queue
+		void Submit(const uint32_t frameIndex);
+		// Submits everything staged and blocks until all uploads have finished
+		void Flush();
+	private:
+		struct UploadSlot {
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;			// Transfer queue
+			VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;	// Graphics queue, only with a dedicated transfer family
+			uint64_t timelineValue = 0;	// Also the slot's submission in the ring
+			bool recording = false;
+			bool submitted = false;
+			std::vector<VkBufferMemoryBarrier> ownershipBarriers;	// Ranges written this slot that change queue family
+			std::vector<std::pair<VkBuffer, VmaAllocation>> oversizedBuffers;	// Uploads too large for the ring
+		};
+
+		UploadSlot& BeginSlot(const uint32_t frameIndex);
+		void ReleaseSlot(UploadSlot& slot);
+		void RecordCopy(UploadSlot& slot, VkBuffer src, VkBuffer dst, const VkBufferCopy& region);
+		void WaitTimelines(const uint64_t value);
+
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VmaAllocation alloc;
+		uint8_t* mappedData = nullptr;
+		RingAllocator ring;
+		std::vector<UploadSlot> slots;
+		VkCommandPool transferCommandPool = VK_NULL_HANDLE;
+		VkSemaphore transferTimeline = VK_NULL_HANDLE;
+		VkSemaphore acquireTimeline = VK_NULL_HANDLE;	// Signalled by the acquire batches on the graphics queue
+		uint64_t timelineValue = 0;
+		bool dedicatedTransfer = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <entt/entt.hpp>
+#include <components/Transform.hpp>
+#include <components/Rigidbody.hpp>
+#include <components/Collider.hpp>
+
+// Stand in for MeshRenderer, the real component uploads buffers on construction so needs a live renderer
+struct DrawStandIn {
+	uint32_t meshID;
+};
+
+static constexpr size_t ENTITY_COUNT = 100000;
+static constexpr size_t ITERATIONS = 50;
+
+template<typename Func>
+double MedianMilliseconds(Func&& func) {
+	std::vector<double> samples;
+	samples.reserve(ITERATIONS);
+
+	for (size_t i = 0; i < ITERATIONS; ++i) {
+		auto start = std::chrono::high_resolution_clock::now();
+		func();
+		auto end = std::chrono::high_resolution_clock::now();
+		samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+// Components are added in a shuffled order per type so the pools are not already aligned,
+// which is what a scene looks like after entities have been created and edited over time
+void Populate(entt::registry& registry) {
+	std::vector<entt::entity> entities(ENTITY_COUNT);
+	registry.create(entities.begin(), entities.end());
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	for (entt::entity entity : entities)
+		registry.emplace<mist::Transform>(entity, glm::vec3(position(rng), position(rng), position(rng)));
+
+	std::shuffle(entities.begin(), entities.end(), rng);
+	for (size_t i = 0; i < entities.size(); ++i) {
+		if (i % 4 != 0)
+			registry.emplace<DrawStandIn>(entities[i], static_cast<uint32_t>(i));
+	}
+
+	std::shuffle(entities.begin(), entities.end(), rng);
+	for (size_t i = 0; i < entities.size(); i += 2) {
+		registry.emplace<mist::Rigidbody>(entities[i], 1.0f, 0.1f, glm::vec3(1, 0, 0));
+		registry.emplace<mist::Collider>(entities[i], mist::Collider { mist::SphereCollider(0.5f) });
+	}
+}
+
+int main() {
+	entt::registry viewScene;
+	Populate(viewScene);
+
+	// Same layout as SceneManager::GetRenderGroup and SceneManager::GetPhysicsGroup
+	entt::registry groupScene;
+	groupScene.group<mist::Transform, DrawStandIn>();
+	groupScene.group<mist::Rigidbody, mist::Collider>(entt::get<mist::Transform>);
+	Populate(groupScene);
+
+	glm::mat4 sink(0.0f);
+
+	double renderView = MedianMilliseconds([&]() {
+		viewScene.view<mist::Transform, DrawStandIn>().each([&sink](mist::Transform& transform, DrawStandIn& draw) {
+			sink += transform.GetLocalToWorldMatrix();
+		});
+	});
+
+	double renderGroup = MedianMilliseconds([&]() {
+		groupScene.group<mist::Transform, DrawStandIn>().each([&sink](mist::Transform& transform, DrawStandIn& draw) {
+			sink += transform.GetLocalToWorldMatrix();
+		});
+	});
+
+	struct ColliderEntry {
+		entt::entity entity;
+		const mist::Transform* transform;
+		const mist::Collider* collider;
+	};
+	std::vector<ColliderEntry> colliders;
+	colliders.reserve(ENTITY_COUNT);
+
+	double physicsView = MedianMilliseconds([&]() {
+		colliders.clear();
+		auto colliderView = viewScene.view<mist::Transform, mist::Rigidbody, mist::Collider>();
+		for (entt::entity entity : colliderView) {
+			auto [transform, rigidbody, collider] = colliderView.get<mist::Transform, mist::Rigidbody, mist::Collider>(entity);
+			transform.position += rigidbody.velocity * 0.016f;
+			colliders.push_back({ entity, &transform, &collider });
+		}
+	});
+
+	double physicsGroup = MedianMilliseconds([&]() {
+		colliders.clear();
+		groupScene.group<mist::Rigidbody, mist::Collider>(entt::get<mist::Transform>).each([&colliders](entt::entity entity, mist::Rigidbody& rigidbody, mist::Collider& collider, mist::Transform& transform) {
+			transform.position += rigidbody.velocity * 0.016f;
+			colliders.push_back({ entity, &transform, &collider });
+		});
+	});
+
+	std::printf("Entities: %zu, median of %zu runs\n", ENTITY_COUNT, ITERATIONS);
+	std::printf("Render loop   view %8.3f ms  group %8.3f ms  speedup %.2fx\n", renderView, renderGroup, renderView / renderGroup);
+	std::printf("Physics loop  view %8.3f ms  group %8.3f ms  speedup %.2fx\n", physicsView, physicsGroup, physicsView / physicsGroup);
+	std::printf("(ignore) %f %zu\n", sink[0][0], colliders.size());
+	return 0;
+}
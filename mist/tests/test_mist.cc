@@ -1,5 +1,13 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <SceneManager.hpp>
 #include <physics/Physics.hpp>
+#include <physics/SpatialHashGrid.hpp>
+#include <renderer/Frustum.hpp>
+#include <renderer/DrawList.hpp>
+#include <renderer/RangeAllocator.hpp>
+#include <renderer/RingAllocator.hpp>
+#include <renderer/RenderGraph.hpp>
 
 TEST(MistTest, collisionDetectionTest) {
 	mist::Physics physics;
@@ -183,4 +191,310 @@ TEST(MistTest, collisionDetectionTest) {
 		mist::IntersectData data = physics.DetectCollision(transformA, colliderA, transformB, colliderB);
 		EXPECT_FALSE(data.isIntersecting);
 	}
+}
+
+TEST(MistTest, spatialHashGridTest) {
+	mist::SpatialHashGrid grid(2.0f);
+	const entt::entity a = static_cast<entt::entity>(0);
+	const entt::entity b = static_cast<entt::entity>(1);
+	const entt::entity c = static_cast<entt::entity>(2);
+	grid.Insert(a, glm::vec3(0, 0, 0));
+	grid.Insert(b, glm::vec3(3, 0, 0));
+	grid.Insert(c, glm::vec3(-10, 0, 0));
+
+	{
+		std::vector<entt::entity> results;
+		grid.QueryRadius(glm::vec3(0, 0, 0), 4.0f, results);
+		EXPECT_EQ(results.size(), 2);
+	}
+
+	{
+		std::vector<entt::entity> results;
+		grid.QueryAABB(glm::vec3(-11, -1, -1), glm::vec3(1, 1, 1), results);
+		EXPECT_EQ(results.size(), 2);
+	}
+
+	{
+		std::vector<entt::entity> results;
+		grid.QueryKNearest(glm::vec3(-8, 0, 0), 2, results);
+		ASSERT_EQ(results.size(), 2);
+		EXPECT_EQ(results[0], c);
+		EXPECT_EQ(results[1], a);
+	}
+
+	// Moving across cells and removing should be reflected in later queries
+	grid.Update(c, glm::vec3(1, 0, 0));
+	grid.Remove(b);
+
+	{
+		std::vector<entt::entity> results;
+		grid.QueryRadius(glm::vec3(0, 0, 0), 4.0f, results);
+		EXPECT_EQ(results.size(), 2);
+		EXPECT_EQ(std::count(results.begin(), results.end(), b), 0);
+		EXPECT_EQ(std::count(results.begin(), results.end(), c), 1);
+	}
+
+	// Coordinates past the int32 range are clamped into the edge cells rather than wrapping
+	{
+		const entt::entity far = static_cast<entt::entity>(3);
+		grid.Insert(far, glm::vec3(1e30f, 0, 0));
+
+		std::vector<entt::entity> results;
+		grid.QueryRadius(glm::vec3(0, 0, 0), 1e31f, results);
+		EXPECT_EQ(results.size(), 3);
+
+		results.clear();
+		grid.QueryAABB(glm::vec3(1e29f, -1, -1), glm::vec3(1e31f, 1, 1), results);
+		ASSERT_EQ(results.size(), 1);
+		EXPECT_EQ(results[0], far);
+	}
+}
+
+TEST(MistTest, prefabInstantiateTest) {
+	mist::SceneManager sceneManager;
+	sceneManager.LoadEmptyScene();
+
+	const entt::entity root = sceneManager.CreateEntity();
+	sceneManager.AddComponent<mist::Transform>(root, glm::vec3(1, 0, 0));
+	sceneManager.AddComponent<mist::Rigidbody>(root, 2.0f);
+	const entt::entity child = sceneManager.CreateEntity();
+	sceneManager.AddComponent<mist::Transform>(child, glm::vec3(1, 2, 0));
+	sceneManager.AddComponent<mist::Collider>(child, mist::Collider { mist::SphereCollider(0.5f) });
+
+	mist::Ref<mist::Prefab> prefab = sceneManager.CreatePrefab({ root, child });
+	ASSERT_EQ(prefab->entities.size(), 2);
+
+	// Each instance is turned a quarter around z and doubled in size, so the child's (0, 2, 0) offset becomes (-4, 0, 0)
+	const size_t count = 3;
+	std::vector<mist::Transform> transforms;
+	for (size_t j = 0; j < count; ++j)
+		transforms.emplace_back(glm::vec3(10.0f * j, 0, 0), glm::angleAxis(glm::radians(90.0f), glm::vec3(0, 0, 1)), glm::vec3(2));
+
+	const std::vector<entt::entity> entities = sceneManager.Instantiate(*prefab, count, transforms);
+	ASSERT_EQ(entities.size(), prefab->entities.size() * count);
+
+	entt::registry& scene = sceneManager.GetActiveScene();
+	for (size_t j = 0; j < count; ++j) {
+		const entt::entity instanceRoot = entities[0 * count + j];
+		const entt::entity instanceChild = entities[1 * count + j];
+
+		const mist::Transform& rootTransform = scene.get<mist::Transform>(instanceRoot);
+		EXPECT_NEAR(glm::distance(rootTransform.position, transforms[j].position), 0.0f, 1e-4f);
+		EXPECT_NEAR(glm::distance(rootTransform.scale, glm::vec3(2)), 0.0f, 1e-4f);
+
+		const mist::Transform& childTransform = scene.get<mist::Transform>(instanceChild);
+		EXPECT_NEAR(glm::distance(childTransform.position, transforms[j].position + glm::vec3(-4, 0, 0)), 0.0f, 1e-4f);
+		EXPECT_NEAR(glm::distance(childTransform.scale, glm::vec3(2)), 0.0f, 1e-4f);
+
+		// Components are copied onto the matching prefab entity only
+		ASSERT_TRUE(scene.all_of<mist::Rigidbody>(instanceRoot));
+		EXPECT_FLOAT_EQ(scene.get<mist::Rigidbody>(instanceRoot).mass, 2.0f);
+		EXPECT_FALSE(scene.any_of<mist::Collider>(instanceRoot));
+
+		ASSERT_TRUE(scene.all_of<mist::Collider>(instanceChild));
+		EXPECT_FLOAT_EQ(std::get<mist::SphereCollider>(scene.get<mist::Collider>(instanceChild).data).radius, 0.5f);
+		EXPECT_FALSE(scene.any_of<mist::Rigidbody>(instanceChild));
+	}
+
+	sceneManager.Cleanup();
+}
+
+TEST(MistTest, frustumCullingTest) {
+	glm::mat4 projection = glm::perspectiveLH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAtLH(glm::vec3(0, 0, 0), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0));
+	mist::Frustum frustum(projection * view);
+
+	EXPECT_TRUE(frustum.IntersectsSphere(glm::vec3(0, 0, 10), 1.0f));
+	EXPECT_FALSE(frustum.IntersectsSphere(glm::vec3(0, 0, -10), 1.0f));		// Behind
+	EXPECT_FALSE(frustum.IntersectsSphere(glm::vec3(0, 0, 200), 1.0f));		// Past far plane
+	EXPECT_TRUE(frustum.IntersectsSphere(glm::vec3(0, 0, 100.5f), 1.0f));	// Straddling far plane
+	EXPECT_FALSE(frustum.IntersectsSphere(glm::vec3(100, 0, 10), 1.0f));	// Off to the side
+
+	EXPECT_TRUE(frustum.IntersectsAABB(glm::vec3(-1, -1, 5), glm::vec3(1, 1, 6)));
+	EXPECT_FALSE(frustum.IntersectsAABB(glm::vec3(-1, -1, -6), glm::vec3(1, 1, -5)));
+
+	mist::BoundingSphereBatch batch;
+	batch.Add(glm::vec3(0, 0, 10), 1.0f);
+	batch.Add(glm::vec3(0, 0, -10), 1.0f);
+	batch.Add(glm::vec3(100, 0, 10), 1.0f);
+	batch.Add(glm::vec3(2, 1, 20), 0.5f);
+
+	std::vector<uint8_t> visible;
+	EXPECT_EQ(frustum.CullSpheres(batch, visible), 2);
+	ASSERT_EQ(visible.size(), 4);
+	EXPECT_EQ(visible[0], 1);
+	EXPECT_EQ(visible[1], 0);
+	EXPECT_EQ(visible[2], 0);
+	EXPECT_EQ(visible[3], 1);
+}
+
+TEST(MistTest, drawListSortTest) {
+	const uint64_t key = mist::DrawList::MakeKey(7, 1234, 2.5f);
+	EXPECT_EQ(mist::DrawList::GetPipeline(key), 7);
+	EXPECT_EQ(mist::DrawList::GetMesh(key), 1234);
+	EXPECT_LT(mist::DrawList::MakeKey(0, 0, 1.0f), mist::DrawList::MakeKey(0, 0, 2.0f));
+	EXPECT_LT(mist::DrawList::MakeKey(0, 5, 100.0f), mist::DrawList::MakeKey(1, 0, 0.0f));
+
+	mist::DrawList drawList;
+	std::vector<uint64_t> expected;
+	for (uint32_t i = 0; i < 1000; ++i) {
+		const uint64_t itemKey = mist::DrawList::MakeKey((i * 7) % 3, (i * 13) % 50, static_cast<float>((i * 31) % 100));
+		drawList.Add(itemKey, i);
+		expected.push_back(itemKey);
+	}
+
+	drawList.Sort();
+	std::sort(expected.begin(), expected.end());
+
+	ASSERT_EQ(drawList.Size(), expected.size());
+	for (size_t i = 0; i < expected.size(); ++i) {
+		EXPECT_EQ(drawList.GetKey(i), expected[i]);
+		// Stable so equal keys keep the order they were added in
+		if (i > 0 && drawList.GetKey(i) == drawList.GetKey(i - 1))
+			EXPECT_LT(drawList.GetIndex(i - 1), drawList.GetIndex(i));
+	}
+}
+
+TEST(MistTest, rangeAllocatorTest) {
+	mist::RangeAllocator allocator(100);
+	const uint32_t a = allocator.Allocate(30);
+	const uint32_t b = allocator.Allocate(30);
+	const uint32_t c = allocator.Allocate(30);
+	EXPECT_EQ(a, 0);
+	EXPECT_EQ(b, 30);
+	EXPECT_EQ(c, 60);
+	EXPECT_EQ(allocator.Allocate(20), mist::RangeAllocator::INVALID_OFFSET);
+
+	// Freed neighbours merge back into one block
+	allocator.Free(b, 30);
+	EXPECT_EQ(allocator.GetFreeBlockCount(), 2);
+	allocator.Free(a, 30);
+	EXPECT_EQ(allocator.GetFreeBlockCount(), 2);
+	allocator.Free(c, 30);
+	EXPECT_EQ(allocator.GetFreeBlockCount(), 1);
+	EXPECT_EQ(allocator.GetUsed(), 0);
+
+	// Growing keeps existing offsets and extends the trailing free block
+	EXPECT_EQ(allocator.Allocate(90), 0);
+	allocator.Grow(150);
+	EXPECT_EQ(allocator.GetFreeBlockCount(), 1);
+	EXPECT_EQ(allocator.Allocate(60), 90);
+	EXPECT_EQ(allocator.GetUsed(), 150);
+}
+
+TEST(MistTest, ringAllocatorTest) {
+	mist::RingAllocator ring(256);
+	for (uint64_t value = 1; value <= 3; value++) {
+		EXPECT_EQ(ring.Allocate(64), (value - 1) * 64);
+		ring.Submit(value);
+	}
+
+	// Submissions complete out of order, the older one retiring late must not free the newer one's space
+	ring.Retire(2);
+	ring.Retire(1);
+	EXPECT_EQ(ring.GetPendingCount(), 1);
+
+	// [128, 192) still belongs to submission 3
+	std::vector<uint64_t> offsets;
+	for (uint64_t offset = ring.Allocate(64); offset != mist::RingAllocator::INVALID_OFFSET; offset = ring.Allocate(64))
+		offsets.push_back(offset);
+
+	EXPECT_EQ(offsets, (std::vector<uint64_t>{ 192, 0 }));
+	for (const uint64_t offset : offsets)
+		EXPECT_TRUE(offset + 64 <= 128 || offset >= 192);
+
+	ring.Submit(4);
+	ring.Retire(3);
+	EXPECT_EQ(ring.Allocate(64), 64);
+	ring.Retire(4);
+	EXPECT_EQ(ring.GetPendingCount(), 0);
+}
+
+class TestRenderData : public mist::RenderData {
+public:
+	TestRenderData() : RenderData(0) {
+		framebufferProperties.attachments = { mist::FramebufferTextureFormat::RGBA8 };
+	}
+
+	virtual void Resize(const uint32_t width, const uint32_t height) override {}
+};
+
+class TestRenderGraph : public mist::RenderGraph {
+public:
+	virtual void Execute() override { Compile(); }
+protected:
+	virtual void OnCompile() override {}
+};
+
+TEST(MistTest, renderGraphTest) {
+	TestRenderGraph graph;
+	const mist::RenderGraphTexture shadow = graph.CreateTexture("Shadow", { 64, 64, mist::FramebufferTextureFormat::DEPTH32 });
+	const mist::RenderGraphTexture depth = graph.CreateTexture("Depth", { 64, 64, mist::FramebufferTextureFormat::DEPTH32 });
+	const mist::RenderGraphTexture bloom = graph.CreateTexture("Bloom", { 64, 64, mist::FramebufferTextureFormat::RGBA8 });
+	const mist::RenderGraphTexture unused = graph.CreateTexture("Unused", { 64, 64, mist::FramebufferTextureFormat::RGBA8 });
+	const mist::RenderGraphTexture scene = graph.CreateTexture("Scene", { 64, 64, mist::FramebufferTextureFormat::RGBA8 });
+	const mist::RenderGraphTexture output = graph.ImportRenderData("Output", mist::CreateRef<TestRenderData>());
+
+	const uint32_t shadowPass = graph.AddPass("Shadow").WriteDepth(shadow).GetIndex();
+	const uint32_t unusedPass = graph.AddPass("Unused").WriteColor(unused).GetIndex();
+	const uint32_t prepass = graph.AddPass("DepthPrepass").WriteDepth(depth).GetIndex();
+	const uint32_t mainPass = graph.AddPass("Main").Read(shadow).WriteDepth(depth, false).WriteColor(scene).GetIndex();
+	const uint32_t bloomPass = graph.AddPass("Bloom").Read(scene).WriteColor(bloom).GetIndex();
+	const uint32_t compositePass = graph.AddPass("Composite").Read(scene).Read(bloom).WriteColor(output).GetIndex();
+	const uint32_t timestampPass = graph.AddPass("Timestamp").HasSideEffects().GetIndex();
+	const uint32_t emptyPass = graph.AddPass("Empty").GetIndex();
+	graph.Execute();
+
+	// Nothing reads what the unused pass writes and the empty pass writes nothing, every other pass feeds the
+	// imported output or has side effects
+	EXPECT_TRUE(graph.IsPassCulled(unusedPass));
+	EXPECT_TRUE(graph.IsPassCulled(emptyPass));
+	EXPECT_FALSE(graph.IsPassCulled(timestampPass));
+	EXPECT_FALSE(graph.IsPassCulled(shadowPass));
+	EXPECT_FALSE(graph.IsPassCulled(prepass));
+	EXPECT_FALSE(graph.IsPassCulled(mainPass));
+	EXPECT_FALSE(graph.IsPassCulled(bloomPass));
+	EXPECT_FALSE(graph.IsPassCulled(compositePass));
+	EXPECT_TRUE(graph.GetPassBarriers(unusedPass).empty());
+
+	const std::vector<mist::RenderGraphBarrier>& mainBarriers = graph.GetPassBarriers(mainPass);
+	ASSERT_EQ(mainBarriers.size(), 3);
+	EXPECT_EQ(mainBarriers[0].texture, shadow);
+	EXPECT_EQ(mainBarriers[0].before, mist::RenderGraphAccess::DepthAttachment);
+	EXPECT_EQ(mainBarriers[0].after, mist::RenderGraphAccess::ShaderRead);
+	EXPECT_EQ(mainBarriers[1].texture, depth);
+	EXPECT_EQ(mainBarriers[1].before, mist::RenderGraphAccess::DepthAttachment);
+	EXPECT_EQ(mainBarriers[2].texture, scene);
+	EXPECT_EQ(mainBarriers[2].before, mist::RenderGraphAccess::None);
+
+	// Bloom already moved the scene to a read, so overlapping reads leave only bloom and the output to transition
+	const std::vector<mist::RenderGraphBarrier>& compositeBarriers = graph.GetPassBarriers(compositePass);
+	ASSERT_EQ(compositeBarriers.size(), 2);
+	EXPECT_EQ(compositeBarriers[0].texture, bloom);
+	EXPECT_EQ(compositeBarriers[0].before, mist::RenderGraphAccess::ColorAttachment);
+	EXPECT_EQ(compositeBarriers[1].texture, output);
+	EXPECT_EQ(compositeBarriers[1].before, mist::RenderGraphAccess::None);
+	EXPECT_TRUE(graph.GetPassBarriers(timestampPass).empty());
+
+	// Bloom starts after shadow and depth are last used so it takes the block that already fits it
+	std::vector<mist::RenderGraphMemoryRequirements> requirements(6);
+	requirements[shadow] = { 100, 1 };
+	requirements[depth] = { 200, 1 };
+	requirements[scene] = { 150, 1 };
+	requirements[bloom] = { 150, 1 };
+	mist::RenderGraphAliasing aliasing = graph.AssignAliases(requirements);
+	ASSERT_EQ(aliasing.blocks.size(), 3);
+	EXPECT_EQ(aliasing.textureBlocks[shadow], 0);
+	EXPECT_EQ(aliasing.textureBlocks[depth], 1);
+	EXPECT_EQ(aliasing.textureBlocks[scene], 2);
+	EXPECT_EQ(aliasing.textureBlocks[bloom], 1);
+	EXPECT_EQ(aliasing.blocks[1].size, 200);
+	EXPECT_EQ(aliasing.textureBlocks[unused], mist::RenderGraphAliasing::INVALID_BLOCK);
+	EXPECT_EQ(aliasing.textureBlocks[output], mist::RenderGraphAliasing::INVALID_BLOCK);
+
+	// Textures only alias memory both of them can live in
+	requirements[bloom].compatibleMask = 2;
+	aliasing = graph.AssignAliases(requirements);
+	EXPECT_EQ(aliasing.blocks.size(), 4);
+	EXPECT_EQ(aliasing.textureBlocks[bloom], 3);
 }
\ No newline at end of file
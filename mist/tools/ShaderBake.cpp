@@ -0,0 +1,46 @@
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "renderer/vulkan/VulkanShaderCompiler.hpp"
+#include "ThreadPool.hpp"
+#include "Log.hpp"
+
+// Bakes the shader cache ahead of time so shipping builds never run glslang or spirv-cross at startup.
+// Takes any mix of shader files and folders, folders are searched for .glsl files
+int main(int argc, char** argv) {
+	mist::Log::Init();
+
+	if (argc < 2) {
+		MIST_ERROR("Usage: mist_shaderbake <shader file or folder>...");
+		return 1;
+	}
+
+	std::vector<std::string> paths;
+	for (int i = 1; i < argc; ++i) {
+		const std::filesystem::path path(argv[i]);
+		if (!std::filesystem::is_directory(path)) {
+			paths.push_back(path.string());
+			continue;
+		}
+
+		for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(path)) {
+			if (entry.is_regular_file() && entry.path().extension() == ".glsl")
+				paths.push_back(entry.path().string());
+		}
+	}
+
+	mist::ThreadPool threadPool;
+	const std::vector<std::optional<mist::ShaderBinary>> binaries = mist::VulkanShaderCompiler::LoadOrCompileBatch(paths, "", threadPool);
+
+	int failed = 0;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		if (binaries[i].has_value()) {
+			MIST_INFO("Baked shader cache for: {0}", paths[i]);
+		} else {
+			MIST_ERROR("Failed to bake shader: {0}", paths[i]);
+			++failed;
+		}
+	}
+
+	return failed == 0 ? 0 : 1;
+}
\ No newline at end of file